@@ -0,0 +1,1016 @@
+// Suite di benchmark headless per i percorsi di rasterizzazione di CobraGL.
+//
+// Non richiede SDL: lavora direttamente su una cobra_surface.
+// Tutti i dati di input sono generati con un PRNG a seme fisso, quindi ogni
+// esecuzione misura esattamente lo stesso lavoro.
+//
+// Output: CSV su stdout (una riga per benchmark), pensato per essere confrontato
+// tra release diverse per individuare regressioni.
+//   benchmark,ops,ns_per_op,lines_per_s,mpixels_per_s
+//
+// Uso: ./bin/bench [filtro]   (esegue solo i benchmark il cui nome contiene 'filtro')
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "cobragl/math.h"
+#include "cobragl/surface.h"
+#include "cobragl/mesh.h"
+
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define BENCH_SEED 0xC0B2A61u
+#define BENCH_SEGMENTS 4096
+// Tempo minimo di misura per ogni benchmark (ns)
+#define BENCH_MIN_NS 200000000ull
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// --- PRNG deterministico (xorshift32) ---
+static uint32_t rng_state = BENCH_SEED;
+
+static void rng_seed(uint32_t seed) { rng_state = seed ? seed : BENCH_SEED; }
+
+static uint32_t rng_next(void)
+{
+  uint32_t x = rng_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  rng_state = x;
+  return x;
+}
+
+// Float uniforme in [lo, hi)
+static float rng_range(float lo, float hi)
+{
+  return lo + (hi - lo) * (float)(rng_next() >> 8) * (1.0f / 16777216.0f);
+}
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Evita che il compilatore elimini calcoli il cui risultato non viene usato
+static volatile float bench_sink;
+
+static const char *bench_filter = NULL;
+
+static bool bench_enabled(const char *name)
+{
+  return !bench_filter || strstr(name, bench_filter) != NULL;
+}
+
+static void bench_report(const char *name, uint64_t ops, uint64_t ns, double pixels, bool is_line)
+{
+  double sec = (double)ns * 1e-9;
+  double ns_per_op = ops ? (double)ns / (double)ops : 0.0;
+  double lines_per_s = (is_line && sec > 0.0) ? (double)ops / sec : 0.0;
+  double mpix_per_s = (sec > 0.0) ? pixels / sec * 1e-6 : 0.0;
+  printf("%s,%llu,%.3f,%.1f,%.3f\n", name, (unsigned long long)ops, ns_per_op, lines_per_s, mpix_per_s);
+  fflush(stdout);
+}
+
+// --- Generazione segmenti ---
+
+typedef enum {
+  CLIP_INSIDE,  // Entrambi gli estremi dentro lo schermo
+  CLIP_PARTIAL, // Un estremo dentro, uno fuori
+  CLIP_OUTSIDE  // Completamente fuori (trivial reject o quasi)
+} clip_case;
+
+typedef enum {
+  SLOPE_ANY,
+  SLOPE_HORIZONTAL,
+  SLOPE_VERTICAL,
+  SLOPE_DIAGONAL
+} slope_case;
+
+typedef struct {
+  float x0[BENCH_SEGMENTS], y0[BENCH_SEGMENTS];
+  float x1[BENCH_SEGMENTS], y1[BENCH_SEGMENTS];
+  // Lunghezza visibile (dopo clipping allo schermo) usata per stimare i pixel
+  float visible_len[BENCH_SEGMENTS];
+  float visible_major[BENCH_SEGMENTS];
+} segment_set;
+
+static segment_set segs;
+
+// Liang-Barsky: frazione del segmento contenuta nel rettangolo [0,w)x[0,h)
+static float visible_fraction(float x0, float y0, float x1, float y1, float w, float h)
+{
+  float t0 = 0.0f, t1 = 1.0f;
+  float dx = x1 - x0, dy = y1 - y0;
+  float p[4] = {-dx, dx, -dy, dy};
+  float q[4] = {x0, w - x0, y0, h - y0};
+  for (int i = 0; i < 4; i++) {
+    if (p[i] == 0.0f) {
+      if (q[i] < 0.0f) return 0.0f;
+      continue;
+    }
+    float r = q[i] / p[i];
+    if (p[i] < 0.0f) { if (r > t1) return 0.0f; if (r > t0) t0 = r; }
+    else             { if (r < t0) return 0.0f; if (r < t1) t1 = r; }
+  }
+  return t1 - t0;
+}
+
+static void generate_segments(float length, slope_case slope, clip_case clip)
+{
+  const float w = (float)BENCH_WIDTH, h = (float)BENCH_HEIGHT;
+  for (int i = 0; i < BENCH_SEGMENTS; i++) {
+    float angle;
+    switch (slope) {
+      case SLOPE_HORIZONTAL: angle = 0.0f; break;
+      case SLOPE_VERTICAL:   angle = (float)M_PI * 0.5f; break;
+      case SLOPE_DIAGONAL:   angle = (float)M_PI * 0.25f; break;
+      default:               angle = rng_range(0.0f, 2.0f * (float)M_PI); break;
+    }
+    float ux = cosf(angle), uy = sinf(angle);
+    float x0, y0;
+
+    if (clip == CLIP_INSIDE) {
+      // Scegliamo l'origine in modo che tutto il segmento resti dentro
+      float mx = fabsf(ux) * length + 4.0f, my = fabsf(uy) * length + 4.0f;
+      x0 = rng_range(mx, w - mx);
+      y0 = rng_range(my, h - my);
+    } else if (clip == CLIP_PARTIAL) {
+      // Punto medio sul bordo sinistro/destro: metà segmento è fuori
+      x0 = (rng_next() & 1) ? 0.0f : w;
+      y0 = rng_range(0.0f, h);
+      x0 -= ux * length * 0.5f;
+      y0 -= uy * length * 0.5f;
+    } else {
+      // Completamente sopra lo schermo
+      x0 = rng_range(0.0f, w);
+      y0 = -length - 64.0f;
+    }
+
+    segs.x0[i] = x0;
+    segs.y0[i] = y0;
+    segs.x1[i] = x0 + ux * length;
+    segs.y1[i] = y0 + uy * length;
+
+    float frac = visible_fraction(segs.x0[i], segs.y0[i], segs.x1[i], segs.y1[i], w, h);
+    segs.visible_len[i] = frac * length;
+    float major = fabsf(ux) > fabsf(uy) ? fabsf(ux) : fabsf(uy);
+    segs.visible_major[i] = frac * length * major;
+  }
+}
+
+// --- Benchmark: linee ---
+
+static const char *clip_name(clip_case c)
+{
+  return c == CLIP_INSIDE ? "inside" : (c == CLIP_PARTIAL ? "partial" : "outside");
+}
+
+static const char *slope_name(slope_case s)
+{
+  switch (s) {
+    case SLOPE_HORIZONTAL: return "horiz";
+    case SLOPE_VERTICAL:   return "vert";
+    case SLOPE_DIAGONAL:   return "diag";
+    default:               return "any";
+  }
+}
+
+static void bench_line(cobra_surface *surf, float length, slope_case slope, clip_case clip)
+{
+  char name[128];
+  snprintf(name, sizeof(name), "line/len%.0f/%s/%s", length, slope_name(slope), clip_name(clip));
+  if (!bench_enabled(name)) return;
+
+  rng_seed(BENCH_SEED);
+  generate_segments(length, slope, clip);
+
+  double pixels_per_pass = 0.0;
+  for (int i = 0; i < BENCH_SEGMENTS; i++)
+    pixels_per_pass += (segs.visible_len[i] > 0.0f) ? segs.visible_major[i] + 1.0f : 0.0f;
+
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    for (int i = 0; i < BENCH_SEGMENTS; i++) {
+      cobra_window_draw_line(surf, (int)segs.x0[i], (int)segs.y0[i], (int)segs.x1[i], (int)segs.y1[i],
+                             0xFF000000u | (rng_next() & 0xFFFFFFu));
+    }
+    ops += BENCH_SEGMENTS;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  bench_report(name, ops, elapsed, pixels_per_pass * (double)(ops / BENCH_SEGMENTS), true);
+}
+
+static const char *aa_name(cobra_aa_mode aa)
+{
+  switch (aa) {
+  case COBRA_AA_SS:  return "ss";
+  case COBRA_AA_LUT: return "lut";
+  case COBRA_AA_BOX: return "box";
+  default:           return "sdf";
+  }
+}
+
+// tiled: stessa misura con il framebuffer nel layout a tile (cobra_surface_set_tiled)
+static void bench_line_aa(cobra_surface *surf, float length, float width, slope_case slope, clip_case clip,
+                          cobra_aa_mode aa, bool tiled)
+{
+  char name[128];
+  snprintf(name, sizeof(name), "line_aa_%s%s/w%.2f/len%.0f/%s/%s", aa_name(aa), tiled ? "_tiled" : "",
+           width, length, slope_name(slope), clip_name(clip));
+  if (!bench_enabled(name)) return;
+  if (tiled && !cobra_surface_set_tiled(surf, true)) return;
+
+  rng_seed(BENCH_SEED);
+  generate_segments(length, slope, clip);
+
+  // Pixel coperti stimati: area della capsula visibile (rettangolo + cap tondi)
+  float radius = (width < 1.0f ? 1.0f : width) * 0.5f;
+  double pixels_per_pass = 0.0;
+  for (int i = 0; i < BENCH_SEGMENTS; i++) {
+    if (segs.visible_len[i] > 0.0f)
+      pixels_per_pass += segs.visible_len[i] * 2.0f * radius + (float)M_PI * radius * radius;
+  }
+
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    for (int i = 0; i < BENCH_SEGMENTS; i++) {
+      cobra_window_draw_line_aa(surf, segs.x0[i], segs.y0[i], segs.x1[i], segs.y1[i], width,
+                                0xFF000000u | (rng_next() & 0xFFFFFFu), aa);
+    }
+    ops += BENCH_SEGMENTS;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  cobra_surface_set_tiled(surf, false);
+  bench_report(name, ops, elapsed, pixels_per_pass * (double)(ops / BENCH_SEGMENTS), true);
+}
+
+// Linee SDF (64px, spessore 3) con le varie modalità di blending e colori con alpha reale
+static void bench_line_aa_blend(cobra_surface *surf, const char *name, cobra_blend_mode mode, uint32_t alpha)
+{
+  if (!bench_enabled(name)) return;
+
+  rng_seed(BENCH_SEED);
+  generate_segments(64.0f, SLOPE_ANY, CLIP_INSIDE);
+
+  double pixels_per_pass = 0.0;
+  for (int i = 0; i < BENCH_SEGMENTS; i++)
+    pixels_per_pass += segs.visible_len[i] * 3.0f + (float)M_PI * 1.5f * 1.5f;
+
+  cobra_surface_set_blend_mode(surf, mode);
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    for (int i = 0; i < BENCH_SEGMENTS; i++) {
+      cobra_window_draw_line_aa(surf, segs.x0[i], segs.y0[i], segs.x1[i], segs.y1[i], 3.0f,
+                                (alpha << 24) | (rng_next() & 0xFFFFFFu), COBRA_AA_SDF);
+    }
+    ops += BENCH_SEGMENTS;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+  cobra_surface_set_blend_mode(surf, COBRA_BLEND_OVER);
+
+  bench_report(name, ops, elapsed, pixels_per_pass * (double)(ops / BENCH_SEGMENTS), true);
+}
+
+// Reticolo di linee orizzontali e verticali a tutto schermo (griglie, graticole), a coordinate
+// frazionarie: con width < 1 è il caso tipico del percorso per linee sottili
+static void bench_line_aa_grid(cobra_surface *surf, float width)
+{
+  char name[128];
+  snprintf(name, sizeof(name), "line_aa_grid/w%.2f", width);
+  if (!bench_enabled(name)) return;
+
+  const int rows = 48, cols = 64;
+  const float w = (float)BENCH_WIDTH, h = (float)BENCH_HEIGHT;
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    for (int i = 0; i < rows; i++) {
+      float y = (i + 0.37f) * h / rows;
+      cobra_window_draw_line_aa(surf, 0.0f, y, w - 1.0f, y, width, 0xFF40C040u, COBRA_AA_SDF);
+    }
+    for (int i = 0; i < cols; i++) {
+      float x = (i + 0.61f) * w / cols;
+      cobra_window_draw_line_aa(surf, x, 0.0f, x, h - 1.0f, width, 0xFF40C040u, COBRA_AA_SDF);
+    }
+    ops += rows + cols;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  double pixels_per_pass = (double)rows * w + (double)cols * h;
+  bench_report(name, ops, elapsed, pixels_per_pass * (double)(ops / (rows + cols)), true);
+}
+
+// Stesse linee di bench_line_aa, inviate con l'API batch SoA
+static void bench_lines_aa_batch(cobra_surface *surf, float length, float width, cobra_aa_mode aa)
+{
+  char name[128];
+  snprintf(name, sizeof(name), "lines_aa_batch_%s/w%.2f/len%.0f", aa_name(aa), width, length);
+  if (!bench_enabled(name)) return;
+
+  rng_seed(BENCH_SEED);
+  generate_segments(length, SLOPE_ANY, CLIP_INSIDE);
+
+  static float widths[BENCH_SEGMENTS];
+  static uint32_t colors[BENCH_SEGMENTS];
+  float radius = (width < 1.0f ? 1.0f : width) * 0.5f;
+  double pixels_per_pass = 0.0;
+  for (int i = 0; i < BENCH_SEGMENTS; i++) {
+    widths[i] = width;
+    colors[i] = 0xFF000000u | (rng_next() & 0xFFFFFFu);
+    pixels_per_pass += segs.visible_len[i] * 2.0f * radius + (float)M_PI * radius * radius;
+  }
+
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    cobra_window_draw_lines_aa(surf, segs.x0, segs.y0, segs.x1, segs.y1, widths, colors, BENCH_SEGMENTS, aa);
+    ops += BENCH_SEGMENTS;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  bench_report(name, ops, elapsed, pixels_per_pass * (double)(ops / BENCH_SEGMENTS), true);
+}
+
+// Linee 3D casuali davanti (e in parte dietro) la camera: chiamate singole o batch
+static void bench_lines_3d(cobra_surface *surf, bool batch)
+{
+  const char *name = batch ? "lines_3d/batch" : "lines_3d/single";
+  if (!bench_enabled(name)) return;
+
+  static float p[6][BENCH_SEGMENTS];
+  static float widths[BENCH_SEGMENTS];
+  static uint32_t colors[BENCH_SEGMENTS];
+  rng_seed(BENCH_SEED);
+  for (int i = 0; i < BENCH_SEGMENTS; i++) {
+    p[0][i] = rng_range(-10.0f, 10.0f); p[1][i] = rng_range(-6.0f, 6.0f); p[2][i] = rng_range(-2.0f, 40.0f);
+    p[3][i] = p[0][i] + rng_range(-1.0f, 1.0f);
+    p[4][i] = p[1][i] + rng_range(-1.0f, 1.0f);
+    p[5][i] = p[2][i] + rng_range(-1.0f, 1.0f);
+    widths[i] = 1.5f;
+    colors[i] = 0xFF000000u | (rng_next() & 0xFFFFFFu);
+  }
+
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    if (batch) {
+      cobra_window_draw_lines_3d(surf, p[0], p[1], p[2], p[3], p[4], p[5], 800.0f,
+                                 widths, colors, BENCH_SEGMENTS, true, COBRA_AA_SDF);
+    } else {
+      for (int i = 0; i < BENCH_SEGMENTS; i++) {
+        cobra_vec3 a = {{p[0][i], p[1][i], p[2][i]}};
+        cobra_vec3 b = {{p[3][i], p[4][i], p[5][i]}};
+        cobra_window_draw_line_3d(surf, a, b, 800.0f, widths[i], colors[i], true, COBRA_AA_SDF);
+      }
+    }
+    ops += BENCH_SEGMENTS;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  bench_report(name, ops, elapsed, 0.0, true);
+}
+
+// Grafico di telemetria: polilinea di BENCH_POLY_VERTS punti (random walk) su tutta la
+// larghezza, tracciata come percorso unico o con una cobra_window_draw_line_aa per segmento
+#define BENCH_POLY_VERTS 100000
+static void bench_polyline(cobra_surface *surf, float width, bool per_segment)
+{
+  char name[128];
+  snprintf(name, sizeof(name), "polyline/w%.2f/%s", width, per_segment ? "segments" : "path");
+  if (!bench_enabled(name)) return;
+
+  static float px[BENCH_POLY_VERTS], py[BENCH_POLY_VERTS];
+  rng_seed(BENCH_SEED);
+  float y = BENCH_HEIGHT * 0.5f;
+  for (int i = 0; i < BENCH_POLY_VERTS; i++) {
+    y += rng_range(-6.0f, 6.0f);
+    if (y < 20.0f) y = 20.0f;
+    if (y > BENCH_HEIGHT - 20.0f) y = BENCH_HEIGHT - 20.0f;
+    px[i] = (float)i * (BENCH_WIDTH - 1) / (BENCH_POLY_VERTS - 1);
+    py[i] = y;
+  }
+
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    if (per_segment) {
+      for (int i = 0; i + 1 < BENCH_POLY_VERTS; i++)
+        cobra_window_draw_line_aa(surf, px[i], py[i], px[i + 1], py[i + 1], width, 0xC040C0F0u, COBRA_AA_SDF);
+    } else {
+      cobra_window_draw_polyline_aa(surf, px, py, BENCH_POLY_VERTS, width, 0xC040C0F0u,
+                                    COBRA_JOIN_MITER, COBRA_AA_SDF);
+    }
+    ops += BENCH_POLY_VERTS - 1;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  bench_report(name, ops, elapsed, 0.0, true);
+}
+
+// Nuvola di BENCH_POINTS punti tipo lidar (anello attorno al sensore: circa metà alle spalle
+// della camera) con cobra_window_draw_points_3d, o trasformati, proiettati e disegnati uno per
+// chiamata con cobra_vec3_project e cobra_window_draw_point
+#define BENCH_POINTS 262144
+static void bench_points(cobra_surface *surf, const char *name, cobra_point_mode mode, float radius,
+                         bool depth, bool per_point)
+{
+  if (!bench_enabled(name)) return;
+
+  static float px[BENCH_POINTS], py[BENCH_POINTS], pz[BENCH_POINTS];
+  static uint32_t colors[BENCH_POINTS];
+  rng_seed(BENCH_SEED);
+  for (int i = 0; i < BENCH_POINTS; i++) {
+    float a = rng_range(0.0f, 6.2831853f), d = rng_range(2.0f, 60.0f);
+    px[i] = cosf(a) * d;
+    py[i] = rng_range(-2.0f, 4.0f);
+    pz[i] = sinf(a) * d;
+    colors[i] = 0xFF000000u | (rng_next() & 0xFFFFFFu);
+  }
+  const float fov = 800.0f;
+  cobra_mat4 model_view = cobra_mat4_mul(cobra_mat4_translate((cobra_vec3){{0.0f, -1.5f, 0.0f}}),
+                                         cobra_mat4_rotate_y(0.3f));
+
+  cobra_window_clear(surf, 0xFF000000u);
+  if (depth)
+    cobra_surface_set_depth_test(surf, COBRA_DEPTH_LESS, true);
+
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    if (per_point) {
+      for (int i = 0; i < BENCH_POINTS; i++) {
+        cobra_vec3 v = cobra_mat4_transform_point(model_view, (cobra_vec3){{px[i], py[i], pz[i]}});
+        if (v.z < 0.5f)
+          continue;
+        cobra_vec3 s = cobra_vec3_project(v, fov, BENCH_WIDTH, BENCH_HEIGHT);
+        if (s.x >= 0.0f && s.y >= 0.0f && s.x < BENCH_WIDTH && s.y < BENCH_HEIGHT)
+          cobra_window_draw_point(surf, (int)s.x, (int)s.y, colors[i]);
+      }
+    } else {
+      cobra_window_draw_points_3d(surf, px, py, pz, BENCH_POINTS, &model_view, fov, colors, 0, radius, mode);
+    }
+    ops += BENCH_POINTS;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  cobra_surface_set_depth_test(surf, COBRA_DEPTH_ALWAYS, false);
+  bench_report(name, ops, elapsed, 0.0, false);
+}
+
+// Griglia wireframe 64x64 (4225 vertici, 8320 spigoli): mesh indicizzata contro
+// una chiamata cobra_window_draw_line_3d per spigolo (stessa matrice model-view)
+#define BENCH_GRID 64
+// offscreen = true sposta la griglia fuori dal frustum (culling dell'intera mesh)
+// Triangoli pieni di lato circa 'size' pixel, in spazio camera a z = 10 (fov 1000: 1 unità = 100 px)
+static void bench_triangles(cobra_surface *surf, const char *name, float size, bool depth)
+{
+  if (!bench_enabled(name)) return;
+
+  enum { N = BENCH_SEGMENTS };
+  static cobra_vec3 v[N][3];
+  const float fov = 1000.0f, z = 10.0f;
+  double area = 0.0;
+  rng_seed(BENCH_SEED);
+  for (int i = 0; i < N; i++) {
+    float cx = rng_range(size * 0.5f, BENCH_WIDTH - size * 0.5f) - BENCH_WIDTH * 0.5f;
+    float cy = rng_range(size * 0.5f, BENCH_HEIGHT - size * 0.5f) - BENCH_HEIGHT * 0.5f;
+    float sx[3], sy[3];
+    for (int k = 0; k < 3; k++) {
+      sx[k] = cx + rng_range(-0.5f, 0.5f) * size;
+      sy[k] = cy + rng_range(-0.5f, 0.5f) * size;
+      v[i][k] = (cobra_vec3){{sx[k] * z / fov, -sy[k] * z / fov, z + rng_range(0.0f, 1.0f)}};
+    }
+    area += fabs((sx[1] - sx[0]) * (sy[2] - sy[0]) - (sy[1] - sy[0]) * (sx[2] - sx[0])) * 0.5;
+  }
+
+  cobra_window_clear(surf, 0xFF000000u);
+  if (depth)
+    cobra_surface_set_depth_test(surf, COBRA_DEPTH_LEQUAL, true);
+
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  double pixels = 0.0;
+  do {
+    for (int i = 0; i < N; i++)
+      cobra_window_draw_triangle(surf, v[i][0], v[i][1], v[i][2], fov, 0xFF000000u | (uint32_t)(i * 2654435761u >> 8));
+    ops += N;
+    pixels += area;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  cobra_surface_set_depth_test(surf, COBRA_DEPTH_ALWAYS, false);
+  bench_report(name, ops, elapsed, pixels, false);
+}
+
+// Facce piene della griglia di bench_mesh, con test di profondità
+// Griglia BENCH_GRID x BENCH_GRID ondulata (20x20 unità), con quad divisi in triangoli
+static void build_grid_mesh(cobra_mesh *mesh)
+{
+  cobra_mesh_init(mesh);
+  for (int y = 0; y <= BENCH_GRID; y++) {
+    for (int x = 0; x <= BENCH_GRID; x++) {
+      float fx = (float)x / BENCH_GRID * 20.0f - 10.0f;
+      float fy = (float)y / BENCH_GRID * 20.0f - 10.0f;
+      cobra_mesh_add_vertex(mesh, (cobra_vec3){{fx, fy, sinf(fx * 0.7f) * cosf(fy * 0.5f)}});
+    }
+  }
+  for (int y = 0; y < BENCH_GRID; y++) {
+    for (int x = 0; x < BENCH_GRID; x++) {
+      int v = y * (BENCH_GRID + 1) + x;
+      int quad[4] = {v, v + 1, v + BENCH_GRID + 2, v + BENCH_GRID + 1};
+      cobra_mesh_add_polygon(mesh, quad, 4);
+    }
+  }
+}
+
+static void bench_mesh_filled(cobra_surface *surf)
+{
+  const char *name = "mesh/grid64_filled_depth";
+  if (!bench_enabled(name)) return;
+
+  cobra_mesh mesh;
+  build_grid_mesh(&mesh);
+
+  cobra_mat4 mv = cobra_mat4_mul(cobra_mat4_translate((cobra_vec3){{0.0f, 0.0f, 30.0f}}),
+                                 cobra_mat4_mul(cobra_mat4_rotate_x(-0.9f), cobra_mat4_rotate_z(0.3f)));
+
+  cobra_window_clear(surf, 0xFF000000u);
+  cobra_surface_set_depth_test(surf, COBRA_DEPTH_LEQUAL, true);
+
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    cobra_window_draw_mesh_filled(surf, &mesh, &mv, 800.0f, NULL, 0xFF808080u);
+    ops += (uint64_t)mesh.triangle_count;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  cobra_surface_set_depth_test(surf, COBRA_DEPTH_ALWAYS, false);
+  cobra_mesh_destroy(&mesh);
+  bench_report(name, ops, elapsed, 0.0, false);
+}
+
+// Un frame con un muro vicino che copre lo schermo e 16 mesh piene dietro di esso.
+// Senza Hi-Z ogni mesh viene trasformata e ogni pixel passa il test di profondità (fallendo);
+// con Hi-Z le mesh vengono scartate dal loro AABB. ops = frame.
+static void bench_mesh_occluded(cobra_surface *surf, bool hiz)
+{
+  const char *name = hiz ? "mesh/occluded_frame_hiz" : "mesh/occluded_frame";
+  if (!bench_enabled(name)) return;
+
+  cobra_mesh mesh;
+  build_grid_mesh(&mesh);
+  cobra_mat4 mv[16];
+  for (int i = 0; i < 16; i++) {
+    float x = (float)(i % 4) * 24.0f - 36.0f, y = (float)(i / 4) * 24.0f - 36.0f;
+    mv[i] = cobra_mat4_mul(cobra_mat4_translate((cobra_vec3){{x, y, 60.0f}}), cobra_mat4_rotate_x(-0.5f));
+  }
+  const cobra_vec3 wall[4] = {{{-40.0f, -30.0f, 5.0f}}, {{40.0f, -30.0f, 5.0f}},
+                              {{40.0f, 30.0f, 5.0f}}, {{-40.0f, 30.0f, 5.0f}}};
+
+  if (hiz)
+    cobra_surface_enable_hiz(surf);
+  cobra_window_clear(surf, 0xFF000000u);
+  cobra_surface_set_depth_test(surf, COBRA_DEPTH_LESS, true);
+
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    cobra_window_clear_depth(surf, 1.0f);
+    cobra_window_draw_triangle(surf, wall[0], wall[1], wall[2], 800.0f, 0xFF404040u);
+    cobra_window_draw_triangle(surf, wall[0], wall[2], wall[3], 800.0f, 0xFF404040u);
+    for (int i = 0; i < 16; i++)
+      cobra_window_draw_mesh_filled(surf, &mesh, &mv[i], 800.0f, NULL, 0xFF808080u);
+    ops++;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  cobra_surface_set_depth_test(surf, COBRA_DEPTH_ALWAYS, false);
+  cobra_surface_disable_hiz(surf);
+  cobra_mesh_destroy(&mesh);
+  bench_report(name, ops, elapsed, 0.0, false);
+}
+
+// depth: test LEQUAL con scrittura, così ogni iterazione ripassa il test senza clear dello z_buffer
+static void bench_mesh(cobra_surface *surf, bool per_edge, bool offscreen, bool depth)
+{
+  const char *name = offscreen ? (per_edge ? "mesh/grid64_offscreen_line_3d_per_edge" : "mesh/grid64_offscreen_indexed")
+                               : (per_edge ? "mesh/grid64_line_3d_per_edge"
+                                           : (depth ? "mesh/grid64_indexed_depth" : "mesh/grid64_indexed"));
+  if (!bench_enabled(name)) return;
+
+  cobra_mesh mesh;
+  cobra_mesh_init(&mesh);
+  for (int y = 0; y <= BENCH_GRID; y++) {
+    for (int x = 0; x <= BENCH_GRID; x++) {
+      float fx = (float)x / BENCH_GRID * 20.0f - 10.0f;
+      float fy = (float)y / BENCH_GRID * 20.0f - 10.0f;
+      cobra_mesh_add_vertex(&mesh, (cobra_vec3){{fx, fy, sinf(fx * 0.7f) * cosf(fy * 0.5f)}});
+    }
+  }
+  for (int y = 0; y < BENCH_GRID; y++) {
+    for (int x = 0; x < BENCH_GRID; x++) {
+      int v = y * (BENCH_GRID + 1) + x;
+      int quad[4] = {v, v + 1, v + BENCH_GRID + 2, v + BENCH_GRID + 1};
+      cobra_mesh_add_polygon(&mesh, quad, 4);
+    }
+  }
+
+  cobra_mat4 mv = cobra_mat4_mul(cobra_mat4_translate((cobra_vec3){{offscreen ? 120.0f : 0.0f, 0.0f, 60.0f}}),
+                                 cobra_mat4_mul(cobra_mat4_rotate_x(-0.9f), cobra_mat4_rotate_z(0.3f)));
+
+  if (depth) {
+    cobra_window_clear_depth(surf, 1.0f);
+    cobra_surface_set_depth_test(surf, COBRA_DEPTH_LEQUAL, true);
+  }
+
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    if (per_edge) {
+      for (int e = 0; e < mesh.edge_count; e++) {
+        int a = mesh.edges[2 * e], b = mesh.edges[2 * e + 1];
+        cobra_vec3 pa = cobra_mat4_transform_point(mv, (cobra_vec3){{mesh.x[a], mesh.y[a], mesh.z[a]}});
+        cobra_vec3 pb = cobra_mat4_transform_point(mv, (cobra_vec3){{mesh.x[b], mesh.y[b], mesh.z[b]}});
+        cobra_window_draw_line_3d(surf, pa, pb, 800.0f, 1.0f, 0xFFFFFFFFu, true, COBRA_AA_SDF);
+      }
+    } else {
+      cobra_window_draw_mesh(surf, &mesh, &mv, 800.0f, 1.0f, 0xFFFFFFFFu, true, COBRA_AA_SDF);
+    }
+    ops += (uint64_t)mesh.edge_count;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  cobra_surface_set_depth_test(surf, COBRA_DEPTH_ALWAYS, false);
+  cobra_mesh_destroy(&mesh);
+  bench_report(name, ops, elapsed, 0.0, true);
+}
+
+// Macro-benchmark: frame di linee AA spesse in modalità differita con N thread.
+// num_threads < 0 = modalità immediata (riferimento).
+static void bench_line_aa_deferred(cobra_surface *surf, int num_threads)
+{
+  char name[128];
+  if (num_threads < 0)
+    snprintf(name, sizeof(name), "frame_aa/immediate");
+  else
+    snprintf(name, sizeof(name), "frame_aa/deferred_t%d", num_threads);
+  if (!bench_enabled(name)) return;
+
+  rng_seed(BENCH_SEED);
+  generate_segments(64.0f, SLOPE_ANY, CLIP_INSIDE);
+
+  const float width = 4.0f;
+  double pixels_per_pass = 0.0;
+  for (int i = 0; i < BENCH_SEGMENTS; i++)
+    pixels_per_pass += segs.visible_len[i] * width + (float)M_PI * width * width * 0.25f;
+
+  if (num_threads >= 0 && !cobra_surface_enable_deferred(surf, num_threads))
+    return;
+
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    for (int i = 0; i < BENCH_SEGMENTS; i++) {
+      cobra_window_draw_line_aa(surf, segs.x0[i], segs.y0[i], segs.x1[i], segs.y1[i], width,
+                                0xFF000000u | (rng_next() & 0xFFFFFFu), COBRA_AA_SDF);
+    }
+    cobra_surface_flush(surf);
+    ops += BENCH_SEGMENTS;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  cobra_surface_disable_deferred(surf);
+  bench_report(name, ops, elapsed, pixels_per_pass * (double)(ops / BENCH_SEGMENTS), true);
+}
+
+// --- Benchmark: clear e copia di presentazione ---
+
+typedef enum { CLEAR_BOTH, CLEAR_COLOR, CLEAR_DEPTH, CLEAR_DIRTY } clear_kind;
+
+static void bench_clear(cobra_surface *surf, const char *name, clear_kind kind)
+{
+  if (!bench_enabled(name)) return;
+
+  // Per il clear limitato disegniamo ogni frame poche linee in una piccola zona (dashboard)
+  rng_seed(BENCH_SEED);
+  generate_segments(32.0f, SLOPE_ANY, CLIP_INSIDE);
+  cobra_surface_set_clear_dirty_only(surf, kind == CLEAR_DIRTY);
+  cobra_window_clear(surf, 0xFF000000u);
+
+  double pixels = 0.0;
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    switch (kind) {
+      case CLEAR_BOTH:  cobra_window_clear(surf, 0xFF000000u); break;
+      case CLEAR_COLOR: cobra_window_clear_color(surf, 0xFF000000u); break;
+      case CLEAR_DEPTH: cobra_window_clear_depth(surf, 1.0f); break;
+      case CLEAR_DIRTY: {
+        int i = (int)(ops % BENCH_SEGMENTS);
+        float ox = 100.0f - segs.x0[i], oy = 100.0f - segs.y0[i];
+        cobra_window_draw_line_aa(surf, segs.x0[i] + ox, segs.y0[i] + oy, segs.x1[i] + ox, segs.y1[i] + oy,
+                                  2.0f, 0xFFFFFFFFu, COBRA_AA_SDF);
+        cobra_rect d = surf->dirty_color;
+        pixels += (double)(d.x1 - d.x0) * (d.y1 - d.y0);
+        cobra_window_clear(surf, 0xFF000000u);
+        break;
+      }
+    }
+    ops++;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  cobra_surface_set_clear_dirty_only(surf, false);
+  if (kind != CLEAR_DIRTY)
+    pixels = (double)surf->width * surf->height * (double)ops;
+  bench_report(name, ops, elapsed, pixels, false);
+}
+
+// Riproduce la copia che cobra_window_present esegue tramite SDL_UpdateTexture:
+// il color buffer viene copiato riga per riga in una texture con il proprio pitch.
+// Con damage_only copiamo solo i rettangoli modificati (surface.damage) dopo aver
+// disegnato poche linee in una zona dello schermo, come in una dashboard quasi statica.
+static void bench_present_copy(cobra_surface *surf, bool damage_only)
+{
+  const char *name = damage_only ? "present_copy_damage" : "present_copy";
+  if (!bench_enabled(name)) return;
+
+  int row_bytes = surf->width * (int)sizeof(uint32_t);
+  int pitch = (row_bytes + 63) & ~63;
+  unsigned char *texture = (unsigned char *)malloc((size_t)pitch * surf->height);
+  if (!texture) return;
+
+  rng_seed(BENCH_SEED);
+  generate_segments(32.0f, SLOPE_ANY, CLIP_INSIDE);
+  cobra_window_clear(surf, 0xFF000000u);
+
+  double pixels = 0.0;
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    cobra_rect full = {0, 0, surf->width, surf->height};
+    const cobra_rect *rects = &full;
+    int count = 1;
+
+    if (damage_only) {
+      int i = (int)(ops % BENCH_SEGMENTS);
+      float ox = 200.0f - segs.x0[i], oy = 150.0f - segs.y0[i];
+      cobra_window_draw_line_aa(surf, segs.x0[i] + ox, segs.y0[i] + oy, segs.x1[i] + ox, segs.y1[i] + oy,
+                                2.0f, 0xFFFFFFFFu, COBRA_AA_SDF);
+      rects = surf->damage;
+      count = surf->damage_count;
+    }
+
+    const unsigned char *src = (const unsigned char *)surf->color_buffer;
+    for (int r = 0; r < count; r++) {
+      size_t x_bytes = (size_t)rects[r].x0 * sizeof(uint32_t);
+      size_t w_bytes = (size_t)(rects[r].x1 - rects[r].x0) * sizeof(uint32_t);
+      for (int y = rects[r].y0; y < rects[r].y1; y++)
+        memcpy(texture + (size_t)y * pitch + x_bytes, src + (size_t)y * row_bytes + x_bytes, w_bytes);
+      pixels += (double)(rects[r].x1 - rects[r].x0) * (rects[r].y1 - rects[r].y0);
+    }
+    surf->damage_count = 0;
+
+    ops++;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  bench_sink = (float)texture[pitch + 1];
+  free(texture);
+  bench_report(name, ops, elapsed, pixels, false);
+}
+
+// Detile dell'intero frame in un buffer lineare (il lavoro aggiunto al present dal layout a tile)
+static void bench_present_detile(cobra_surface *surf)
+{
+  const char *name = "present_detile";
+  if (!bench_enabled(name)) return;
+  if (!cobra_surface_set_tiled(surf, true)) return;
+
+  uint32_t *texture = (uint32_t *)malloc(sizeof(uint32_t) * surf->width * surf->height);
+  if (!texture) {
+    cobra_surface_set_tiled(surf, false);
+    return;
+  }
+
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    cobra_surface_read_color(surf, NULL, texture, surf->width);
+    ops++;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  bench_sink = (float)texture[surf->width + 1];
+  free(texture);
+  cobra_surface_set_tiled(surf, false);
+  bench_report(name, ops, elapsed, (double)surf->width * surf->height * (double)ops, false);
+}
+
+// --- Benchmark: trasformazioni vettoriali ---
+
+#define BENCH_VERTS 4096
+static cobra_vec3 verts[BENCH_VERTS];
+
+static void generate_vertices(void)
+{
+  rng_seed(BENCH_SEED);
+  for (int i = 0; i < BENCH_VERTS; i++) {
+    verts[i].x = rng_range(-10.0f, 10.0f);
+    verts[i].y = rng_range(-10.0f, 10.0f);
+    verts[i].z = rng_range(1.0f, 50.0f);
+  }
+}
+
+typedef enum { XF_ROTATE_X, XF_ROTATE_Y, XF_ROTATE_Z, XF_ROTATE_XYZ, XF_PROJECT, XF_NORMALIZE } xform_kind;
+
+static void bench_vec3(const char *name, xform_kind kind)
+{
+  if (!bench_enabled(name)) return;
+  generate_vertices();
+
+  float acc = 0.0f;
+  float angle = 0.3f;
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    for (int i = 0; i < BENCH_VERTS; i++) {
+      cobra_vec3 v = verts[i];
+      switch (kind) {
+        case XF_ROTATE_X: v = cobra_vec3_rotate_x(v, angle); break;
+        case XF_ROTATE_Y: v = cobra_vec3_rotate_y(v, angle); break;
+        case XF_ROTATE_Z: v = cobra_vec3_rotate_z(v, angle); break;
+        case XF_ROTATE_XYZ:
+          v = cobra_vec3_rotate_x(v, angle);
+          v = cobra_vec3_rotate_y(v, angle * 0.5f);
+          v = cobra_vec3_rotate_z(v, angle * 0.2f);
+          break;
+        case XF_PROJECT:
+          v = cobra_vec3_project(v, 800.0f, (float)BENCH_WIDTH, (float)BENCH_HEIGHT);
+          break;
+        case XF_NORMALIZE: v = cobra_vec3_normalize(v); break;
+      }
+      acc += v.x + v.y + v.z;
+    }
+    angle += 0.001f;
+    ops += BENCH_VERTS;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  bench_sink = acc;
+  bench_report(name, ops, elapsed, 0.0, false);
+}
+
+// Stessa rotazione XYZ di XF_ROTATE_XYZ, con una matrice per passata applicata a vertici SoA
+static void bench_transform_points(const char *name, bool per_vertex_mat4)
+{
+  if (!bench_enabled(name)) return;
+  generate_vertices();
+
+  static float xs[BENCH_VERTS], ys[BENCH_VERTS], zs[BENCH_VERTS];
+  static float ox[BENCH_VERTS], oy[BENCH_VERTS], oz[BENCH_VERTS];
+  for (int i = 0; i < BENCH_VERTS; i++) {
+    xs[i] = verts[i].x;
+    ys[i] = verts[i].y;
+    zs[i] = verts[i].z;
+  }
+
+  float acc = 0.0f;
+  float angle = 0.3f;
+  uint64_t ops = 0, start = now_ns(), elapsed = 0;
+  do {
+    cobra_mat4 m = cobra_mat4_mul(cobra_mat4_rotate_z(angle * 0.2f),
+                   cobra_mat4_mul(cobra_mat4_rotate_y(angle * 0.5f), cobra_mat4_rotate_x(angle)));
+    if (per_vertex_mat4) {
+      // Matrice precalcolata ma vertici AoS trasformati uno alla volta
+      for (int i = 0; i < BENCH_VERTS; i++) {
+        cobra_vec3 v = cobra_mat4_transform_point(m, verts[i]);
+        ox[i] = v.x; oy[i] = v.y; oz[i] = v.z;
+      }
+    } else {
+      cobra_transform_points(&m, xs, ys, zs, ox, oy, oz, NULL, BENCH_VERTS);
+    }
+    acc += ox[ops % BENCH_VERTS] + oy[0] + oz[BENCH_VERTS - 1];
+    angle += 0.001f;
+    ops += BENCH_VERTS;
+    elapsed = now_ns() - start;
+  } while (elapsed < BENCH_MIN_NS);
+
+  bench_sink = acc;
+  bench_report(name, ops, elapsed, 0.0, false);
+}
+
+int main(int argc, char **argv)
+{
+  if (argc > 1)
+    bench_filter = argv[1];
+
+  cobra_surface surf;
+  if (!cobra_surface_create(&surf, BENCH_WIDTH, BENCH_HEIGHT)) {
+    fprintf(stderr, "Impossibile creare la superficie di benchmark.\n");
+    return 1;
+  }
+  cobra_window_clear(&surf, 0xFF000000u);
+
+  printf("benchmark,ops,ns_per_op,lines_per_s,mpixels_per_s\n");
+
+  // Framebuffer
+  bench_clear(&surf, "clear", CLEAR_BOTH);
+  bench_clear(&surf, "clear_color", CLEAR_COLOR);
+  bench_clear(&surf, "clear_depth", CLEAR_DEPTH);
+  bench_clear(&surf, "clear_dirty", CLEAR_DIRTY);
+  bench_present_copy(&surf, false);
+  bench_present_copy(&surf, true);
+  bench_present_detile(&surf);
+
+  // Bresenham: lunghezze, pendenze e situazioni di clipping
+  static const float lengths[] = {8.0f, 64.0f, 512.0f};
+  static const slope_case slopes[] = {SLOPE_ANY, SLOPE_HORIZONTAL, SLOPE_VERTICAL, SLOPE_DIAGONAL};
+  static const clip_case clips[] = {CLIP_INSIDE, CLIP_PARTIAL, CLIP_OUTSIDE};
+  static const float widths[] = {0.5f, 1.0f, 3.0f, 8.0f, 24.0f};
+
+  for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+    for (size_t s = 0; s < sizeof(slopes) / sizeof(slopes[0]); s++)
+      bench_line(&surf, lengths[l], slopes[s], CLIP_INSIDE);
+  for (size_t c = 1; c < sizeof(clips) / sizeof(clips[0]); c++)
+    bench_line(&surf, 512.0f, SLOPE_ANY, clips[c]);
+
+  // Linee AA: SDF, supersampling, tabella e filtro box, a vari spessori
+  static const cobra_aa_mode aa_modes[] = {COBRA_AA_SDF, COBRA_AA_SS, COBRA_AA_LUT, COBRA_AA_BOX};
+  for (size_t m = 0; m < sizeof(aa_modes) / sizeof(aa_modes[0]); m++) {
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++)
+      for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+        bench_line_aa(&surf, lengths[l], widths[w], SLOPE_ANY, CLIP_INSIDE, aa_modes[m], false);
+    for (size_t s = 1; s < sizeof(slopes) / sizeof(slopes[0]); s++)
+      bench_line_aa(&surf, 64.0f, 3.0f, slopes[s], CLIP_INSIDE, aa_modes[m], false);
+    for (size_t c = 1; c < sizeof(clips) / sizeof(clips[0]); c++)
+      bench_line_aa(&surf, 512.0f, 3.0f, SLOPE_ANY, clips[c], aa_modes[m], false);
+  }
+
+  // Layout lineare e a tile per direzione e spessore: le linee ripide sono quelle che cambiano
+  static const float tiled_widths[] = {3.0f, 8.0f, 24.0f};
+  for (size_t w = 0; w < sizeof(tiled_widths) / sizeof(tiled_widths[0]); w++) {
+    for (size_t s = 1; s < sizeof(slopes) / sizeof(slopes[0]); s++) {
+      if (tiled_widths[w] != 3.0f)
+        bench_line_aa(&surf, 64.0f, tiled_widths[w], slopes[s], CLIP_INSIDE, COBRA_AA_SDF, false);
+      bench_line_aa(&surf, 64.0f, tiled_widths[w], slopes[s], CLIP_INSIDE, COBRA_AA_SDF, true);
+    }
+  }
+
+  // Modalità di blending (colori opachi e semitrasparenti)
+  bench_line_aa_blend(&surf, "line_aa_blend/over_a255", COBRA_BLEND_OVER, 0xFF);
+  bench_line_aa_blend(&surf, "line_aa_blend/over_a128", COBRA_BLEND_OVER, 0x80);
+  bench_line_aa_blend(&surf, "line_aa_blend/additive", COBRA_BLEND_ADDITIVE, 0xFF);
+  bench_line_aa_blend(&surf, "line_aa_blend/max", COBRA_BLEND_MAX, 0xFF);
+
+  // Reticoli: linee sottili (percorso dedicato) e a 1px
+  bench_line_aa_grid(&surf, 0.5f);
+  bench_line_aa_grid(&surf, 1.0f);
+
+  // API batch SoA (stesse linee dei casi singoli corrispondenti)
+  for (size_t m = 0; m < sizeof(aa_modes) / sizeof(aa_modes[0]); m++) {
+    bench_lines_aa_batch(&surf, 8.0f, 1.0f, aa_modes[m]);
+    bench_lines_aa_batch(&surf, 64.0f, 3.0f, aa_modes[m]);
+  }
+  bench_lines_3d(&surf, false);
+  bench_lines_3d(&surf, true);
+  bench_polyline(&surf, 1.5f, true);
+  bench_polyline(&surf, 1.5f, false);
+  bench_polyline(&surf, 4.0f, true);
+  bench_polyline(&surf, 4.0f, false);
+  bench_points(&surf, "points_3d/single", COBRA_POINT_SQUARE, 0.5f, false, true);
+  bench_points(&surf, "points_3d/square", COBRA_POINT_SQUARE, 0.5f, false, false);
+  bench_points(&surf, "points_3d/square/depth", COBRA_POINT_SQUARE, 0.5f, true, false);
+  bench_points(&surf, "points_3d/disc_r1.5", COBRA_POINT_DISC, 1.5f, false, false);
+  bench_points(&surf, "points_3d/disc_r1.5/depth", COBRA_POINT_DISC, 1.5f, true, false);
+  bench_mesh(&surf, true, false, false);
+  bench_mesh(&surf, false, false, false);
+  bench_mesh(&surf, false, false, true);
+  bench_mesh(&surf, true, true, false);
+  bench_mesh(&surf, false, true, false);
+  bench_mesh_filled(&surf);
+  bench_mesh_occluded(&surf, false);
+  bench_mesh_occluded(&surf, true);
+
+  // Triangoli pieni (piccoli, medi, grandi), con e senza test di profondità
+  bench_triangles(&surf, "triangle/size16", 16.0f, false);
+  bench_triangles(&surf, "triangle/size64", 64.0f, false);
+  bench_triangles(&surf, "triangle/size256", 256.0f, false);
+  bench_triangles(&surf, "triangle/size64_depth", 64.0f, true);
+
+  // Modalità differita multithread (scalabilità con i core)
+  bench_line_aa_deferred(&surf, -1);
+  static const int thread_counts[] = {1, 2, 4, 8, 0};
+  for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++)
+    bench_line_aa_deferred(&surf, thread_counts[t]);
+
+  // Trasformazioni
+  bench_vec3("vec3/rotate_x", XF_ROTATE_X);
+  bench_vec3("vec3/rotate_y", XF_ROTATE_Y);
+  bench_vec3("vec3/rotate_z", XF_ROTATE_Z);
+  bench_vec3("vec3/rotate_xyz", XF_ROTATE_XYZ);
+  bench_transform_points("mat4/rotate_xyz_aos", true);
+  bench_transform_points("mat4/rotate_xyz_soa", false);
+  bench_vec3("vec3/project", XF_PROJECT);
+  bench_vec3("vec3/normalize", XF_NORMALIZE);
+
+  cobra_surface_destroy(&surf);
+  return 0;
+}
@@ -105,6 +105,19 @@ int main() {
 
         }
 
+        // Mesh wireframe: 8 vertici condivisi e 12 spigoli (ogni vertice viene proiettato una volta)
+        cobra_mesh cube;
+        cobra_mesh_init(&cube);
+        for (int i = 0; i < 8; i++)
+            cobra_mesh_add_vertex(&cube, cube_vertices[i]);
+        static const int cube_faces[6][4] = {
+            {0, 1, 2, 3}, {4, 5, 6, 7}, {0, 1, 5, 4},
+            {1, 2, 6, 5}, {2, 3, 7, 6}, {3, 0, 4, 7}
+        };
+        // Le facce condividono gli spigoli: la mesh li memorizza una sola volta
+        for (int f = 0; f < 6; f++)
+            cobra_mesh_add_polygon(&cube, cube_faces[f], 4);
+
         while (!window.should_close) {
             // Calcolo del Delta Time (dt) in secondi
             uint64_t current_time = SDL_GetTicks();
@@ -123,7 +136,7 @@ int main() {
             }
             
             // 1. Pulisci buffer (Sfondo nero: 0xFF000000)
-            cobra_window_clear(&window, 0xFF000000);
+            cobra_window_clear(&window.surface, 0xFF000000);
 
             // Aggiorna rotazione
             if (animate) {
@@ -132,42 +145,22 @@ int main() {
             }
 
             // 2. Pipeline 3D: Trasformazione (World -> View)
-            cobra_vec3 transformed_points[8];
-            for (int i = 0; i < 8; i++) {
-                cobra_vec3 point = cube_vertices[i];
-
-                // A. Rotazione (su tutti gli assi per effetto 3D completo)
-                point = cobra_vec3_rotate_x(point, angle);
-                point = cobra_vec3_rotate_y(point, angle * 0.5f);
-                point = cobra_vec3_rotate_z(point, angle * 0.2f);
+            // A. Rotazione (su tutti gli assi per effetto 3D completo): una matrice per frame,
+            //    seno e coseno non vengono ricalcolati per ogni vertice
+            cobra_mat4 rotation = cobra_mat4_mul(cobra_mat4_rotate_z(angle * 0.2f),
+                                  cobra_mat4_mul(cobra_mat4_rotate_y(angle * 0.5f), cobra_mat4_rotate_x(angle)));
 
-                // B. Traslazione (Spostiamo il cubo davanti alla camera lungo Z)
-                point.z += camera_dist;
+            // B. Traslazione (Spostiamo il cubo davanti alla camera lungo Z)
+            cobra_mat4 model_view = cobra_mat4_mul(cobra_mat4_translate((cobra_vec3){{0.0f, 0.0f, camera_dist}}), rotation);
 
-                // Salviamo il punto 3D trasformato (NON ancora proiettato)
-                transformed_points[i] = point;
-            }
-
-            // 3. Disegno delle linee con Clipping 3D
-            // Colleghiamo i vertici secondo la struttura del cubo
-            for (int i = 0; i < 4; i++) {
-                // Faccia frontale (0-1, 1-2, 2-3, 3-0)
-                cobra_window_draw_line_3d(&window, transformed_points[i], transformed_points[(i+1)%4], 
-                                          fov_factor, 0.1f, 0xFFFF00FF, true, false);
-                
-                // Faccia posteriore (4-5, 5-6, 6-7, 7-4)
-                cobra_window_draw_line_3d(&window, transformed_points[i+4], transformed_points[((i+1)%4)+4], 
-                                          fov_factor, 0.1f, 0xFFFFFF00, true, true);
-                
-                // Collegamenti tra fronte e retro (0-4, 1-5, 2-6, 3-7)
-                cobra_window_draw_line_3d(&window, transformed_points[i], transformed_points[i+4], 
-                                          fov_factor, 1.0f, 0xFFFFFFFF, false, false);
-            }
+            // 3. Disegno della mesh con Clipping 3D (trasformazione, proiezione e spigoli in una chiamata)
+            cobra_window_draw_mesh(&window.surface, &cube, &model_view, fov_factor, 1.0f, 0xFFFFFFFF, true, COBRA_AA_SDF);
 
             // 4. Swap buffers
             cobra_window_present(&window);
         }
 
+        cobra_mesh_destroy(&cube);
         cobra_window_destroy(&window);
     } else {
         printf("Impossibile creare la finestra.\n");
@@ -5,6 +5,8 @@
 // Include automaticamente tutti i moduli della libreria.
 
 #include "cobragl/math.h"
+#include "cobragl/surface.h"
+#include "cobragl/mesh.h"
 #include "cobragl/core.h"
 #include "cobragl/utils.h"
 
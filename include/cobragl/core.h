@@ -5,29 +5,46 @@
 #include <stdint.h>
 #include <SDL3/SDL.h>
 #include "cobragl/math.h"
+#include "cobragl/surface.h"
 
+// Stato del present asincrono (opaco, definito in core.c)
+struct cobra_presenter;
+
+// La finestra incapsula una cobra_surface (i buffer su cui si disegna)
+// più il percorso di presentazione SDL (finestra, renderer, texture).
 typedef struct cobra_window {
   SDL_Window *sdl_window;
   SDL_Renderer *sdl_renderer;
   SDL_Texture *color_buffer_texture;
-  uint32_t *color_buffer;
-  float *z_buffer;
-  int width;
-  int height;
+  cobra_surface surface;
+  // Modalità zero-copy: surface.color_buffer punta ai pixel della texture bloccata
+  bool zero_copy;
+  uint32_t *owned_color_buffer; // buffer allocato dalla superficie, ripristinato all'uscita
+  struct cobra_presenter *presenter; // NULL = present sincrono
   bool should_close;
 } cobra_window;
 
 bool cobra_window_create(cobra_window *win, int width, int height, const char *title);
 void cobra_window_destroy(cobra_window *win);
 void cobra_window_poll_events(cobra_window *win);
-void cobra_window_clear(cobra_window *win, uint32_t color);
+// Carica nella texture solo i rettangoli modificati (surface.damage) e presenta il frame
 void cobra_window_present(cobra_window *win);
 
-void cobra_window_draw_point(cobra_window *win, int x, int y, uint32_t color);
-void cobra_window_draw_point_aa(cobra_window *win, int x, int y, uint32_t color, float alpha);
-void cobra_window_draw_line(cobra_window *win, int x0, int y0, int x1, int y1, uint32_t color);
-void cobra_window_draw_line_aa(cobra_window *win, float x0, float y0, float x1, float y1, float width, uint32_t color, bool use_ss);
-// Disegna una linea 3D gestendo proiezione e clipping (Near Plane)
-void cobra_window_draw_line_3d(cobra_window *win, cobra_vec3 p1, cobra_vec3 p2, float fov, float thickness, uint32_t color, bool aa, bool use_ss);
+// Modalità zero-copy: si disegna direttamente nella memoria restituita da SDL_LockTexture,
+// eliminando la copia del present. Il contenuto della texture bloccata non è definito,
+// quindi ogni frame va ridisegnato da zero (il primo clear dopo ogni present è completo).
+// Restituisce false se la texture ha un pitch diverso dalla larghezza del buffer.
+// Non è compatibile con il present asincrono.
+bool cobra_window_set_zero_copy(cobra_window *win, bool enabled);
+
+// Present asincrono con 'buffers' color buffer (2 o 3; 1 torna al present sincrono).
+// cobra_window_present chiude il buffer di disegno (cobra_surface_swap_buffers) e un thread
+// copia i suoi rettangoli modificati nella texture bloccata, mentre il chiamante pulisce e
+// disegna il frame successivo nell'altro buffer. Il frame viene mostrato al present seguente,
+// dopo aver atteso la fine della copia: la latenza cresce di un frame.
+// Le chiamate SDL (lock, present con VSync) restano sul thread che ha creato la finestra;
+// il thread di present tocca solo la memoria della texture bloccata.
+// cobra_surface_draw_buffer(&win->surface) dice su quale buffer si sta disegnando.
+bool cobra_window_set_async_present(cobra_window *win, int buffers);
 
-#endif // COBRAGL_CORE_H
\ No newline at end of file
+#endif // COBRAGL_CORE_H
@@ -40,4 +40,67 @@ cobra_vec3 cobra_vec3_rotate_y(cobra_vec3 v, c_float angle);
 
 cobra_vec3 cobra_vec3_rotate_z(cobra_vec3 v, c_float angle);
 
+// --- MATRICI E QUATERNIONI ---
+// Convenzioni: vettori colonna (p' = M * p), matrici memorizzate per colonne: m[colonna][riga].
+// Lo spazio camera è quello di cobra_vec3_project: X a destra, Y in alto, Z in avanti (davanti
+// alla camera z > 0). Le rotazioni seguono cobra_vec3_rotate_x/y/z.
+
+typedef union {
+    c_float m[4][4];
+    c_float comp[16];
+} cobra_mat4;
+
+typedef union {
+    struct { c_float x, y, z, w; };
+    c_float comp[4];
+} cobra_quat;
+
+cobra_mat4 cobra_mat4_identity(void);
+
+// a * b: applica prima b, poi a
+cobra_mat4 cobra_mat4_mul(cobra_mat4 a, cobra_mat4 b);
+
+cobra_mat4 cobra_mat4_translate(cobra_vec3 t);
+
+cobra_mat4 cobra_mat4_scale(cobra_vec3 s);
+
+cobra_mat4 cobra_mat4_rotate_x(c_float angle);
+
+cobra_mat4 cobra_mat4_rotate_y(c_float angle);
+
+cobra_mat4 cobra_mat4_rotate_z(c_float angle);
+
+cobra_mat4 cobra_mat4_from_quat(cobra_quat q);
+
+// Matrice di vista: camera in 'eye' che guarda 'target' (+Z verso il target)
+cobra_mat4 cobra_mat4_look_at(cobra_vec3 eye, cobra_vec3 target, cobra_vec3 up);
+
+// Proiezione prospettica verso lo spazio clip: w = z di vista, dopo la divisione
+// x,y in [-1,1] e z in [0,1] (0 sul near plane, 1 sul far plane).
+// fov_y in radianti, aspect = larghezza / altezza.
+cobra_mat4 cobra_mat4_perspective(c_float fov_y, c_float aspect, c_float near_plane, c_float far_plane);
+
+// Trasforma un punto (w = 1) senza divisione prospettica
+cobra_vec3 cobra_mat4_transform_point(cobra_mat4 m, cobra_vec3 p);
+
+cobra_quat cobra_quat_identity(void);
+
+// Rotazione di 'angle' radianti attorno a 'axis' (non serve che sia normalizzato), regola della
+// mano destra. Coincide con cobra_mat4_rotate_x/z; per Y equivale a cobra_mat4_rotate_y(-angle),
+// perché cobra_vec3_rotate_y usa il verso opposto.
+cobra_quat cobra_quat_from_axis_angle(cobra_vec3 axis, c_float angle);
+
+// a * b: applica prima b, poi a
+cobra_quat cobra_quat_mul(cobra_quat a, cobra_quat b);
+
+cobra_quat cobra_quat_normalize(cobra_quat q);
+
+cobra_vec3 cobra_quat_rotate(cobra_quat q, cobra_vec3 v);
+
+// Applica 'm' a 'count' punti in formato structure-of-arrays (w = 1), con SIMD.
+// out_w può essere NULL se non serve (trasformazioni affini).
+// Gli array di uscita possono coincidere con quelli di ingresso (trasformazione in place).
+void cobra_transform_points(const cobra_mat4 *m, const c_float *x, const c_float *y, const c_float *z,
+                            c_float *out_x, c_float *out_y, c_float *out_z, c_float *out_w, int count);
+
 #endif
\ No newline at end of file
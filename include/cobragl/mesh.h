@@ -0,0 +1,67 @@
+#ifndef COBRAGL_MESH_H
+#define COBRAGL_MESH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cobragl/math.h"
+#include "cobragl/surface.h"
+
+// Mesh indicizzata, disegnabile in wireframe o piena.
+// I vertici sono memorizzati una sola volta (structure-of-arrays), gli spigoli sono coppie
+// di indici senza duplicati: uno spigolo condiviso da due facce viene disegnato una volta.
+// Le facce sono memorizzate come triangoli (terne di indici).
+// Al disegno ogni vertice viene trasformato e proiettato esattamente una volta in un buffer
+// di appoggio (nell'arena per frame della superficie, condiviso da tutte le mesh);
+// gli spigoli leggono poi le posizioni a schermo già calcolate.
+typedef struct cobra_mesh {
+  // Vertici (spazio modello)
+  float *x, *y, *z;
+  int vertex_count;
+  int vertex_capacity;
+  // AABB dei vertici, aggiornato da cobra_mesh_add_vertex (per il culling dell'intera mesh)
+  cobra_vec3 bounds_min, bounds_max;
+
+  // Spigoli: edges[2*i], edges[2*i+1], con il primo indice minore del secondo
+  int *edges;
+  int edge_count;
+  int edge_capacity;
+
+  // Tabella hash (indirizzamento aperto) per scartare gli spigoli duplicati
+  int *edge_hash;
+  int edge_hash_capacity;
+
+  // Triangoli: triangles[3*i], triangles[3*i+1], triangles[3*i+2]
+  int *triangles;
+  int triangle_count;
+  int triangle_capacity;
+} cobra_mesh;
+
+void cobra_mesh_init(cobra_mesh *mesh);
+void cobra_mesh_destroy(cobra_mesh *mesh);
+
+// Aggiunge un vertice e ne restituisce l'indice (-1 se la memoria è esaurita)
+int cobra_mesh_add_vertex(cobra_mesh *mesh, cobra_vec3 v);
+// Aggiunge lo spigolo a-b se non esiste già (in qualunque verso).
+// Restituisce false per indici non validi, spigoli degeneri (a == b) o memoria esaurita.
+bool cobra_mesh_add_edge(cobra_mesh *mesh, int a, int b);
+// Aggiunge il triangolo a-b-c (solo come faccia: gli spigoli non vengono toccati)
+bool cobra_mesh_add_triangle(cobra_mesh *mesh, int a, int b, int c);
+// Aggiunge un poligono convesso: il contorno chiuso (indices[0] -> ... -> indices[count-1] -> indices[0])
+// come spigoli e, con almeno 3 vertici, la faccia divisa in triangoli a ventaglio da indices[0]
+bool cobra_mesh_add_polygon(cobra_mesh *mesh, const int *indices, int count);
+
+// Disegna gli spigoli della mesh. 'model_view' porta i vertici nello spazio camera
+// (Z in avanti, come cobra_window_draw_line_3d); proiezione e clipping sul frustum
+// sono gli stessi di cobra_window_draw_line_3d. Una mesh il cui AABB è fuori dal frustum
+// viene scartata prima di trasformare i vertici.
+void cobra_window_draw_mesh(cobra_surface *surf, cobra_mesh *mesh, const cobra_mat4 *model_view,
+                            float fov, float thickness, uint32_t color, bool aa, cobra_aa_mode aa_mode);
+
+// Disegna i triangoli della mesh pieni (vedi cobra_window_draw_triangle), con la stessa
+// trasformazione e proiezione una volta per vertice del wireframe. 'colors' contiene un colore
+// per triangolo (per esempio un'illuminazione per faccia calcolata dal chiamante);
+// NULL = 'color' per tutti.
+void cobra_window_draw_mesh_filled(cobra_surface *surf, cobra_mesh *mesh, const cobra_mat4 *model_view,
+                                   float fov, const uint32_t *colors, uint32_t color);
+
+#endif // COBRAGL_MESH_H
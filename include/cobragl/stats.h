@@ -0,0 +1,53 @@
+#ifndef COBRAGL_STATS_H
+#define COBRAGL_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Statistiche di rendering per frame e tracce per chrome://tracing.
+//
+// La strumentazione esiste solo se la libreria è compilata con COBRA_STATS (make STATS=1):
+// senza, le macro interne non generano codice, le funzioni qui sotto restituiscono zeri
+// e cobra_stats_trace_begin restituisce false.
+// I contatori sono globali (valgono per tutte le superfici) e aggiornati in modo atomico,
+// quindi comprendono anche il lavoro dei thread della modalità differita.
+typedef struct cobra_stats {
+  uint64_t frame; // numero del frame (da 0)
+
+  // Geometria
+  uint64_t lines_submitted;     // linee arrivate al percorso 2D (anche proiezioni di linee 3D e spigoli)
+  uint64_t lines_clipped;       // ... scartate interamente dal clipping sullo schermo (Cohen-Sutherland)
+  uint64_t lines_culled;        // linee 3D e spigoli scartati dal frustum prima della proiezione
+  uint64_t triangles_submitted; // triangoli arrivati al rasterizzatore (dopo il clipping 3D)
+  uint64_t triangles_culled;    // triangoli 3D scartati dal frustum
+  uint64_t meshes_culled;       // mesh scartate dal frustum culling
+  uint64_t meshes_occluded;     // mesh scartate dall'occlusion culling (Hi-Z)
+  uint64_t points_submitted;    // punti delle nuvole 3D
+  uint64_t points_culled;       // ... scartati da frustum e schermo prima dello splat
+
+  // Riempimento (kernel SDF, supersampling delle linee AA, triangoli)
+  uint64_t pixels_evaluated; // pixel per cui sono state calcolate copertura e profondità
+  uint64_t pixels_blended;   // pixel effettivamente scritti
+
+  // Tempo (ns) sul thread che disegna; le chiamate annidate non vengono contate due volte
+  uint64_t ns_clear;
+  uint64_t ns_raster; // draw e flush della modalità differita
+  uint64_t ns_present;
+} cobra_stats;
+
+// Contatori del frame in corso
+void cobra_stats_get(cobra_stats *out);
+// Chiude il frame: i contatori passano all'ultimo frame completo e ripartono da zero.
+// cobra_window_present la chiama da sola; senza finestra va chiamata a fine frame.
+void cobra_stats_end_frame(void);
+// Contatori dell'ultimo frame chiuso
+void cobra_stats_last_frame(cobra_stats *out);
+
+// Traccia in formato Chrome Trace Event (JSON, apribile con chrome://tracing o Perfetto).
+// Clear, flush, tile della modalità differita, mesh, batch e present diventano eventi con
+// durata e thread; a ogni fine frame i contatori diventano eventi "counter".
+// Così si vede subito se un frame lento è limitato dal riempimento, dal setup o dal present.
+bool cobra_stats_trace_begin(const char *path);
+void cobra_stats_trace_end(void);
+
+#endif // COBRAGL_STATS_H
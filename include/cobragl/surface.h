@@ -0,0 +1,343 @@
+#ifndef COBRAGL_SURFACE_H
+#define COBRAGL_SURFACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "cobragl/math.h"
+
+// Rettangolo intero semiaperto [x0,x1) x [y0,y1) in coordinate pixel
+typedef struct cobra_rect {
+  int x0, y0;
+  int x1, y1;
+} cobra_rect;
+
+// Modalità di blending delle primitive AA, scelta una volta per draw call.
+// I colori sono ARGB con alpha reale; la copertura AA moltiplica l'alpha sorgente.
+typedef enum cobra_blend_mode {
+  COBRA_BLEND_OVER,     // composizione "over" (default)
+  COBRA_BLEND_ADDITIVE, // somma saturata per canale
+  COBRA_BLEND_MAX       // massimo per canale
+} cobra_blend_mode;
+
+// Confronto del test di profondità: il pixel passa se (profondità nuova <op> z_buffer).
+// Le profondità vanno da 0 (near plane) a 1 (far plane o infinito), il clear usa 1.0.
+typedef enum cobra_depth_func {
+  COBRA_DEPTH_ALWAYS,  // nessun test (default)
+  COBRA_DEPTH_LESS,
+  COBRA_DEPTH_LEQUAL,
+  COBRA_DEPTH_GREATER,
+  COBRA_DEPTH_GEQUAL
+} cobra_depth_func;
+
+// Calcolo della copertura delle linee AA, scelto a ogni chiamata.
+// SDF e SS valgono 0 e 1 come il vecchio parametro bool use_ss.
+typedef enum cobra_aa_mode {
+  COBRA_AA_SDF, // rampa lineare sulla distanza dal bordo (sotto 1px con correzione percettiva)
+  COBRA_AA_SS,  // supersampling RGSS a 4 campioni
+  COBRA_AA_LUT, // tabella indicizzata con la distanza^2 (filtro a disco), senza radice quadrata
+  COBRA_AA_BOX  // area del pixel coperta dalla linea (filtro box), esatta sul corpo
+} cobra_aa_mode;
+
+// Raccordo tra due segmenti consecutivi di una polilinea
+typedef enum cobra_line_join {
+  COBRA_JOIN_MITER, // spigolo vivo; oltre COBRA_MITER_LIMIT diventa BEVEL
+  COBRA_JOIN_ROUND, // arco di cerchio (le punte tonde dei due segmenti)
+  COBRA_JOIN_BEVEL  // spigolo tagliato dalla corda tra i bordi esterni
+} cobra_line_join;
+
+// Rapporto massimo tra la lunghezza dello spigolo MITER e lo spessore (come stroke-miterlimit
+// di SVG): gli angoli più acuti di circa 29 gradi vengono smussati
+#define COBRA_MITER_LIMIT 4.0f
+
+// Numero massimo di rettangoli modificati tracciati per il present parziale
+#define COBRA_MAX_DAMAGE_RECTS 8
+
+// Stato della modalità differita (opaco, definito in deferred.c)
+struct cobra_deferred;
+
+// Arena per frame: i buffer temporanei della superficie (vedi MEMORIA PER FRAME)
+#define COBRA_ARENA_ALIGN 64
+typedef struct cobra_arena_block cobra_arena_block;
+typedef struct cobra_arena {
+  unsigned char *base;         // blocco principale
+  size_t capacity;
+  size_t used;
+  cobra_arena_block *overflow; // blocchi extra del frame in corso (liberati al reset)
+  size_t overflow_bytes;
+  size_t frame_peak;           // byte richiesti nel frame in corso (massimo)
+  size_t high_water;           // massimo di frame_peak sui frame chiusi
+  unsigned frame;              // incrementato a ogni reset
+} cobra_arena;
+
+// Buffer ridimensionabile preso dall'arena: valido fino alla fine del frame in cui è stato
+// allocato (il campo frame lo distingue da un puntatore di un frame precedente)
+typedef struct cobra_arena_buf {
+  void *ptr;
+  size_t size;
+  unsigned frame;
+} cobra_arena_buf;
+
+// Buffer di colore multipli (vedi BUFFER MULTIPLI)
+#define COBRA_MAX_BUFFERS 3
+
+// Stato di un color buffer che non è quello di disegno: gli stessi campi della superficie,
+// salvati allo scambio e ripristinati quando il buffer torna a essere disegnato
+typedef struct cobra_buffer_state {
+  cobra_rect dirty_color;
+  uint32_t last_clear_color;
+  bool color_cleared;
+  // Regioni in cui il buffer differisce dalla texture della finestra
+  cobra_rect damage[COBRA_MAX_DAMAGE_RECTS];
+  int damage_count;
+} cobra_buffer_state;
+
+// Superficie di rendering "headless": possiede solo i buffer di colore e profondità.
+// Non dipende da SDL, quindi può essere usata su macchine senza display
+// (rendering batch lato server, profiling del rasterizzatore).
+typedef struct cobra_surface {
+  uint32_t *color_buffer;
+  float *z_buffer;
+  int width;
+  int height;
+  // Layout dei buffer: righe consecutive oppure tile (vedi LAYOUT A TILE); tiles_x = tile per riga
+  bool tiled;
+  int tiles_x;
+  struct cobra_deferred *deferred; // NULL = modalità immediata
+
+  // Aree toccate dalle primitive dall'ultimo clear di ciascun buffer (vuote se x0 >= x1).
+  // Le scritture dirette nei buffer da parte dell'utente non vengono tracciate.
+  cobra_rect dirty_color;
+  cobra_rect dirty_depth;
+  bool clear_dirty_only;
+  // Piramide Hi-Z (NULL = occlusion culling disattivato) e tile da ricalcolare prima del prossimo test
+  struct cobra_hiz *hiz;
+  cobra_rect dirty_hiz;
+  // Ultimi valori di clear: il clear parziale è corretto solo se il valore non cambia
+  uint32_t last_clear_color;
+  float last_clear_depth;
+  bool color_cleared;
+  bool depth_cleared;
+
+  // Rettangoli del color buffer modificati dall'ultimo present (draw e clear).
+  // La finestra carica nella texture solo queste regioni.
+  cobra_rect damage[COBRA_MAX_DAMAGE_RECTS];
+  int damage_count;
+
+  // Stato di blending letto all'inizio di ogni draw call
+  cobra_blend_mode blend_mode;
+  bool premultiplied; // true = i colori passati sono già premoltiplicati per l'alpha
+
+  // Piani near/far dello spazio camera per le primitive 3D
+  float near_plane;
+  float far_plane;
+
+  // Test e scrittura della profondità per le primitive 3D
+  cobra_depth_func depth_func;
+  bool depth_write;
+
+  // Color buffer allocati (color_buffer è color_buffers[draw_buffer]) e stato di quelli non disegnati
+  uint32_t *color_buffers[COBRA_MAX_BUFFERS];
+  cobra_buffer_state buffer_state[COBRA_MAX_BUFFERS];
+  int buffer_count;
+  int draw_buffer;
+  // true mentre un altro thread legge i color buffer (present asincrono della finestra):
+  // set_buffer_count e set_tiled vengono rifiutati
+  bool buffers_shared;
+
+  // Memoria per frame e buffer di appoggio delle mesh (posizioni trasformate e proiettate)
+  cobra_arena arena;
+  cobra_arena_buf mesh_scratch;
+} cobra_surface;
+
+bool cobra_surface_create(cobra_surface *surf, int width, int height);
+void cobra_surface_destroy(cobra_surface *surf);
+
+// --- MODALITÀ DIFFERITA (MULTITHREAD) ---
+// Dopo enable, le linee AA vengono registrate in un command buffer invece di essere disegnate.
+// Al flush vengono distribuite in tile di COBRA_TILE_SIZE pixel (in base al bounding box
+// della guard band) e rasterizzate da un pool di thread, un tile per task.
+// L'ordine di disegno dentro ogni tile è quello di registrazione, quindi il blending è deterministico.
+// num_threads: thread totali (incluso il chiamante), 0 = numero di core disponibili.
+// Le altre primitive restano immediate: prima di disegnare eseguono un flush implicito.
+#define COBRA_TILE_SIZE 64
+bool cobra_surface_enable_deferred(cobra_surface *surf, int num_threads);
+void cobra_surface_flush(cobra_surface *surf);
+void cobra_surface_disable_deferred(cobra_surface *surf);
+
+// --- MEMORIA PER FRAME ---
+// I buffer temporanei della superficie (command buffer e liste dei tile della modalità differita,
+// posizioni trasformate delle mesh) vengono presi da un'arena con un incremento di puntatore,
+// allineati a COBRA_ARENA_ALIGN byte. end_frame completa le linee differite e azzera l'arena in
+// O(1); cobra_window_present la chiama da sola. Se in un frame il blocco non basta, le richieste in
+// eccesso ricevono blocchi a parte e al reset il blocco cresce fino al picco del frame: a regime
+// il disegno non esegue malloc/free. L'arena appartiene al thread che disegna.
+void cobra_surface_end_frame(cobra_surface *surf);
+// Prealloca l'arena (a inizio frame, con l'arena vuota) per evitare le crescite dei primi frame
+bool cobra_surface_reserve_arena(cobra_surface *surf, size_t bytes);
+// Byte massimi usati in un frame (high-water mark) e capacità attuale del blocco principale
+void cobra_surface_arena_report(const cobra_surface *surf, size_t *high_water, size_t *capacity);
+
+// --- BUFFER MULTIPLI ---
+// La superficie può avere fino a COBRA_MAX_BUFFERS color buffer: le primitive disegnano sempre
+// in color_buffer, che è color_buffers[draw_buffer]. swap completa le linee differite e passa al
+// buffer successivo; il buffer appena chiuso resta intatto finché il giro non torna a lui, quindi
+// può essere letto (per esempio caricato in una texture da un altro thread) mentre si disegna
+// il frame seguente. Lo z_buffer è uno solo: serve solo durante il disegno, non al present.
+// Ogni buffer conserva il proprio stato di clear parziale e i propri rettangoli di danno.
+// set_buffer_count alloca o libera i buffer (contenuto iniziale non definito, da pulire).
+// Restituisce false se i buffer sono in uso dal present asincrono (buffers_shared): su una
+// finestra il numero di buffer si cambia con cobra_window_set_async_present, che attende la copia.
+bool cobra_surface_set_buffer_count(cobra_surface *surf, int count);
+// Indice del buffer su cui si sta disegnando (0 .. buffer_count-1)
+int cobra_surface_draw_buffer(const cobra_surface *surf);
+// Chiude il buffer corrente e restituisce l'indice del nuovo buffer di disegno
+int cobra_surface_swap_buffers(cobra_surface *surf);
+
+// --- LAYOUT A TILE ---
+// Con il layout a tile color_buffer e z_buffer non sono più righe consecutive: sono divisi in
+// tile di COBRA_FB_TILE x COBRA_FB_TILE pixel, memorizzati per righe di tile, e dentro ogni
+// tile i pixel sono per righe. Un tile di colore occupa 256 byte (4 linee di cache), quindi un
+// passo verticale resta quasi sempre nella stessa linea di cache o in quella accanto: le linee
+// ripide e spesse toccano tante linee quanto quelle orizzontali. I buffer allocati vengono
+// arrotondati a multipli del tile. Primitive, clear e Hi-Z seguono il layout corrente; il
+// present e cobra_surface_read_color riportano i pixel in ordine lineare (copie SIMD di una
+// riga di tile alla volta). Il cambio converte il contenuto dei color buffer e dello z_buffer.
+// Non è compatibile con la modalità zero-copy e va scelto prima di attivare il present asincrono:
+// con il present asincrono attivo (buffers_shared) set_tiled restituisce false.
+// Le scritture dirette dell'utente in color_buffer devono usare lo stesso indirizzamento.
+#define COBRA_FB_TILE 8
+bool cobra_surface_set_tiled(cobra_surface *surf, bool tiled);
+// Copia il rettangolo 'r' (NULL = tutta la superficie) del buffer di disegno in 'dst', in ordine
+// lineare con 'dst_pitch' pixel per riga: legge i pixel indipendentemente dal layout
+void cobra_surface_read_color(const cobra_surface *surf, const cobra_rect *r, uint32_t *dst, int dst_pitch);
+
+// --- BLENDING ---
+// Valgono per draw_point_aa, per tutte le linee AA e per i triangoli. draw_point e draw_line (Bresenham)
+// scrivono il colore così com'è, senza blending.
+void cobra_surface_set_blend_mode(cobra_surface *surf, cobra_blend_mode mode);
+void cobra_surface_set_premultiplied(cobra_surface *surf, bool premultiplied);
+
+// --- CLIPPING 3D ---
+// Le primitive 3D vengono tagliate in spazio camera contro i 6 piani del frustum della
+// proiezione di cobra_vec3_project (lati dello schermo allargati della guard band, near, far)
+// prima della proiezione: la geometria fuori vista non paga proiezione e setup.
+// Default: near = 0.5, far = INFINITY (nessun far plane).
+void cobra_surface_set_clip_planes(cobra_surface *surf, float near_plane, float far_plane);
+
+typedef enum cobra_cull_result {
+  COBRA_CULL_OUTSIDE,   // interamente fuori dal frustum: niente da disegnare
+  COBRA_CULL_INTERSECT, // a cavallo di almeno un piano
+  COBRA_CULL_INSIDE     // interamente dentro: nessun clipping necessario
+} cobra_cull_result;
+
+// Classificano un volume in spazio modello ('model_view' lo porta in spazio camera)
+// rispetto al frustum con fattore di proiezione 'fov' (lo stesso delle draw 3D).
+// Il test è conservativo: OUTSIDE è sempre esatto, INTERSECT può comprendere volumi esterni.
+cobra_cull_result cobra_surface_cull_sphere(const cobra_surface *surf, const cobra_mat4 *model_view, float fov,
+                                            cobra_vec3 center, float radius);
+cobra_cull_result cobra_surface_cull_aabb(const cobra_surface *surf, const cobra_mat4 *model_view, float fov,
+                                          cobra_vec3 min, cobra_vec3 max);
+
+// --- PROFONDITÀ ---
+// Le primitive 3D (linee 3D, triangoli, mesh) possono leggere e scrivere lo z_buffer.
+// La profondità salvata è quella di una proiezione prospettica, (1 - near/z) * far/(far - near):
+// è lineare nello spazio schermo, quindi l'interpolazione lineare lungo la linea (passo di
+// Bresenham o coordinata t degli span SDF) è già corretta in prospettiva.
+// Il test avviene prima del calcolo della copertura e del blending. Con 'write' le linee AA
+// scrivono la profondità solo dove la copertura è almeno del 50%.
+// Le primitive 2D non hanno profondità: ignorano questo stato.
+// Default: COBRA_DEPTH_ALWAYS senza scrittura (lo z_buffer non viene toccato).
+void cobra_surface_set_depth_test(cobra_surface *surf, cobra_depth_func func, bool write);
+
+// --- OCCLUSION CULLING (Hi-Z) ---
+// Dopo enable la superficie mantiene una piramide di profondità minima/massima per tile di
+// COBRA_HIZ_TILE pixel dello z_buffer (livelli successivi 2x2 -> 1). Le mesh vengono confrontate
+// con la piramide tramite il loro AABB subito dopo il frustum culling: se tutto il box è dietro
+// la profondità già scritta non viene trasformato né rasterizzato nessun vertice.
+// I tile toccati dalle primitive con scrittura della profondità vengono ricalcolati in modo
+// pigro, al primo test successivo. Il test usa la funzione di profondità corrente
+// (con COBRA_DEPTH_ALWAYS non scarta nulla) ed è conservativo: un oggetto visibile non viene
+// mai scartato, uno nascosto può non esserlo (per esempio se attraversa il near plane).
+// Conviene disegnare prima gli oggetti vicini e grandi (gli occluder).
+#define COBRA_HIZ_TILE 8
+bool cobra_surface_enable_hiz(cobra_surface *surf);
+void cobra_surface_disable_hiz(cobra_surface *surf);
+// true se il box (spazio modello) è nascosto dalla profondità già presente nello z_buffer
+bool cobra_surface_occluded_aabb(cobra_surface *surf, const cobra_mat4 *model_view, float fov,
+                                 cobra_vec3 min, cobra_vec3 max);
+
+// --- CLEAR ---
+// I clear usano store SIMD (non-temporal per regioni grandi, che non starebbero in cache).
+// Con clear_dirty_only attivo, se il valore coincide con quello del clear precedente
+// viene pulita solo l'unione dei rettangoli toccati dalle primitive nel frattempo.
+void cobra_surface_set_clear_dirty_only(cobra_surface *surf, bool enabled);
+void cobra_window_clear_color(cobra_surface *surf, uint32_t color);
+void cobra_window_clear_depth(cobra_surface *surf, float depth);
+
+// Tutte le primitive di disegno lavorano su una cobra_surface.
+// Una cobra_window espone la propria superficie tramite il campo 'surface'.
+// Pulisce colore e profondità (Z = 1.0, profondità massima)
+void cobra_window_clear(cobra_surface *surf, uint32_t color);
+
+void cobra_window_draw_point(cobra_surface *surf, int x, int y, uint32_t color);
+void cobra_window_draw_point_aa(cobra_surface *surf, int x, int y, uint32_t color, float alpha);
+void cobra_window_draw_line(cobra_surface *surf, int x0, int y0, int x1, int y1, uint32_t color);
+void cobra_window_draw_line_aa(cobra_surface *surf, float x0, float y0, float x1, float y1, float width, uint32_t color, cobra_aa_mode aa_mode);
+// Disegna una linea 3D gestendo proiezione e clipping (Near Plane)
+void cobra_window_draw_line_3d(cobra_surface *surf, cobra_vec3 p1, cobra_vec3 p2, float fov, float thickness, uint32_t color, bool aa, cobra_aa_mode aa_mode);
+
+// Triangolo pieno in spazio camera, con la proiezione e il clipping sul frustum delle linee 3D.
+// La copertura usa edge function in virgola fissa (1/16 di pixel) con regola top-left:
+// triangoli che condividono un lato non lasciano buchi e non coprono due volte lo stesso pixel.
+// Colore con il blending della superficie; profondità secondo cobra_surface_set_depth_test.
+void cobra_window_draw_triangle(cobra_surface *surf, cobra_vec3 p0, cobra_vec3 p1, cobra_vec3 p2, float fov, uint32_t color);
+
+// --- SUBMISSION A BATCH (SoA) ---
+// Disegnano 'count' linee descritte da array separati (structure-of-arrays): l'elemento i
+// di ogni array appartiene alla linea i. Controlli, clipping, proiezione e setup vengono
+// eseguiti a blocchi, in passate vettorizzabili, prima della rasterizzazione.
+void cobra_window_draw_lines_aa(cobra_surface *surf, const float *x0, const float *y0,
+                                const float *x1, const float *y1, const float *width,
+                                const uint32_t *color, int count, cobra_aa_mode aa_mode);
+void cobra_window_draw_lines_3d(cobra_surface *surf, const float *x0, const float *y0, const float *z0,
+                                const float *x1, const float *y1, const float *z1, float fov,
+                                const float *thickness, const uint32_t *color, int count, bool aa, cobra_aa_mode aa_mode);
+
+// --- POLILINEE ---
+// Tracciano il percorso di 'count' punti (x[i], y[i]) come un'unica linea AA: setup una volta
+// per percorso, raccordi 'join' tra i segmenti e punte tonde agli estremi. Vicino ai vertici
+// ogni pixel appartiene a un solo segmento, quindi i raccordi non vengono sfumati due volte
+// (restano doppi solo gli incroci tra segmenti non consecutivi). I punti ripetuti sono ignorati.
+void cobra_window_draw_polyline_aa(cobra_surface *surf, const float *x, const float *y, int count,
+                                   float width, uint32_t color, cobra_line_join join, cobra_aa_mode aa_mode);
+// Punti in spazio camera, proiettati e tagliati come cobra_window_draw_line_3d. Il percorso
+// si interrompe dove esce dai piani near/far: i segmenti tagliati hanno punte tonde.
+void cobra_window_draw_polyline_3d(cobra_surface *surf, const float *x, const float *y, const float *z, int count,
+                                   float fov, float thickness, uint32_t color, cobra_line_join join,
+                                   cobra_aa_mode aa_mode);
+
+// --- NUVOLE DI PUNTI ---
+typedef enum cobra_point_mode {
+  COBRA_POINT_SQUARE, // quadrato di lato 2 * radius (almeno un pixel), colore scritto così com'è
+  COBRA_POINT_DISC    // disco AA di raggio 'radius' con il blending della superficie
+} cobra_point_mode;
+
+// Disegna 'count' punti (x[i], y[i], z[i]) in spazio modello: 'model_view' li porta in spazio
+// camera (NULL = sono già in spazio camera), poi proiezione e piani near/far sono quelli di
+// cobra_window_draw_line_3d. Trasformazione, proiezione e culling vengono eseguiti a blocchi
+// con SIMD; i punti fuori vista non arrivano allo splat. 'colors' contiene un colore per punto
+// (NULL = 'color' per tutti). 'radius' è in pixel e non dipende dalla distanza.
+// Con il test di profondità ogni punto usa la profondità del proprio centro.
+void cobra_window_draw_points_3d(cobra_surface *surf, const float *x, const float *y, const float *z, int count,
+                                 const cobra_mat4 *model_view, float fov, const uint32_t *colors, uint32_t color,
+                                 float radius, cobra_point_mode mode);
+
+// --- KERNEL SIMD ---
+// I kernel più usati (clear, fill, blending, trasformazione dei vertici) esistono in più
+// varianti (scalar, sse2, avx2, avx512): la libreria sceglie la più larga supportata dalla CPU
+// alla creazione della prima superficie o finestra. La variabile d'ambiente COBRA_SIMD ne forza
+// una (se la CPU la supporta). Restituisce il nome della variante in uso.
+const char *cobra_simd_kernels(void);
+
+#endif // COBRAGL_SURFACE_H
@@ -0,0 +1,167 @@
+// Arena per frame della superficie.
+//
+// Le allocazioni sono un incremento di 'used' nel blocco principale, arrotondato a
+// COBRA_ARENA_ALIGN byte (una linea di cache, sufficiente per qualunque load/store SIMD).
+// Non esiste una free per singola allocazione: cobra_arena_reset rimette 'used' a zero.
+// Quando il blocco principale non basta, la richiesta riceve un blocco a parte (overflow);
+// al reset gli overflow vengono liberati e il blocco principale viene riallocato alla
+// dimensione massima richiesta nel frame, così dal frame successivo bastano gli incrementi.
+// L'arena è usata solo dal thread che invia i comandi: nessuna sincronizzazione.
+
+#define _POSIX_C_SOURCE 200809L
+#include "cobragl/surface.h"
+#include "internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct cobra_arena_block {
+  struct cobra_arena_block *next;
+};
+
+static size_t align_up(size_t n)
+{
+  return (n + COBRA_ARENA_ALIGN - 1) & ~(size_t)(COBRA_ARENA_ALIGN - 1);
+}
+
+static void note_peak(cobra_arena *a)
+{
+  size_t total = a->used + a->overflow_bytes;
+  if (total > a->frame_peak)
+    a->frame_peak = total;
+}
+
+void *cobra_arena_alloc(cobra_arena *a, size_t size)
+{
+  size = align_up(size ? size : 1);
+
+  if (a->capacity - a->used >= size) {
+    void *p = a->base + a->used;
+    a->used += size;
+    note_peak(a);
+    return p;
+  }
+
+  // Overflow: blocco a parte con l'intestazione della lista nella prima linea di cache
+  void *mem;
+  if (posix_memalign(&mem, COBRA_ARENA_ALIGN, COBRA_ARENA_ALIGN + size))
+    return NULL;
+  cobra_arena_block *block = (cobra_arena_block *)mem;
+  block->next = a->overflow;
+  a->overflow = block;
+  a->overflow_bytes += size;
+  note_peak(a);
+  return (unsigned char *)mem + COBRA_ARENA_ALIGN;
+}
+
+void *cobra_arena_reserve(cobra_arena *a, cobra_arena_buf *b, size_t size, bool keep)
+{
+  // Un buffer di un frame precedente punta a memoria già riutilizzata
+  if (b->frame != a->frame) {
+    b->ptr = NULL;
+    b->size = 0;
+    b->frame = a->frame;
+  }
+  if (size <= b->size)
+    return b->ptr;
+
+  // Ultima allocazione del blocco principale: si estende sul posto, senza copie
+  unsigned char *p = (unsigned char *)b->ptr;
+  if (p && p >= a->base && p + align_up(b->size) == a->base + a->used) {
+    size_t extra = align_up(size) - align_up(b->size);
+    if (a->capacity - a->used >= extra) {
+      a->used += extra;
+      note_peak(a);
+      b->size = align_up(size);
+      return b->ptr;
+    }
+  }
+
+  // Crescita geometrica: un buffer che cresce a passi piccoli non spreca più del doppio
+  size_t new_size = size > 2 * b->size ? size : 2 * b->size;
+  void *q = cobra_arena_alloc(a, new_size);
+  if (!q)
+    return NULL;
+  if (keep && b->size)
+    memcpy(q, b->ptr, b->size);
+  b->ptr = q;
+  b->size = align_up(new_size);
+  return q;
+}
+
+static void free_overflow(cobra_arena *a)
+{
+  while (a->overflow) {
+    cobra_arena_block *next = a->overflow->next;
+    free(a->overflow);
+    a->overflow = next;
+  }
+  a->overflow_bytes = 0;
+}
+
+bool cobra_arena_grow(cobra_arena *a, size_t capacity)
+{
+  capacity = align_up(capacity);
+  if (capacity <= a->capacity)
+    return true;
+  // Il contenuto non serve: si chiama solo con l'arena vuota
+  void *mem;
+  if (posix_memalign(&mem, COBRA_ARENA_ALIGN, capacity))
+    return false;
+  free(a->base);
+  a->base = (unsigned char *)mem;
+  a->capacity = capacity;
+  return true;
+}
+
+void cobra_arena_reset(cobra_arena *a)
+{
+  if (a->frame_peak > a->high_water)
+    a->high_water = a->frame_peak;
+
+  if (a->overflow) {
+    free_overflow(a);
+    // Margine del 25% sul picco: un frame appena più pesante non torna in overflow
+    cobra_arena_grow(a, a->frame_peak + a->frame_peak / 4);
+  }
+
+  a->used = 0;
+  a->frame_peak = 0;
+  a->frame++;
+}
+
+void cobra_arena_destroy(cobra_arena *a)
+{
+  free_overflow(a);
+  free(a->base);
+  memset(a, 0, sizeof(*a));
+}
+
+void cobra_surface_end_frame(cobra_surface *surf)
+{
+  if (!surf)
+    return;
+  // Le linee differite vivono nell'arena: vanno disegnate prima di riutilizzarla
+  cobra_surface_flush(surf);
+  cobra_arena_reset(&surf->arena);
+}
+
+bool cobra_surface_reserve_arena(cobra_surface *surf, size_t bytes)
+{
+  if (!surf)
+    return false;
+  // Con allocazioni in corso il blocco non si può sostituire: la crescita avviene al prossimo reset
+  if (surf->arena.used || surf->arena.overflow)
+    return bytes <= surf->arena.capacity;
+  return cobra_arena_grow(&surf->arena, bytes);
+}
+
+void cobra_surface_arena_report(const cobra_surface *surf, size_t *high_water, size_t *capacity)
+{
+  if (!surf)
+    return;
+  size_t peak = surf->arena.frame_peak > surf->arena.high_water ? surf->arena.frame_peak : surf->arena.high_water;
+  if (high_water)
+    *high_water = peak;
+  if (capacity)
+    *capacity = surf->arena.capacity;
+}
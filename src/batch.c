@@ -0,0 +1,251 @@
+// Submission a batch delle linee (structure-of-arrays).
+//
+// Invece di ripetere controlli, clipping e setup per ogni chiamata, elaboriamo le linee
+// a blocchi di BATCH_CHUNK elementi. Ogni fase è una passata separata su array contigui,
+// senza dipendenze tra elementi, così il compilatore può vettorizzarla:
+//   1. (3D) outcode dei piani del frustum, clipping delle linee a cavallo e proiezione
+//   2. outcode della guard band: trivial accept / reject senza diramazioni
+//   3. compattazione (Cohen-Sutherland completo solo per le linee a cavallo del bordo)
+//   4. setup: lunghezza al quadrato, reciproco della lunghezza, colore premoltiplicato
+//      e (con il test di profondità) profondità degli estremi
+//   5. rasterizzazione
+// I blocchi stanno sullo stack: nessuna allocazione per chiamata.
+
+#include "cobragl/surface.h"
+#include "internal.h"
+#include <math.h>
+
+#define BATCH_CHUNK 256
+
+typedef struct {
+  float x0[BATCH_CHUNK], y0[BATCH_CHUNK];
+  float x1[BATCH_CHUNK], y1[BATCH_CHUNK];
+  float width[BATCH_CHUNK];
+  float len_sq[BATCH_CHUNK];
+  float inv_len[BATCH_CHUNK];
+  uint32_t color[BATCH_CHUNK];
+  float z0[BATCH_CHUNK], z1[BATCH_CHUNK]; // z in spazio camera (3D), poi profondità 0..1 (setup)
+} line_chunk;
+
+// Clipping, setup e rasterizzazione di al massimo BATCH_CHUNK linee 2D.
+// depth0/depth1 (z in spazio camera degli estremi) sono NULL senza test di profondità.
+static void raster_chunk(cobra_surface *surf, const float *restrict x0, const float *restrict y0,
+                         const float *restrict x1, const float *restrict y1,
+                         const float *restrict width, const uint32_t *restrict color,
+                         const float *restrict depth0, const float *restrict depth1, int n, cobra_aa_mode aa_mode)
+{
+  const bool has_depth = depth0 && depth1;
+  line_chunk c;
+  unsigned char code0[BATCH_CHUNK], code1[BATCH_CHUNK];
+  const float max_x = (float)surf->width;
+  const float max_y = (float)surf->height;
+
+  // Passata 1: outcode rispetto alla guard band di ogni linea (branchless)
+  for (int i = 0; i < n; i++) {
+    float m = width[i] * 0.5f + 2.0f;
+    code0[i] = (unsigned char)((x0[i] < -m) | ((x0[i] >= max_x + m) << 1) |
+                               ((y0[i] < -m) << 2) | ((y0[i] >= max_y + m) << 3));
+    code1[i] = (unsigned char)((x1[i] < -m) | ((x1[i] >= max_x + m) << 1) |
+                               ((y1[i] < -m) << 2) | ((y1[i] >= max_y + m) << 3));
+  }
+
+  // Passata 2: compattazione. Scartiamo i trivial reject, clippiamo solo le linee a cavallo
+  int m = 0;
+  for (int i = 0; i < n; i++) {
+    if (code0[i] & code1[i])
+      continue;
+
+    float ax = x0[i], ay = y0[i], bx = x1[i], by = y1[i];
+    float t0 = 0.0f, t1 = 1.0f;
+    if (code0[i] | code1[i]) {
+      float gb = width[i] * 0.5f + 2.0f;
+      if (!cobra_clip_line_f(&ax, &ay, &bx, &by, -gb, -gb, max_x + gb, max_y + gb))
+        continue;
+      // Posizione dei nuovi estremi sul segmento originale (per la profondità)
+      t0 = cobra_line_param(x0[i], y0[i], x1[i], y1[i], ax, ay);
+      t1 = cobra_line_param(x0[i], y0[i], x1[i], y1[i], bx, by);
+    }
+
+    cobra_mark_dirty_line(surf, ax, ay, bx, by, width[i]);
+    c.x0[m] = ax; c.y0[m] = ay;
+    c.x1[m] = bx; c.y1[m] = by;
+    c.width[m] = width[i];
+    c.color[m] = color[i];
+    if (has_depth) {
+      // La profondità è lineare nello schermo: si interpola con i parametri del clipping
+      float za = cobra_depth_from_z(surf, depth0[i]);
+      float zb = cobra_depth_from_z(surf, depth1[i]);
+      c.z0[m] = za + (zb - za) * t0;
+      c.z1[m] = za + (zb - za) * t1;
+    }
+    m++;
+  }
+  COBRA_STAT_ADD(lines_clipped, n - m);
+
+  // Passata 3: setup (lunghezza e reciproco, blending)
+  cobra_blend blend[BATCH_CHUNK];
+  for (int i = 0; i < m; i++) {
+    float dx = c.x1[i] - c.x0[i];
+    float dy = c.y1[i] - c.y0[i];
+    c.len_sq[i] = dx * dx + dy * dy;
+    c.inv_len[i] = 1.0f / sqrtf(c.len_sq[i]);
+  }
+  for (int i = 0; i < m; i++)
+    cobra_blend_init(&blend[i], surf, c.color[i]);
+
+  // Passata 4: rasterizzazione (le linee degeneri hanno len_sq == 0)
+  cobra_rect full = {0, 0, surf->width, surf->height};
+  cobra_line_depth depth = {0.0f, 0.0f, surf->depth_func, surf->depth_write};
+  for (int i = 0; i < m; i++) {
+    if (c.len_sq[i] <= 0.0f)
+      continue;
+    depth.z0 = c.z0[i];
+    depth.z1 = c.z1[i];
+    cobra_raster_line_aa_clipped(surf, &full, c.x0[i], c.y0[i], c.x1[i], c.y1[i],
+                                 c.len_sq[i], c.inv_len[i], c.width[i], &blend[i],
+                                 has_depth ? &depth : NULL, aa_mode);
+  }
+}
+
+void cobra_window_draw_lines_aa(cobra_surface *surf, const float *x0, const float *y0,
+                                const float *x1, const float *y1, const float *width,
+                                const uint32_t *color, int count, cobra_aa_mode aa_mode)
+{
+  if (!surf || !x0 || !y0 || !x1 || !y1 || !width || !color || count <= 0)
+    return;
+
+  COBRA_SCOPE_BEGIN(scope, "lines_aa", COBRA_TIMER_RASTER);
+  cobra_submit_lines_aa(surf, x0, y0, x1, y1, width, color, NULL, NULL, count, aa_mode);
+  COBRA_SCOPE_END(scope);
+}
+
+void cobra_submit_lines_aa(cobra_surface *surf, const float *x0, const float *y0,
+                           const float *x1, const float *y1, const float *width, const uint32_t *color,
+                           const float *depth0, const float *depth1, int count, cobra_aa_mode aa_mode)
+{
+  COBRA_STAT_ADD(lines_submitted, count);
+  // In modalità differita ogni linea entra nel command buffer (il clipping avviene lì)
+  if (surf->deferred) {
+    cobra_line_depth depth;
+    for (int i = 0; i < count; i++) {
+      if (depth0 && depth1)
+        cobra_line_depth_init(&depth, surf, depth0[i], depth1[i]);
+      cobra_deferred_record_line_aa(surf, x0[i], y0[i], x1[i], y1[i], width[i], color[i],
+                                    (depth0 && depth1) ? &depth : NULL, aa_mode);
+    }
+    return;
+  }
+
+  for (int base = 0; base < count; base += BATCH_CHUNK) {
+    int n = count - base;
+    if (n > BATCH_CHUNK) n = BATCH_CHUNK;
+    raster_chunk(surf, x0 + base, y0 + base, x1 + base, y1 + base, width + base, color + base,
+                 depth0 ? depth0 + base : NULL, depth1 ? depth1 + base : NULL, n, aa_mode);
+  }
+}
+
+void cobra_window_draw_lines_3d(cobra_surface *surf, const float *x0, const float *y0, const float *z0,
+                                const float *x1, const float *y1, const float *z1, float fov,
+                                const float *thickness, const uint32_t *color, int count, bool aa, cobra_aa_mode aa_mode)
+{
+  if (!surf || !x0 || !y0 || !z0 || !x1 || !y1 || !z1 || !thickness || !color || count <= 0)
+    return;
+
+  cobra_frustum frustum;
+  cobra_frustum_init(&frustum, surf, fov, 0.0f);
+  const float half_w = (float)surf->width * 0.5f;
+  const float half_h = (float)surf->height * 0.5f;
+
+  const bool has_depth = cobra_depth_enabled(surf);
+  line_chunk c;
+  float sx0[BATCH_CHUNK], sy0[BATCH_CHUNK], sx1[BATCH_CHUNK], sy1[BATCH_CHUNK];
+  float vz0[BATCH_CHUNK], vz1[BATCH_CHUNK];
+  unsigned char code0[BATCH_CHUNK], code1[BATCH_CHUNK];
+  unsigned char visible[BATCH_CHUNK];
+  int culled = 0; // solo per le statistiche
+
+  COBRA_SCOPE_BEGIN(scope, "lines_3d", COBRA_TIMER_RASTER);
+  for (int base = 0; base < count; base += BATCH_CHUNK) {
+    int n = count - base;
+    if (n > BATCH_CHUNK) n = BATCH_CHUNK;
+
+    // Passata 1: outcode dei 6 piani del frustum (lati allargati della guard band di ogni linea),
+    // senza diramazioni
+    for (int i = 0; i < n; i++) {
+      int j = base + i;
+      float m = (aa ? thickness[j] : 1.0f) * 0.5f + 2.0f;
+      float kx = half_w + m, ky = half_h + m;
+      float ax = x0[j] * fov, ay = y0[j] * fov, az = z0[j];
+      float bx = x1[j] * fov, by = y1[j] * fov, bz = z1[j];
+      code0[i] = (unsigned char)((kx * az + ax < 0.0f) | ((kx * az - ax < 0.0f) << 1) |
+                                 ((ky * az + ay < 0.0f) << 2) | ((ky * az - ay < 0.0f) << 3) |
+                                 ((az < frustum.near_plane) << 4) | ((az > frustum.far_plane) << 5));
+      code1[i] = (unsigned char)((kx * bz + bx < 0.0f) | ((kx * bz - bx < 0.0f) << 1) |
+                                 ((ky * bz + by < 0.0f) << 2) | ((ky * bz - by < 0.0f) << 3) |
+                                 ((bz < frustum.near_plane) << 4) | ((bz > frustum.far_plane) << 5));
+    }
+
+    // Passata 2: trivial reject, clipping solo per le linee a cavallo di un piano, proiezione
+    for (int i = 0; i < n; i++) {
+      int j = base + i;
+      visible[i] = 0;
+      culled++;
+      if (code0[i] & code1[i])
+        continue;
+
+      cobra_vec3 a = {{x0[j], y0[j], z0[j]}};
+      cobra_vec3 b = {{x1[j], y1[j], z1[j]}};
+      if (code0[i] | code1[i]) {
+        float m = (aa ? thickness[j] : 1.0f) * 0.5f + 2.0f;
+        frustum.kx = half_w + m;
+        frustum.ky = half_h + m;
+        if (!cobra_frustum_clip_line(&frustum, &a, &b))
+          continue;
+      }
+      visible[i] = 1;
+      culled--;
+
+      // Stessa proiezione di cobra_vec3_project (la Y a schermo va verso il basso)
+      float inv_za = 1.0f / a.z, inv_zb = 1.0f / b.z;
+      sx0[i] = a.x * fov * inv_za + half_w;
+      sy0[i] = -a.y * fov * inv_za + half_h;
+      sx1[i] = b.x * fov * inv_zb + half_w;
+      sy1[i] = -b.y * fov * inv_zb + half_h;
+      vz0[i] = a.z;
+      vz1[i] = b.z;
+    }
+
+    if (!aa) {
+      cobra_line_depth depth;
+      for (int i = 0; i < n; i++) {
+        if (!visible[i])
+          continue;
+        if (has_depth)
+          cobra_line_depth_init(&depth, surf, vz0[i], vz1[i]);
+        cobra_submit_line(surf, (int)sx0[i], (int)sy0[i], (int)sx1[i], (int)sy1[i], color[base + i],
+                          has_depth ? &depth : NULL);
+      }
+      continue;
+    }
+
+    // Passata 3: compattazione delle linee visibili, poi percorso 2D
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+      if (!visible[i])
+        continue;
+      c.x0[m] = sx0[i]; c.y0[m] = sy0[i];
+      c.x1[m] = sx1[i]; c.y1[m] = sy1[i];
+      c.width[m] = thickness[base + i];
+      c.color[m] = color[base + i];
+      c.z0[m] = vz0[i];
+      c.z1[m] = vz1[i];
+      m++;
+    }
+
+    if (m > 0)
+      cobra_submit_lines_aa(surf, c.x0, c.y0, c.x1, c.y1, c.width, c.color,
+                            has_depth ? c.z0 : NULL, has_depth ? c.z1 : NULL, m, aa_mode);
+  }
+  COBRA_STAT_ADD(lines_culled, culled);
+  COBRA_SCOPE_END(scope);
+}
@@ -0,0 +1,413 @@
+// Scan conversion delle linee AA spesse.
+//
+// La linea è una capsula (segmento con punte tonde): una figura convessa, che taglia ogni riga
+// di pixel in un solo intervallo. Lo calcoliamo esattamente per riga, così ogni pixel coperto
+// viene visitato una volta sola:
+//   - con il raggio esterno della copertura otteniamo i pixel da valutare;
+//   - con il raggio interno i pixel a copertura piena, riempiti senza calcolarla
+//     (cobra_span_blend) quando la corsa è abbastanza lunga e non c'è test di profondità.
+// Il costo del riempimento segue quindi l'area della linea, non lunghezza x span.
+// Le linee ripide (|dy| > |dx|) si scandiscono per colonne: nel setup x e y vengono scambiate,
+// quindi lo stesso codice lavora su "righe" che sono colonne dello schermo, e gli span avanzano
+// di una riga del buffer (nel layout a tile di una riga del tile, poi al tile sotto). Così ogni
+// scan line resta lunga quanto la linea invece che quanto il suo spessore, e il setup di
+// intervallo e kernel non si paga a ogni riga.
+// Le linee singole (surface.c) e i segmenti delle polilinee (polyline.c) usano le stesse righe;
+// le polilinee tagliano i raccordi per riga e restano sempre per righe.
+// I kernel dei pixel (SDF in span.c, RGSS qui) sono specializzati per blending, colore opaco,
+// profondità e layout e vengono scelti una volta per linea nel setup: niente diramazioni sullo
+// stato della linea per pixel. Il clipping avviene sugli intervalli di ogni riga, quindi nessun
+// kernel controlla i bordi dello schermo.
+
+#include "internal.h"
+#include <math.h>
+
+// Sotto questa lunghezza la parte piena di una riga resta nel kernel di copertura: spezzare
+// la riga in tre chiamate costerebbe più del calcolo risparmiato
+#define CAPSULE_SOLID_MIN 16
+// Granularità dei bordi: un multiplo dei lane SIMD, così il kernel lavora a vettori pieni
+#define CAPSULE_EDGE_BLOCK 8
+// Margine sugli estremi degli intervalli contro gli arrotondamenti: l'intervallo esterno si
+// allarga (il kernel dà copertura nulla ai pixel in più), quello pieno si restringe
+#define CAPSULE_EPS 1e-3f
+// Distanza massima dei campioni RGSS dal centro del pixel: sqrt(0.375^2 + 0.125^2)
+#define RGSS_REACH 0.3953f
+
+// Posizioni dei campioni RGSS (Rotated Grid Supersampling) rispetto al centro del pixel:
+// 4 campioni ottimizzati invece di 16, qualità comparabile ma molto più veloce
+static const float rgss[4][2] = {
+    {-0.375f, -0.125f}, {0.125f, -0.375f},
+    {-0.125f,  0.375f}, {0.375f,  0.125f}
+};
+
+static void capsule_select_ss(cobra_capsule *c);
+
+void cobra_capsule_init(cobra_capsule *c, cobra_surface *surf, float x0, float y0, float x1, float y1,
+                        float len_sq, float inv_len, float width, const cobra_blend *blend,
+                        const cobra_line_depth *depth, cobra_aa_mode aa_mode, bool columns)
+{
+  // Per colonne tutta la geometria è nel sistema con x e y scambiate
+  if (columns) {
+    float tmp = x0; x0 = y0; y0 = tmp;
+    tmp = x1; x1 = y1; y1 = tmp;
+  }
+  float fdx = x1 - x0;
+  float fdy = y1 - y0;
+  float inv_len_sq = inv_len * inv_len;
+  float radius = width * 0.5f;
+
+  c->surf = surf;
+  c->x0 = x0; c->y0 = y0; c->x1 = x1; c->y1 = y1;
+  // Gradienti: quanto cambiano t (lungo la linea) e d (perpendicolare) per ogni passo di 1px in X e Y
+  c->dt_dx = fdx * inv_len_sq;
+  c->dt_dy = fdy * inv_len_sq;
+  c->dd_dx = -fdy * inv_len;
+  c->dd_dy =  fdx * inv_len;
+  c->inv_dt_dx = c->dt_dx != 0.0f ? 1.0f / c->dt_dx : 0.0f;
+  c->inv_dd_dx = c->dd_dx != 0.0f ? 1.0f / c->dd_dx : 0.0f;
+
+  // Soglie per AA al quadrato (per evitare sqrtf)
+  // r_in: raggio interno (alpha=1), r_out: raggio esterno (alpha=0)
+  float r_in = radius - 0.5f;
+  float r_out = radius + 0.5f;
+  float r_in_eff = (r_in > 0.0f) ? r_in : 0.0f;
+  // Epsilon per evitare buchi numerici
+  float eps = 1e-3f;
+
+  // Parametri costanti del kernel SDF: gli span seguono le righe, passo di 1px in x (le
+  // distanze non cambiano con lo scambio di x e y, d cambia solo di segno)
+  cobra_sdf_span *sdf = &c->sdf;
+  sdf->dt = c->dt_dx;
+  sdf->dd = c->dd_dx;
+  sdf->len_sq = len_sq;
+  sdf->r_in_sq = r_in_eff * r_in_eff;
+  sdf->r_out_sq = (r_out + eps) * (r_out + eps);
+  sdf->r_out = r_out;
+  // LUT e BOX sostituiscono soglie e copertura della fascia AA
+  cobra_span_setup_coverage(sdf, aa_mode, radius, fdx * inv_len, fdy * inv_len, len_sq * inv_len);
+  sdf->blend = *blend;
+  // Profondità interpolata con t (limitato al segmento: le punte hanno la z dell'estremo)
+  c->depth = depth;
+  c->z_buffer = depth ? surf->z_buffer : NULL;
+  if (depth) {
+    sdf->z0 = depth->z0;
+    sdf->dz = depth->z1 - depth->z0;
+    sdf->depth_func = depth->func;
+    sdf->depth_write = depth->write;
+  }
+  // Pixel consecutivi di uno span: accanto sulla riga o, per colonne, sulla riga sotto.
+  // Nel layout a tile il kernel passa al tile successivo (a destra o sotto) ogni COBRA_FB_TILE pixel.
+  c->columns = columns;
+  c->stride = columns ? (surf->tiled ? COBRA_FB_TILE : surf->width) : 1;
+  sdf->tile_jump = surf->tiled ? (long)COBRA_FB_TILE * COBRA_FB_TILE * (columns ? surf->tiles_x : 1) : 0;
+  sdf->tile_pos = 0;
+  c->radius = radius;
+  bool ss = aa_mode == COBRA_AA_SS;
+  c->span = cobra_span_select(sdf, depth != NULL);
+  c->ss = NULL;
+  if (ss) {
+    // Anche i campioni vanno scambiati: restano negli stessi punti dello schermo
+    int sx = columns ? 1 : 0;
+    for (int i = 0; i < 4; i++) {
+      c->ss_dt[i] = rgss[i][sx] * c->dt_dx + rgss[i][1 - sx] * c->dt_dy;
+      c->ss_dd[i] = rgss[i][sx] * c->dd_dx + rgss[i][1 - sx] * c->dd_dy;
+    }
+    capsule_select_ss(c);
+  }
+
+  // Raggi delle due capsule: fin dove la copertura può essere non nulla e dove è sicuramente
+  // piena. Il supersampling vede la capsula vera solo attraverso i suoi 4 campioni.
+  c->r_edge = ss ? radius + RGSS_REACH : sqrtf(sdf->r_out_sq);
+  c->r_solid = ss ? radius - RGSS_REACH : sqrtf(sdf->r_in_sq);
+  // Con il test di profondità ogni pixel passa dal kernel (la z cambia lungo la riga)
+  if (depth)
+    c->r_solid = 0.0f;
+}
+
+// Restringe [*lo, *hi] agli u con vmin <= k * u + c <= vmax (inv_k = 1 / k).
+// Con k nullo il vincolo non dipende da u: false se non è soddisfatto.
+static inline bool capsule_slab(float k, float inv_k, float c, float vmin, float vmax, float *lo, float *hi)
+{
+  if (k == 0.0f)
+    return c >= vmin && c <= vmax;
+  float a = (vmin - c) * inv_k;
+  float b = (vmax - c) * inv_k;
+  if (a > b) { float tmp = a; a = b; b = tmp; }
+  if (a > *lo) *lo = a;
+  if (b < *hi) *hi = b;
+  return true;
+}
+
+// Intervallo [*lo, *hi] della riga y = yc dentro la capsula di raggio r: unione dei tagli dei
+// due dischi degli estremi e della striscia del corpo (0 <= t <= 1, |d| <= r). false se vuoto.
+static bool capsule_row(const cobra_capsule *c, float yc, float r, float *lo, float *hi)
+{
+  float l = INFINITY, h = -INFINITY;
+  float r_sq = r * r;
+
+  float ry = yc - c->y0;
+  if (ry * ry <= r_sq) {
+    float w = sqrtf(r_sq - ry * ry);
+    l = c->x0 - w;
+    h = c->x0 + w;
+  }
+  float ry1 = yc - c->y1;
+  if (ry1 * ry1 <= r_sq) {
+    float w = sqrtf(r_sq - ry1 * ry1);
+    l = fminf(l, c->x1 - w);
+    h = fmaxf(h, c->x1 + w);
+  }
+
+  // Lungo la riga t e d sono lineari in x (u = x - x0)
+  float sl = -INFINITY, sh = INFINITY;
+  if (capsule_slab(c->dt_dx, c->inv_dt_dx, ry * c->dt_dy, 0.0f, 1.0f, &sl, &sh) &&
+      capsule_slab(c->dd_dx, c->inv_dd_dx, ry * c->dd_dy, -r, r, &sl, &sh) && sl <= sh) {
+    l = fminf(l, c->x0 + sl);
+    h = fmaxf(h, c->x0 + sh);
+  }
+
+  *lo = l;
+  *hi = h;
+  return l <= h;
+}
+
+// Colonne dei pixel con il centro in [lo, hi], limitate a [cx0, cx1)
+static inline bool capsule_span_cols(float lo, float hi, int cx0, int cx1, int *xa, int *xb)
+{
+  float fa = ceilf(lo - 0.5f);
+  float fb = floorf(hi - 0.5f);
+  *xa = fa < (float)cx0 ? cx0 : (int)fa;
+  *xb = fb > (float)(cx1 - 1) ? cx1 - 1 : (int)fb;
+  return *xa <= *xb;
+}
+
+bool cobra_capsule_rows(const cobra_capsule *c, const cobra_rect *clip, int *ya, int *yb)
+{
+  // Righe con il centro dentro la capsula esterna
+  int a = (int)ceilf(fminf(c->y0, c->y1) - c->r_edge - 0.5f);
+  int b = (int)floorf(fmaxf(c->y0, c->y1) + c->r_edge - 0.5f);
+  int lo = c->columns ? clip->x0 : clip->y0;
+  int hi = c->columns ? clip->x1 : clip->y1;
+  if (a < lo) a = lo;
+  if (b > hi - 1) b = hi - 1;
+  *ya = a;
+  *yb = b;
+  return a <= b;
+}
+
+bool cobra_capsule_cols(const cobra_capsule *c, int y, int cx0, int cx1, int *xa, int *xb)
+{
+  float lo, hi;
+  return capsule_row(c, (float)y + 0.5f, c->r_edge + CAPSULE_EPS, &lo, &hi) &&
+         capsule_span_cols(lo, hi, cx0, cx1, xa, xb);
+}
+
+void cobra_capsule_raster(cobra_capsule *c, const cobra_rect *clip)
+{
+  int ya, yb;
+  if (!cobra_capsule_rows(c, clip, &ya, &yb))
+    return;
+  int ca = c->columns ? clip->y0 : clip->x0;
+  int cb = c->columns ? clip->y1 : clip->x1;
+  for (int y = ya; y <= yb; y++) {
+    int xa, xb;
+    if (cobra_capsule_cols(c, y, ca, cb, &xa, &xb))
+      cobra_capsule_shade(c, y, xa, xb);
+  }
+}
+
+// Indice nel buffer del pixel x della riga y della capsula (per colonne: colonna y, riga x)
+static inline long capsule_index(const cobra_capsule *c, int y, int x)
+{
+  return c->columns ? cobra_pixel_index(c->surf, y, x) : cobra_pixel_index(c->surf, x, y);
+}
+
+// Copertura piena di 'count' pixel distanti 'stride' (tratto di colonna): gli stessi risultati
+// di cobra_span_blend, un pixel alla volta
+static void capsule_fill_column(uint32_t *p, int count, int stride, const cobra_blend *b)
+{
+  switch (b->mode) {
+  case COBRA_BLEND_ADDITIVE:
+    for (int k = 0; k < count; k++, p += stride)
+      cobra_blend_additive(p, b, 256);
+    break;
+  case COBRA_BLEND_MAX:
+    for (int k = 0; k < count; k++, p += stride)
+      cobra_blend_max(p, b, 256);
+    break;
+  default:
+    if (b->alpha >= 256) {
+      for (int k = 0; k < count; k++, p += stride)
+        *p = b->color;
+    } else {
+      for (int k = 0; k < count; k++, p += stride)
+        cobra_blend_over(p, b, 256);
+    }
+    break;
+  }
+}
+
+// Copertura piena dei pixel da xa a xb (inclusi) della riga y
+static void capsule_fill(const cobra_capsule *c, int y, int xa, int xb)
+{
+  cobra_surface *surf = c->surf;
+  COBRA_STAT_ADD(pixels_evaluated, xb - xa + 1);
+  COBRA_STAT_ADD(pixels_blended, xb - xa + 1);
+  // Nel layout a tile lo span ha passo costante solo dentro un tile
+  while (xa <= xb) {
+    int end = surf->tiled ? (xa | (COBRA_FB_TILE - 1)) : xb;
+    if (end > xb) end = xb;
+    uint32_t *p = &surf->color_buffer[capsule_index(c, y, xa)];
+    if (c->columns)
+      capsule_fill_column(p, end - xa + 1, c->stride, &c->sdf.blend);
+    else
+      cobra_span_blend(p, end - xa + 1, &c->sdf.blend);
+    xa = end + 1;
+  }
+}
+
+// Supersampling RGSS dei pixel da xa a xb della riga y. Il corpo viene espanso per ogni
+// combinazione di blending, colore opaco, profondità e layout (vedi capsule_select_ss).
+static inline __attribute__((always_inline)) void
+capsule_span_ss(const cobra_capsule *c, int y, float t_iter, float d_iter, int xa, int xb,
+                cobra_blend_mode mode, bool opaque, bool depth, bool tiled)
+{
+  cobra_surface *surf = c->surf;
+  uint32_t *color_buffer = surf->color_buffer;
+  float *z_buffer = c->z_buffer;
+  const cobra_blend blend = c->sdf.blend;
+  const float dt_dx = c->dt_dx, dd_dx = c->dd_dx;
+  const float r_sq = c->radius * c->radius, len_sq = c->sdf.len_sq;
+  // I campi di profondità di c->sdf sono validi solo con il test
+  const float z0 = depth ? c->sdf.z0 : 0.0f, dz = depth ? c->sdf.dz : 0.0f;
+  const cobra_depth_func func = depth ? c->sdf.depth_func : COBRA_DEPTH_ALWAYS;
+  const bool write = depth && c->sdf.depth_write;
+  // Copie locali: le scritture nello z_buffer non possono modificarle
+  float ss_dt[4], ss_dd[4];
+  for (int i = 0; i < 4; i++) {
+    ss_dt[i] = c->ss_dt[i];
+    ss_dd[i] = c->ss_dd[i];
+  }
+  const long first = capsule_index(c, y, xa);
+  const long jump = c->sdf.tile_jump;
+  const int stride = c->stride, tile_pos = xa & (COBRA_FB_TILE - 1);
+
+  int blended = 0;
+  for (int k = 0; k <= xb - xa; k++, t_iter += dt_dx, d_iter += dd_dx) {
+    long idx = first + cobra_span_offset(tiled, jump, tile_pos, stride, k);
+    float z = 0.0f;
+    if (depth) {
+      // Test di profondità anticipato, prima dei 4 campioni
+      float tc = t_iter < 0.0f ? 0.0f : (t_iter > 1.0f ? 1.0f : t_iter);
+      z = z0 + tc * dz;
+      if (!cobra_depth_test(func, z, z_buffer[idx]))
+        continue;
+    }
+
+    int hits = 0;
+    for (int i = 0; i < 4; i++) {
+      // t e d del campione
+      float t_sub = t_iter + ss_dt[i];
+      float d_sub = d_iter + ss_dd[i];
+      float tc = t_sub < 0.0f ? 0.0f : (t_sub > 1.0f ? 1.0f : t_sub);
+      float dtc = t_sub - tc;
+      hits += d_sub * d_sub + dtc * dtc * len_sq <= r_sq;
+    }
+    if (!hits)
+      continue;
+
+    blended++;
+    if (depth && write && hits >= 2)
+      z_buffer[idx] = z;
+    uint32_t cov = (uint32_t)hits * 64u; // hits / 4 in 0..256
+    uint32_t *p = &color_buffer[idx];
+    switch (mode) {
+    case COBRA_BLEND_ADDITIVE: cobra_blend_additive(p, &blend, cov); break;
+    case COBRA_BLEND_MAX:      cobra_blend_max(p, &blend, cov); break;
+    default:
+      // Con alpha 256 il fattore dello sfondo è 256 - cov (cobra_blend_over senza il prodotto)
+      if (opaque)
+        *p = cov >= 256 ? blend.color : cobra_swar_adds(cobra_swar_scale(blend.color, cov), cobra_swar_scale(*p, 256 - cov));
+      else
+        cobra_blend_over(p, &blend, cov);
+      break;
+    }
+  }
+  COBRA_STAT_ADD(pixels_evaluated, xb - xa + 1);
+  COBRA_STAT_ADD(pixels_blended, blended);
+}
+
+#define CAPSULE_SS_KERNEL(name, mode, opaque, depth, tiled)                                           \
+  static void name(const cobra_capsule *c, int y, float t, float d, int xa, int xb)                  \
+  {                                                                                                  \
+    capsule_span_ss(c, y, t, d, xa, xb, mode, opaque, depth, tiled);                                 \
+  }
+
+#define CAPSULE_SS_KERNELS(name, mode, opaque)                                                       \
+  CAPSULE_SS_KERNEL(name##_linear, mode, opaque, false, false)                                       \
+  CAPSULE_SS_KERNEL(name##_linear_depth, mode, opaque, true, false)                                  \
+  CAPSULE_SS_KERNEL(name##_tiled, mode, opaque, false, true)                                         \
+  CAPSULE_SS_KERNEL(name##_tiled_depth, mode, opaque, true, true)
+
+CAPSULE_SS_KERNELS(ss_over, COBRA_BLEND_OVER, false)
+CAPSULE_SS_KERNELS(ss_opaque, COBRA_BLEND_OVER, true)
+CAPSULE_SS_KERNELS(ss_additive, COBRA_BLEND_ADDITIVE, false)
+CAPSULE_SS_KERNELS(ss_max, COBRA_BLEND_MAX, false)
+
+#define CAPSULE_SS_ROW(name) {name##_linear, name##_linear_depth, name##_tiled, name##_tiled_depth}
+
+static void capsule_select_ss(cobra_capsule *c)
+{
+  // [blending][tiled * 2 + depth], nello stesso ordine di cobra_span_select
+  static void (*const kernels[4][4])(const cobra_capsule *, int, float, float, int, int) = {
+      CAPSULE_SS_ROW(ss_over), CAPSULE_SS_ROW(ss_opaque), CAPSULE_SS_ROW(ss_additive), CAPSULE_SS_ROW(ss_max),
+  };
+  int mode;
+  switch (c->sdf.blend.mode) {
+  case COBRA_BLEND_ADDITIVE: mode = 2; break;
+  case COBRA_BLEND_MAX:      mode = 3; break;
+  default:                   mode = c->sdf.blend.alpha >= 256 ? 1 : 0; break;
+  }
+  c->ss = kernels[mode][(c->surf->tiled ? 2 : 0) + (c->depth ? 1 : 0)];
+}
+
+void cobra_capsule_span(cobra_capsule *c, int y, int xa, int xb)
+{
+  if (xa > xb)
+    return;
+  // t e d al centro del primo pixel, calcolati da capo a ogni span: niente errore accumulato
+  float rx = ((float)xa + 0.5f) - c->x0;
+  float ry = ((float)y + 0.5f) - c->y0;
+  float t0 = rx * c->dt_dx + ry * c->dt_dy;
+  float d0 = rx * c->dd_dx + ry * c->dd_dy;
+  if (c->ss) {
+    c->ss(c, y, t0, d0, xa, xb);
+    return;
+  }
+  c->sdf.t0 = t0;
+  c->sdf.d0 = d0;
+  c->sdf.tile_pos = xa & (COBRA_FB_TILE - 1);
+  long idx = capsule_index(c, y, xa);
+  c->span(&c->surf->color_buffer[idx], c->z_buffer ? &c->z_buffer[idx] : NULL, c->stride, xb - xa + 1, &c->sdf);
+}
+
+void cobra_capsule_shade(cobra_capsule *c, int y, int xa, int xb)
+{
+  // Bordo sinistro, interno a copertura piena (senza calcolarla), bordo destro.
+  // I bordi si allungano verso l'interno a blocchi interi di CAPSULE_EDGE_BLOCK pixel.
+  float lo, hi;
+  int fa, fb;
+  if (c->r_solid > CAPSULE_EPS && xb - xa + 1 >= CAPSULE_SOLID_MIN &&
+      capsule_row(c, (float)y + 0.5f, c->r_solid - CAPSULE_EPS, &lo, &hi) &&
+      capsule_span_cols(lo, hi, xa, xb + 1, &fa, &fb)) {
+    fa = xa + ((fa - xa + CAPSULE_EDGE_BLOCK - 1) & ~(CAPSULE_EDGE_BLOCK - 1));
+    fb = xb - ((xb - fb + CAPSULE_EDGE_BLOCK - 1) & ~(CAPSULE_EDGE_BLOCK - 1));
+    if (fb - fa + 1 >= CAPSULE_SOLID_MIN) {
+      cobra_capsule_span(c, y, xa, fa - 1);
+      capsule_fill(c, y, fa, fb);
+      cobra_capsule_span(c, y, fb + 1, xb);
+      return;
+    }
+  }
+  cobra_capsule_span(c, y, xa, xb);
+}
@@ -0,0 +1,440 @@
+// Rasterizzazione differita e multithread delle linee AA.
+//
+// Le chiamate a cobra_window_draw_line_aa vengono registrate in un command buffer preso
+// dall'arena per frame della superficie (niente malloc per registrazione o per flush).
+// Al flush:
+//   1. Binning: ogni comando viene assegnato ai tile coperti dal suo bounding box
+//      (guard band compresa). Il binning è un counting sort stabile, quindi dentro
+//      ogni tile i comandi restano nell'ordine di registrazione.
+//   2. Rasterizzazione: i thread prendono i tile da un contatore atomico (un tile per task)
+//      e disegnano solo i pixel del proprio tile. Nessun lock sul color_buffer.
+
+#define _POSIX_C_SOURCE 200809L
+#include "cobragl/surface.h"
+#include "internal.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+typedef struct {
+  cobra_stroke_seg seg; // estremi (e vertici vicini se stroke)
+  float width;
+  cobra_blend blend; // preparato alla registrazione: vale lo stato di blending di quel momento
+  cobra_line_depth depth; // profondità degli estremi registrati (solo se has_depth)
+  bool has_depth;
+  cobra_aa_mode aa_mode;
+  bool stroke;            // segmento di polilinea (cobra_raster_stroke)
+  cobra_line_join join;
+} cobra_line_cmd;
+
+// Capacità iniziale del command buffer in ogni frame
+#define DEFERRED_MIN_CMDS 1024
+
+struct cobra_deferred {
+  cobra_surface *surf;
+
+  // Command buffer (nell'arena della superficie: vive fino alla fine del frame)
+  cobra_arena_buf cmd_buf;
+  cobra_line_cmd *cmds;
+  int cmd_count;
+  bool depth_pending; // qualche comando in attesa scrive lo z_buffer
+
+  // Binning: per ogni tile, l'intervallo [tile_start[t], tile_start[t+1]) in tile_cmds
+  int tiles_x, tiles_y;
+  int *tile_start;
+  cobra_arena_buf tile_buf;
+  int *tile_cmds;
+
+  // Pool di thread
+  pthread_t *threads;
+  int num_workers; // thread creati (il chiamante è un thread in più)
+  pthread_mutex_t lock;
+  pthread_cond_t work_cv;
+  pthread_cond_t done_cv;
+  unsigned generation; // incrementato a ogni flush per svegliare i worker
+  int busy_workers;
+  int next_tile;       // contatore atomico dei tile da assegnare
+  bool quit;
+};
+
+static void raster_cmd(cobra_surface *surf, const cobra_rect *clip, const cobra_line_cmd *c)
+{
+  const cobra_line_depth *depth = c->has_depth ? &c->depth : NULL;
+  const cobra_stroke_seg *s = &c->seg;
+  if (c->stroke) {
+    // I raccordi si ricalcolano dai vertici: stessi float dei segmenti vicini, stessi confini
+    cobra_stroke_joint start, end;
+    if (s->has_prev)
+      cobra_stroke_joint_init(&start, s->px, s->py, s->x0, s->y0, s->x1, s->y1, c->width, c->join);
+    if (s->has_next)
+      cobra_stroke_joint_init(&end, s->x0, s->y0, s->x1, s->y1, s->nx, s->ny, c->width, c->join);
+    cobra_raster_stroke(surf, clip, s->x0, s->y0, s->x1, s->y1, s->has_prev ? &start : NULL,
+                        s->has_next ? &end : NULL, c->width, &c->blend, depth, c->aa_mode);
+  } else {
+    cobra_raster_line_aa(surf, clip, s->x0, s->y0, s->x1, s->y1, c->width, &c->blend, depth, c->aa_mode);
+  }
+}
+
+// Rasterizza tutti i comandi assegnati a un tile, nell'ordine di registrazione
+static void raster_tile(struct cobra_deferred *def, int tile)
+{
+  int first = def->tile_start[tile];
+  int last = def->tile_start[tile + 1];
+  if (first == last)
+    return;
+
+  cobra_surface *surf = def->surf;
+  int tx = tile % def->tiles_x;
+  int ty = tile / def->tiles_x;
+  cobra_rect clip = {
+    tx * COBRA_TILE_SIZE, ty * COBRA_TILE_SIZE,
+    (tx + 1) * COBRA_TILE_SIZE, (ty + 1) * COBRA_TILE_SIZE
+  };
+  if (clip.x1 > surf->width) clip.x1 = surf->width;
+  if (clip.y1 > surf->height) clip.y1 = surf->height;
+
+  // Un evento di traccia per tile: mostra il bilanciamento del carico tra i thread
+  COBRA_SCOPE_BEGIN(scope, "tile", COBRA_TIMER_NONE);
+  for (int i = first; i < last; i++)
+    raster_cmd(surf, &clip, &def->cmds[def->tile_cmds[i]]);
+  COBRA_SCOPE_END(scope);
+}
+
+// Consuma tile finché ce ne sono (chiamato sia dai worker che dal thread principale)
+static void drain_tiles(struct cobra_deferred *def)
+{
+  int num_tiles = def->tiles_x * def->tiles_y;
+  for (;;) {
+    int tile = __atomic_fetch_add(&def->next_tile, 1, __ATOMIC_RELAXED);
+    if (tile >= num_tiles)
+      break;
+    raster_tile(def, tile);
+  }
+}
+
+static void *worker_main(void *arg)
+{
+  struct cobra_deferred *def = (struct cobra_deferred *)arg;
+  unsigned seen = 0;
+
+  pthread_mutex_lock(&def->lock);
+  for (;;) {
+    while (!def->quit && def->generation == seen)
+      pthread_cond_wait(&def->work_cv, &def->lock);
+    if (def->quit)
+      break;
+    seen = def->generation;
+    pthread_mutex_unlock(&def->lock);
+
+    drain_tiles(def);
+
+    pthread_mutex_lock(&def->lock);
+    if (--def->busy_workers == 0)
+      pthread_cond_signal(&def->done_cv);
+  }
+  pthread_mutex_unlock(&def->lock);
+  return NULL;
+}
+
+bool cobra_surface_enable_deferred(cobra_surface *surf, int num_threads)
+{
+  if (!surf || !surf->color_buffer)
+    return false;
+  if (surf->deferred)
+    return true;
+
+  if (num_threads <= 0) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = (cores > 0) ? (int)cores : 1;
+  }
+
+  struct cobra_deferred *def = (struct cobra_deferred *)calloc(1, sizeof(*def));
+  if (!def)
+    return false;
+
+  def->surf = surf;
+  def->tiles_x = (surf->width + COBRA_TILE_SIZE - 1) / COBRA_TILE_SIZE;
+  def->tiles_y = (surf->height + COBRA_TILE_SIZE - 1) / COBRA_TILE_SIZE;
+  def->tile_start = (int *)malloc(sizeof(int) * (def->tiles_x * def->tiles_y + 1));
+  if (!def->tile_start) {
+    free(def);
+    return false;
+  }
+
+  pthread_mutex_init(&def->lock, NULL);
+  pthread_cond_init(&def->work_cv, NULL);
+  pthread_cond_init(&def->done_cv, NULL);
+
+  if (num_threads > 1) {
+    def->threads = (pthread_t *)malloc(sizeof(pthread_t) * (num_threads - 1));
+    if (def->threads) {
+      for (int i = 0; i < num_threads - 1; i++) {
+        if (pthread_create(&def->threads[i], NULL, worker_main, def) != 0) {
+          fprintf(stderr, "Errore creazione thread di rasterizzazione.\n");
+          break;
+        }
+        def->num_workers++;
+      }
+    }
+  }
+
+  surf->deferred = def;
+  return true;
+}
+
+// Accoda un comando al command buffer del frame
+static void record_cmd(cobra_surface *surf, struct cobra_deferred *def, const cobra_line_cmd *cmd)
+{
+  // Il primo comando del frame riserva spazio per DEFERRED_MIN_CMDS: le crescite successive
+  // raddoppiano (sul posto se il buffer è l'ultima allocazione dell'arena)
+  int want = def->cmd_count < DEFERRED_MIN_CMDS ? DEFERRED_MIN_CMDS : def->cmd_count + 1;
+  cobra_line_cmd *cmds = (cobra_line_cmd *)cobra_arena_reserve(&surf->arena, &def->cmd_buf,
+                                                               sizeof(cobra_line_cmd) * want, true);
+  if (!cmds) {
+    // Memoria esaurita: disegniamo quanto registrato finora e questa linea in modo immediato
+    cobra_surface_flush(surf);
+    cobra_rect full = {0, 0, surf->width, surf->height};
+    raster_cmd(surf, &full, cmd);
+    return;
+  }
+  def->cmds = cmds;
+  def->cmds[def->cmd_count++] = *cmd;
+  if (cmd->has_depth && cmd->depth.write)
+    def->depth_pending = true;
+}
+
+void cobra_deferred_record_line_aa(cobra_surface *surf, float x0, float y0, float x1, float y1,
+                                   float width, uint32_t color, const cobra_line_depth *depth, cobra_aa_mode aa_mode)
+{
+  struct cobra_deferred *def = surf->deferred;
+
+  // Scartiamo subito ciò che è fuori dalla guard band dello schermo:
+  // non occupa il command buffer e riduce il bounding box delle linee enormi.
+  float ox0 = x0, oy0 = y0, ox1 = x1, oy1 = y1;
+  float gb_margin = width * 0.5f + 2.0f;
+  if (!cobra_clip_line_f(&x0, &y0, &x1, &y1, -gb_margin, -gb_margin,
+                         (float)surf->width + gb_margin, (float)surf->height + gb_margin)) {
+    COBRA_STAT_ADD(lines_clipped, 1);
+    return;
+  }
+
+  cobra_line_depth clipped_depth;
+  if (depth) {
+    clipped_depth = *depth;
+    cobra_line_depth_clip(&clipped_depth, ox0, oy0, ox1, oy1, x0, y0, x1, y1);
+    depth = &clipped_depth;
+  }
+
+  cobra_mark_dirty_line(surf, x0, y0, x1, y1, width);
+
+  cobra_line_cmd cmd = {0};
+  cmd.seg.x0 = x0; cmd.seg.y0 = y0;
+  cmd.seg.x1 = x1; cmd.seg.y1 = y1;
+  cmd.width = width;
+  cobra_blend_init(&cmd.blend, surf, color);
+  cmd.has_depth = depth != NULL;
+  if (depth)
+    cmd.depth = *depth;
+  cmd.aa_mode = aa_mode;
+  record_cmd(surf, def, &cmd);
+}
+
+void cobra_deferred_record_stroke(cobra_surface *surf, const cobra_stroke_seg *seg, float width,
+                                  cobra_line_join join, const cobra_blend *blend,
+                                  const cobra_line_depth *depth, cobra_aa_mode aa_mode)
+{
+  struct cobra_deferred *def = surf->deferred;
+
+  // Il segmento resta intero (i raccordi dipendono dai vertici originali): la guard band
+  // dello schermo serve solo a scartarlo e a limitare l'area toccata
+  float x0 = seg->x0, y0 = seg->y0, x1 = seg->x1, y1 = seg->y1;
+  float reach = cobra_stroke_reach(width, join);
+  float gb_margin = reach + 2.0f;
+  if (!cobra_clip_line_f(&x0, &y0, &x1, &y1, -gb_margin, -gb_margin,
+                         (float)surf->width + gb_margin, (float)surf->height + gb_margin)) {
+    COBRA_STAT_ADD(lines_clipped, 1);
+    return;
+  }
+  cobra_mark_dirty_line(surf, x0, y0, x1, y1, 2.0f * reach);
+
+  cobra_line_cmd cmd = {0};
+  cmd.seg = *seg;
+  cmd.width = width;
+  cmd.blend = *blend;
+  cmd.has_depth = depth != NULL;
+  if (depth)
+    cmd.depth = *depth;
+  cmd.aa_mode = aa_mode;
+  cmd.stroke = true;
+  cmd.join = join;
+  record_cmd(surf, def, &cmd);
+}
+
+// Intervallo di tile coperto dal bounding box (guard band compresa) di un comando.
+// Restituisce false se il box non interseca lo schermo.
+static bool cmd_tile_range(const struct cobra_deferred *def, const cobra_line_cmd *c,
+                           int *tx0, int *ty0, int *tx1, int *ty1)
+{
+  const cobra_stroke_seg *s = &c->seg;
+  float margin = (c->stroke ? cobra_stroke_reach(c->width, c->join) : c->width * 0.5f) + 2.0f;
+  float min_x = fminf(s->x0, s->x1) - margin, max_x = fmaxf(s->x0, s->x1) + margin;
+  float min_y = fminf(s->y0, s->y1) - margin, max_y = fmaxf(s->y0, s->y1) + margin;
+  // I segmenti delle polilinee non sono tagliati: il box va limitato prima di convertirlo
+  float lim_x = (float)(def->tiles_x * COBRA_TILE_SIZE), lim_y = (float)(def->tiles_y * COBRA_TILE_SIZE);
+  if (max_x < 0.0f || max_y < 0.0f || min_x >= lim_x || min_y >= lim_y)
+    return false;
+  min_x = fmaxf(min_x, 0.0f);
+  min_y = fmaxf(min_y, 0.0f);
+  max_x = fminf(max_x, lim_x);
+  max_y = fminf(max_y, lim_y);
+
+  int x0 = (int)floorf(min_x) / COBRA_TILE_SIZE;
+  int y0 = (int)floorf(min_y) / COBRA_TILE_SIZE;
+  int x1 = (int)floorf(max_x) / COBRA_TILE_SIZE;
+  int y1 = (int)floorf(max_y) / COBRA_TILE_SIZE;
+
+  if (x1 >= def->tiles_x) x1 = def->tiles_x - 1;
+  if (y1 >= def->tiles_y) y1 = def->tiles_y - 1;
+  if (x0 > x1 || y0 > y1)
+    return false;
+
+  *tx0 = x0; *ty0 = y0; *tx1 = x1; *ty1 = y1;
+  return true;
+}
+
+// Counting sort stabile dei comandi nei tile
+static bool bin_commands(struct cobra_deferred *def)
+{
+  int num_tiles = def->tiles_x * def->tiles_y;
+  int *count = def->tile_start;
+  memset(count, 0, sizeof(int) * (num_tiles + 1));
+
+  // 1. Conteggio dei riferimenti per tile
+  int total = 0;
+  for (int i = 0; i < def->cmd_count; i++) {
+    int tx0, ty0, tx1, ty1;
+    if (!cmd_tile_range(def, &def->cmds[i], &tx0, &ty0, &tx1, &ty1))
+      continue;
+    for (int ty = ty0; ty <= ty1; ty++)
+      for (int tx = tx0; tx <= tx1; tx++)
+        count[ty * def->tiles_x + tx + 1]++;
+    total += (tx1 - tx0 + 1) * (ty1 - ty0 + 1);
+  }
+
+  def->tile_cmds = (int *)cobra_arena_reserve(&def->surf->arena, &def->tile_buf, sizeof(int) * total, false);
+  if (!def->tile_cmds)
+    return false;
+
+  // 2. Prefix sum: count[t] diventa l'offset di inizio del tile t
+  for (int t = 0; t < num_tiles; t++)
+    count[t + 1] += count[t];
+
+  // 3. Riempimento in ordine di registrazione (count[t] avanza fino all'inizio del tile t+1)
+  for (int i = 0; i < def->cmd_count; i++) {
+    int tx0, ty0, tx1, ty1;
+    if (!cmd_tile_range(def, &def->cmds[i], &tx0, &ty0, &tx1, &ty1))
+      continue;
+    for (int ty = ty0; ty <= ty1; ty++)
+      for (int tx = tx0; tx <= tx1; tx++)
+        def->tile_cmds[count[ty * def->tiles_x + tx]++] = i;
+  }
+
+  // 4. Lo scorrimento del punto 3 ha spostato ogni offset in avanti di un tile
+  memmove(count + 1, count, sizeof(int) * num_tiles);
+  count[0] = 0;
+  return true;
+}
+
+static void flush_commands(cobra_surface *surf, struct cobra_deferred *def)
+{
+  if (!bin_commands(def)) {
+    // Memoria esaurita per il binning: ripieghiamo sulla rasterizzazione seriale a schermo intero
+    cobra_rect full = {0, 0, surf->width, surf->height};
+    for (int i = 0; i < def->cmd_count; i++)
+      raster_cmd(surf, &full, &def->cmds[i]);
+    def->cmd_count = 0;
+    def->depth_pending = false;
+    return;
+  }
+
+  def->next_tile = 0;
+
+  if (def->num_workers > 0) {
+    pthread_mutex_lock(&def->lock);
+    def->busy_workers = def->num_workers;
+    def->generation++;
+    pthread_cond_broadcast(&def->work_cv);
+    pthread_mutex_unlock(&def->lock);
+  }
+
+  // Anche il thread chiamante partecipa alla rasterizzazione
+  drain_tiles(def);
+
+  if (def->num_workers > 0) {
+    pthread_mutex_lock(&def->lock);
+    while (def->busy_workers > 0)
+      pthread_cond_wait(&def->done_cv, &def->lock);
+    pthread_mutex_unlock(&def->lock);
+  }
+
+  def->cmd_count = 0;
+  def->depth_pending = false;
+}
+
+void cobra_surface_flush(cobra_surface *surf)
+{
+  if (!surf || !surf->deferred)
+    return;
+
+  struct cobra_deferred *def = surf->deferred;
+  if (def->cmd_count == 0)
+    return;
+
+  COBRA_SCOPE_BEGIN(scope, "flush", COBRA_TIMER_RASTER);
+  flush_commands(surf, def);
+  COBRA_SCOPE_END(scope);
+}
+
+void cobra_deferred_discard(cobra_surface *surf)
+{
+  if (surf->deferred) {
+    surf->deferred->cmd_count = 0;
+    surf->deferred->depth_pending = false;
+  }
+}
+
+bool cobra_deferred_depth_pending(const cobra_surface *surf)
+{
+  return surf->deferred && surf->deferred->depth_pending;
+}
+
+void cobra_surface_disable_deferred(cobra_surface *surf)
+{
+  if (!surf || !surf->deferred)
+    return;
+
+  struct cobra_deferred *def = surf->deferred;
+
+  // I comandi registrati devono comunque finire nel color buffer
+  cobra_surface_flush(surf);
+
+  pthread_mutex_lock(&def->lock);
+  def->quit = true;
+  pthread_cond_broadcast(&def->work_cv);
+  pthread_mutex_unlock(&def->lock);
+
+  for (int i = 0; i < def->num_workers; i++)
+    pthread_join(def->threads[i], NULL);
+
+  pthread_cond_destroy(&def->done_cv);
+  pthread_cond_destroy(&def->work_cv);
+  pthread_mutex_destroy(&def->lock);
+
+  free(def->threads);
+  free(def->tile_start);
+  free(def);
+  surf->deferred = NULL;
+}
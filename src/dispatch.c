@@ -0,0 +1,127 @@
+// Scelta a runtime della variante dei kernel (isa/*.c).
+//
+// Lo stesso binario gira su CPU diverse: i kernel caldi (clear e fill, blending a copertura
+// piena, trasformazione dei vertici, span SDF delle linee AA, blocchi dei triangoli, proiezione
+// dei punti) sono compilati per scalar, sse2, avx2 e avx512, e qui scegliamo la variante più
+// larga supportata dalla CPU (cpuid, tramite __builtin_cpu_supports). Span, triangoli e punti
+// usano al più 8 lane: nella variante avx512 sono quelli avx2.
+// La variabile d'ambiente COBRA_SIMD forza una variante (scalar, sse2, avx2, avx512) per i
+// test e i confronti: se la CPU non la supporta viene ignorata.
+// La scelta avviene una sola volta, in cobra_surface_create / cobra_window_create o alla prima
+// chiamata di un kernel se arriva prima (cobra_transform_points è usabile senza superficie).
+// Fino ad allora span, triangoli e punti puntano alla variante scalare: stessi risultati, e
+// senza una superficie non vengono comunque chiamati.
+
+#define _POSIX_C_SOURCE 200809L
+#include "internal.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// X(variante, variante dei kernel di rasterizzazione)
+#if defined(__x86_64__) || defined(__i386__)
+#define COBRA_ISA_X86 1
+#define COBRA_ISA_LIST(X) X(scalar, scalar) X(sse2, sse2) X(avx2, avx2) X(avx512, avx2)
+#else
+#define COBRA_ISA_LIST(X) X(scalar, scalar)
+#endif
+
+// Dichiarazioni e tabella di ogni variante
+#define COBRA_ISA_DECLARE(isa, raster)                                                             \
+  void cobra_span_fill_##isa(uint32_t *dst, long count, uint32_t value, bool stream);             \
+  void cobra_span_blend_##isa(uint32_t *dst, int count, const cobra_blend *b);                    \
+  void cobra_transform_points_##isa(const cobra_mat4 *m, const c_float *x, const c_float *y,      \
+                                    const c_float *z, c_float *out_x, c_float *out_y,             \
+                                    c_float *out_z, c_float *out_w, int count);                   \
+  extern const cobra_span_kernel cobra_span_kernels_##raster[3][4][4];                            \
+  extern const cobra_tri_kernel cobra_tri_kernels_##raster[3][2];                                 \
+  int cobra_project_points_##raster(const cobra_point_view *v, cobra_point_chunk *c, int n);
+COBRA_ISA_LIST(COBRA_ISA_DECLARE)
+
+#define COBRA_ISA_TABLE(isa, raster)                                                                \
+  {#isa, cobra_span_fill_##isa, cobra_span_blend_##isa, cobra_transform_points_##isa,             \
+   cobra_span_kernels_##raster, cobra_tri_kernels_##raster, cobra_project_points_##raster},
+static const cobra_kernel_table isa_tables[] = {COBRA_ISA_LIST(COBRA_ISA_TABLE)};
+#define ISA_COUNT (int)(sizeof(isa_tables) / sizeof(isa_tables[0]))
+
+static pthread_once_t simd_once = PTHREAD_ONCE_INIT;
+
+// Fino alla scelta la tabella punta a questi trampolini: inizializzano e inoltrano la chiamata
+static void resolve_span_fill(uint32_t *dst, long count, uint32_t value, bool stream)
+{
+  cobra_simd_init();
+  COBRA_KERNEL(span_fill)(dst, count, value, stream);
+}
+
+static void resolve_span_blend(uint32_t *dst, int count, const cobra_blend *b)
+{
+  cobra_simd_init();
+  COBRA_KERNEL(span_blend)(dst, count, b);
+}
+
+static void resolve_transform_points(const cobra_mat4 *m, const c_float *x, const c_float *y, const c_float *z,
+                                     c_float *out_x, c_float *out_y, c_float *out_z, c_float *out_w, int count)
+{
+  cobra_simd_init();
+  COBRA_KERNEL(transform_points)(m, x, y, z, out_x, out_y, out_z, out_w, count);
+}
+
+cobra_kernel_table cobra_kernels = {"", resolve_span_fill, resolve_span_blend, resolve_transform_points,
+                                    cobra_span_kernels_scalar, cobra_tri_kernels_scalar,
+                                    cobra_project_points_scalar};
+
+// true se la CPU esegue la variante 'index' di isa_tables
+static bool isa_supported(int index)
+{
+#ifdef COBRA_ISA_X86
+  const char *name = isa_tables[index].name;
+  if (strcmp(name, "avx512") == 0)
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+  if (strcmp(name, "avx2") == 0)
+    return __builtin_cpu_supports("avx2");
+  if (strcmp(name, "sse2") == 0)
+    return __builtin_cpu_supports("sse2");
+#endif
+  (void)index;
+  return true;
+}
+
+static void simd_select(void)
+{
+#ifdef COBRA_ISA_X86
+  __builtin_cpu_init();
+#endif
+  // Le varianti sono in ordine di larghezza: vince l'ultima supportata
+  int best = 0;
+  for (int i = 1; i < ISA_COUNT; i++)
+    if (isa_supported(i))
+      best = i;
+
+  const char *forced = getenv("COBRA_SIMD");
+  if (forced && *forced) {
+    for (int i = 0; i < ISA_COUNT; i++)
+      if (strcmp(forced, isa_tables[i].name) == 0 && isa_supported(i))
+        best = i;
+  }
+
+  // Campo per campo con store atomici: gli altri thread possono leggere la tabella intanto
+  const cobra_kernel_table *k = &isa_tables[best];
+  __atomic_store_n(&cobra_kernels.span_fill, k->span_fill, __ATOMIC_RELAXED);
+  __atomic_store_n(&cobra_kernels.span_blend, k->span_blend, __ATOMIC_RELAXED);
+  __atomic_store_n(&cobra_kernels.transform_points, k->transform_points, __ATOMIC_RELAXED);
+  __atomic_store_n(&cobra_kernels.span_kernels, k->span_kernels, __ATOMIC_RELAXED);
+  __atomic_store_n(&cobra_kernels.tri_kernels, k->tri_kernels, __ATOMIC_RELAXED);
+  __atomic_store_n(&cobra_kernels.project_points, k->project_points, __ATOMIC_RELAXED);
+  __atomic_store_n(&cobra_kernels.name, k->name, __ATOMIC_RELAXED);
+}
+
+void cobra_simd_init(void)
+{
+  pthread_once(&simd_once, simd_select);
+}
+
+const char *cobra_simd_kernels(void)
+{
+  cobra_simd_init();
+  return COBRA_KERNEL(name);
+}
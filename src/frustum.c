@@ -0,0 +1,201 @@
+// Clipping e culling contro il frustum di vista delle primitive 3D.
+//
+// La proiezione della libreria è x' = x * fov / z + half_w (cobra_vec3_project): il punto è
+// a schermo, guard band compresa, se |x * fov| <= (half_w + margin) * z. Ogni lato dello schermo
+// corrisponde quindi a un piano per l'occhio e la distanza con segno di un punto in spazio
+// camera è una funzione lineare: tagliare prima di proiettare è esatto (è il clipping in
+// coordinate omogenee, con w = z).
+
+#include "cobragl/surface.h"
+#include "internal.h"
+#include <math.h>
+#include <string.h>
+
+void cobra_frustum_init(cobra_frustum *f, const cobra_surface *surf, float fov, float margin)
+{
+  f->fov = fov;
+  f->kx = (float)surf->width * 0.5f + margin;
+  f->ky = (float)surf->height * 0.5f + margin;
+  f->near_plane = surf->near_plane;
+  f->far_plane = surf->far_plane;
+}
+
+// Distanze con segno dai 6 piani, nell'ordine dei bit COBRA_CLIP_* (>= 0 dentro)
+static inline void plane_distances(const cobra_frustum *f, const cobra_vec3 *p, float d[6])
+{
+  float xs = p->x * f->fov, ys = p->y * f->fov;
+  float kx = f->kx * p->z, ky = f->ky * p->z;
+  d[0] = kx + xs;
+  d[1] = kx - xs;
+  d[2] = ky + ys;
+  d[3] = ky - ys;
+  d[4] = p->z - f->near_plane;
+  d[5] = f->far_plane - p->z; // +inf senza far plane
+}
+
+bool cobra_frustum_clip_line(const cobra_frustum *f, cobra_vec3 *a, cobra_vec3 *b)
+{
+  float da[6], db[6];
+  plane_distances(f, a, da);
+  plane_distances(f, b, db);
+
+  float t0 = 0.0f, t1 = 1.0f;
+  for (int i = 0; i < 6; i++) {
+    if (da[i] < 0.0f && db[i] < 0.0f)
+      return false;
+    if (da[i] < 0.0f) {
+      // Entra nel semispazio: t0 avanza fino all'intersezione
+      float t = da[i] / (da[i] - db[i]);
+      if (t > t0) t0 = t;
+    } else if (db[i] < 0.0f) {
+      // Esce dal semispazio: t1 arretra fino all'intersezione
+      float t = da[i] / (da[i] - db[i]);
+      if (t < t1) t1 = t;
+    }
+  }
+  if (t0 > t1)
+    return false;
+
+  cobra_vec3 p = *a, d = cobra_vec3_sub(*b, *a);
+  if (t0 > 0.0f) *a = cobra_vec3_add(p, cobra_vec3_scale(d, t0));
+  if (t1 < 1.0f) *b = cobra_vec3_add(p, cobra_vec3_scale(d, t1));
+
+  // Gli arrotondamenti non devono riportare un estremo dietro il near plane
+  if (a->z < f->near_plane) a->z = f->near_plane;
+  if (b->z < f->near_plane) b->z = f->near_plane;
+  return true;
+}
+
+int cobra_frustum_clip_polygon(const cobra_frustum *f, const cobra_vec3 *in, int count, cobra_vec3 *out)
+{
+  // Sutherland-Hodgman: ogni piano può aggiungere al più un vertice
+  cobra_vec3 buf[2][COBRA_CLIP_POLYGON_MAX];
+  float d[COBRA_CLIP_POLYGON_MAX][6];
+  const cobra_vec3 *src = in;
+  int n = count;
+
+  for (int i = 0; i < n; i++)
+    plane_distances(f, &src[i], d[i]);
+
+  for (int plane = 0; plane < 6; plane++) {
+    cobra_vec3 *dst = (plane == 5) ? out : buf[plane & 1];
+    float nd[COBRA_CLIP_POLYGON_MAX][6];
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+      int j = (i + 1 == n) ? 0 : i + 1;
+      float di = d[i][plane], dj = d[j][plane];
+      if (di >= 0.0f) {
+        dst[m] = src[i];
+        memcpy(nd[m], d[i], sizeof(nd[m]));
+        m++;
+      }
+      if ((di >= 0.0f) != (dj >= 0.0f)) {
+        // Il lato attraversa il piano: aggiungiamo l'intersezione. Le sue distanze vengono
+        // ricalcolate (interpolarle darebbe NaN sul far plane infinito)
+        float t = di / (di - dj);
+        dst[m] = cobra_vec3_add(src[i], cobra_vec3_scale(cobra_vec3_sub(src[j], src[i]), t));
+        plane_distances(f, &dst[m], nd[m]);
+        m++;
+      }
+    }
+    if (m < 3)
+      return 0;
+    memcpy(d, nd, sizeof(nd[0]) * m);
+    src = dst;
+    n = m;
+  }
+
+  // Gli arrotondamenti non devono riportare un vertice dietro il near plane
+  for (int i = 0; i < n; i++) {
+    if (out[i].z < f->near_plane)
+      out[i].z = f->near_plane;
+  }
+  return n;
+}
+
+// Piani come (nx, ny, nz, w) con normale non normalizzata: distanza = n . p + w
+static void frustum_planes(const cobra_frustum *f, float p[6][4])
+{
+  const float planes[6][4] = {
+    { f->fov, 0.0f, f->kx, 0.0f },
+    { -f->fov, 0.0f, f->kx, 0.0f },
+    { 0.0f, f->fov, f->ky, 0.0f },
+    { 0.0f, -f->fov, f->ky, 0.0f },
+    { 0.0f, 0.0f, 1.0f, -f->near_plane },
+    { 0.0f, 0.0f, -1.0f, f->far_plane },
+  };
+  memcpy(p, planes, sizeof(planes));
+}
+
+cobra_cull_result cobra_frustum_cull_aabb(const cobra_frustum *f, const cobra_mat4 *model_view,
+                                          cobra_vec3 min, cobra_vec3 max)
+{
+  // Centro trasformato ed estensione del box che racchiude l'AABB ruotato (|M| * e)
+  cobra_vec3 c = cobra_vec3_scale(cobra_vec3_add(min, max), 0.5f);
+  cobra_vec3 e = cobra_vec3_scale(cobra_vec3_sub(max, min), 0.5f);
+  cobra_vec3 vc = cobra_mat4_transform_point(*model_view, c);
+  float ve[3];
+  for (int r = 0; r < 3; r++) {
+    ve[r] = fabsf(model_view->m[0][r]) * e.x + fabsf(model_view->m[1][r]) * e.y +
+            fabsf(model_view->m[2][r]) * e.z;
+  }
+
+  float n[6][4];
+  frustum_planes(f, n);
+
+  cobra_cull_result result = COBRA_CULL_INSIDE;
+  for (int i = 0; i < 6; i++) {
+    float d = n[i][0] * vc.x + n[i][1] * vc.y + n[i][2] * vc.z + n[i][3];
+    float r = fabsf(n[i][0]) * ve[0] + fabsf(n[i][1]) * ve[1] + fabsf(n[i][2]) * ve[2];
+    if (d < -r)
+      return COBRA_CULL_OUTSIDE;
+    if (d < r)
+      result = COBRA_CULL_INTERSECT;
+  }
+  return result;
+}
+
+cobra_cull_result cobra_surface_cull_aabb(const cobra_surface *surf, const cobra_mat4 *model_view, float fov,
+                                          cobra_vec3 min, cobra_vec3 max)
+{
+  if (!surf || !model_view)
+    return COBRA_CULL_INTERSECT;
+
+  cobra_frustum f;
+  cobra_frustum_init(&f, surf, fov, 0.0f);
+  return cobra_frustum_cull_aabb(&f, model_view, min, max);
+}
+
+cobra_cull_result cobra_surface_cull_sphere(const cobra_surface *surf, const cobra_mat4 *model_view, float fov,
+                                            cobra_vec3 center, float radius)
+{
+  if (!surf || !model_view)
+    return COBRA_CULL_INTERSECT;
+
+  cobra_frustum f;
+  cobra_frustum_init(&f, surf, fov, 0.0f);
+
+  // Con una scala non uniforme la sfera diventa un ellissoide: usiamo l'asse più lungo
+  float scale = 0.0f;
+  for (int c = 0; c < 3; c++) {
+    const float *col = model_view->m[c];
+    float len = sqrtf(col[0] * col[0] + col[1] * col[1] + col[2] * col[2]);
+    if (len > scale) scale = len;
+  }
+  cobra_vec3 vc = cobra_mat4_transform_point(*model_view, center);
+  float r = radius * scale;
+
+  float n[6][4];
+  frustum_planes(&f, n);
+
+  cobra_cull_result result = COBRA_CULL_INSIDE;
+  for (int i = 0; i < 6; i++) {
+    float len = sqrtf(n[i][0] * n[i][0] + n[i][1] * n[i][1] + n[i][2] * n[i][2]);
+    float d = (n[i][0] * vc.x + n[i][1] * vc.y + n[i][2] * vc.z + n[i][3]) / len;
+    if (d < -r)
+      return COBRA_CULL_OUTSIDE;
+    if (d < r)
+      result = COBRA_CULL_INTERSECT;
+  }
+  return result;
+}
@@ -0,0 +1,122 @@
+// Linee AA sotto il pixel di spessore (percorso SDF con width < 1).
+//
+// Il rasterizzatore generale dovrebbe allargare la linea a 1px e valutare uno span perpendicolare
+// di 2 * ceil(radius * 1.414 + 3) + 1 pixel per passo, quasi tutti a copertura nulla.
+// Qui camminiamo lungo l'asse principale come Xiaolin Wu: a ogni passo la linea cade fra i
+// centri di due pixel dell'asse secondario, che ricevono 1 - f e f (f = distanza dal primo).
+// Per conservare l'aspetto del percorso SDF:
+//   - i pesi sono moltiplicati per 1 / cos(angolo) (copertura finale limitata a 1): la somma per
+//     colonna resta quella della rampa SDF, così le diagonali non risultano più tenui delle
+//     orizzontali e delle verticali;
+//   - oltre gli estremi la copertura si spegne in 1px lungo la linea, come le punte tonde;
+//   - l'intensità è sqrt(width) invece di width: una correzione percettiva che rende le linee
+//     sottili più visibili (con la sola copertura geometrica sembrerebbero troppo tenui).
+// Per linee orizzontali e verticali i pesi coincidono con quelli della rampa SDF.
+
+#include "internal.h"
+#include <math.h>
+
+// Il corpo viene espanso per ogni modalità di blending: niente chiamata indiretta per pixel
+static inline __attribute__((always_inline)) void
+raster_hairline(cobra_surface *surf, const cobra_rect *clip, float x0, float y0, float x1, float y1,
+                float len_sq, float inv_len, float width, const cobra_blend *blend,
+                const cobra_line_depth *depth, cobra_blend_mode mode)
+{
+  bool is_x_major = fabsf(x1 - x0) >= fabsf(y1 - y0);
+
+  // Coordinate (a = asse principale, b = secondario) con l'estremo iniziale ad a minore
+  float a0 = is_x_major ? x0 : y0, b0 = is_x_major ? y0 : x0;
+  float a1 = is_x_major ? x1 : y1, b1 = is_x_major ? y1 : x1;
+  float z0 = depth ? depth->z0 : 0.0f, z1 = depth ? depth->z1 : 0.0f;
+  if (a1 < a0) {
+    float tmp;
+    tmp = a0; a0 = a1; a1 = tmp;
+    tmp = b0; b0 = b1; b1 = tmp;
+    tmp = z0; z0 = z1; z1 = tmp;
+  }
+
+  float da = a1 - a0;
+  float inv_da = 1.0f / da; // da > 0: len_sq > 0 e a è l'asse più lungo
+  float grad = (b1 - b0) * inv_da;
+  // 1 / cos(angolo) = lunghezza / proiezione sull'asse principale
+  float k = len_sq * inv_len * inv_da;
+  float intensity = sqrtf(width);
+  float dz = z1 - z0;
+
+  // Colonne con copertura: fino a 1px oltre gli estremi lungo la linea (1/k sull'asse a)
+  float reach = 1.0f / k;
+  int a_lo = (int)floorf(a0 - reach);
+  int a_hi = (int)floorf(a1 + reach);
+  int clip_a0 = is_x_major ? clip->x0 : clip->y0, clip_a1 = is_x_major ? clip->x1 : clip->y1;
+  int clip_b0 = is_x_major ? clip->y0 : clip->x0, clip_b1 = is_x_major ? clip->y1 : clip->x1;
+  if (a_lo < clip_a0) a_lo = clip_a0;
+  if (a_hi > clip_a1 - 1) a_hi = clip_a1 - 1;
+
+  float *z_buffer = depth ? surf->z_buffer : NULL;
+  int evaluated = 0, blended = 0;
+
+  for (int a = a_lo; a <= a_hi; a++) {
+    float ac = (float)a + 0.5f;
+    float t = (ac - a0) * inv_da;
+
+    // Spegnimento oltre gli estremi (distanza lungo la linea)
+    float fade = 1.0f;
+    if (t < 0.0f) fade = 1.0f - (a0 - ac) * k;
+    else if (t > 1.0f) fade = 1.0f - (ac - a1) * k;
+    if (fade <= 0.0f)
+      continue;
+
+    // I due pixel dell'asse secondario che racchiudono la linea
+    float bc = b0 + (ac - a0) * grad - 0.5f;
+    int b = (int)bc;
+    if ((float)b > bc) b--; // floor (bc può essere negativo nella guard band)
+    float f = bc - (float)b;
+    float tc = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+    float z = z0 + tc * dz;
+
+    for (int i = 0; i < 2; i++) {
+      int bi = b + i;
+      if (bi < clip_b0 || bi >= clip_b1)
+        continue;
+      evaluated++;
+      float alpha = (i ? f : 1.0f - f) * k * fade * intensity;
+      uint32_t cov = cobra_coverage(alpha > 1.0f ? 1.0f : alpha);
+      if (!cov)
+        continue;
+
+      long idx = is_x_major ? cobra_pixel_index(surf, a, bi) : cobra_pixel_index(surf, bi, a);
+      if (z_buffer) {
+        if (!cobra_depth_test(depth->func, z, z_buffer[idx]))
+          continue;
+        if (depth->write && cov >= 128)
+          z_buffer[idx] = z;
+      }
+      switch (mode) {
+      case COBRA_BLEND_ADDITIVE: cobra_blend_additive(&surf->color_buffer[idx], blend, cov); break;
+      case COBRA_BLEND_MAX:      cobra_blend_max(&surf->color_buffer[idx], blend, cov); break;
+      default:                   cobra_blend_over(&surf->color_buffer[idx], blend, cov); break;
+      }
+      blended++;
+    }
+  }
+
+  COBRA_STAT_ADD(pixels_evaluated, evaluated);
+  COBRA_STAT_ADD(pixels_blended, blended);
+}
+
+void cobra_raster_hairline(cobra_surface *surf, const cobra_rect *clip, float x0, float y0, float x1, float y1,
+                           float len_sq, float inv_len, float width, const cobra_blend *blend,
+                           const cobra_line_depth *depth)
+{
+  switch (blend->mode) {
+  case COBRA_BLEND_ADDITIVE:
+    raster_hairline(surf, clip, x0, y0, x1, y1, len_sq, inv_len, width, blend, depth, COBRA_BLEND_ADDITIVE);
+    break;
+  case COBRA_BLEND_MAX:
+    raster_hairline(surf, clip, x0, y0, x1, y1, len_sq, inv_len, width, blend, depth, COBRA_BLEND_MAX);
+    break;
+  default:
+    raster_hairline(surf, clip, x0, y0, x1, y1, len_sq, inv_len, width, blend, depth, COBRA_BLEND_OVER);
+    break;
+  }
+}
@@ -0,0 +1,263 @@
+// Piramide Hi-Z per l'occlusion culling.
+//
+// Il livello 0 contiene profondità minima e massima di ogni tile di COBRA_HIZ_TILE x COBRA_HIZ_TILE
+// pixel dello z_buffer; ogni livello successivo riduce 2x2 texel del precedente, fino a 1x1.
+// La piramide non viene aggiornata a ogni scrittura: le primitive che scrivono la profondità
+// allargano il rettangolo dirty_hiz (cobra_mark_dirty) e i tile coinvolti vengono ricalcolati
+// alla prima interrogazione successiva, una volta per frame e non una per primitiva.
+//
+// Un oggetto è nascosto se la sua profondità più vicina è dietro la profondità più lontana di
+// tutti i texel coperti dal suo rettangolo a schermo: si scelgono il livello in cui il
+// rettangolo copre al più 2x2 texel, quindi il test costa sempre quattro letture.
+
+#include "cobragl/surface.h"
+#include "internal.h"
+#include "simd.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+#define HIZ_MAX_LEVELS 16
+#if COBRA_HIZ_TILE != COBRA_FB_TILE
+#error "reduce_tile legge righe contigue: i tile Hi-Z devono coincidere con quelli del layout a tile"
+#endif
+
+struct cobra_hiz {
+  int levels;
+  int w[HIZ_MAX_LEVELS], h[HIZ_MAX_LEVELS];
+  float *zmin[HIZ_MAX_LEVELS];
+  float *zmax[HIZ_MAX_LEVELS];
+};
+
+static void hiz_free(struct cobra_hiz *hiz)
+{
+  for (int l = 0; l < hiz->levels; l++) {
+    free(hiz->zmin[l]);
+    free(hiz->zmax[l]);
+  }
+  free(hiz);
+}
+
+// Min/max di un tile del livello 0
+static void reduce_tile(const cobra_surface *surf, int tx, int ty, float *out_min, float *out_max)
+{
+  int x0 = tx * COBRA_HIZ_TILE, y0 = ty * COBRA_HIZ_TILE;
+  int x1 = x0 + COBRA_HIZ_TILE < surf->width ? x0 + COBRA_HIZ_TILE : surf->width;
+  int y1 = y0 + COBRA_HIZ_TILE < surf->height ? y0 + COBRA_HIZ_TILE : surf->height;
+  float lo = FLT_MAX, hi = -FLT_MAX;
+
+#ifdef COBRA_SIMD_LANES
+  if (x1 - x0 == COBRA_HIZ_TILE) {
+    vf vlo = VF_SET1(FLT_MAX), vhi = VF_SET1(-FLT_MAX);
+    for (int y = y0; y < y1; y++) {
+      const float *row = &surf->z_buffer[cobra_pixel_index(surf, x0, y)];
+      for (int x = 0; x < COBRA_HIZ_TILE; x += COBRA_SIMD_LANES) {
+        vf z = VF_LOAD(row + x);
+        vlo = VF_MIN(vlo, z);
+        vhi = VF_MAX(vhi, z);
+      }
+    }
+    float a[COBRA_SIMD_LANES], b[COBRA_SIMD_LANES];
+    VF_STORE(a, vlo);
+    VF_STORE(b, vhi);
+    for (int i = 0; i < COBRA_SIMD_LANES; i++) {
+      lo = fminf(lo, a[i]);
+      hi = fmaxf(hi, b[i]);
+    }
+    *out_min = lo;
+    *out_max = hi;
+    return;
+  }
+#endif
+
+  for (int y = y0; y < y1; y++) {
+    // Il tile è allineato a quelli del layout a tile: la riga è contigua in entrambi i layout
+    const float *row = &surf->z_buffer[cobra_pixel_index(surf, x0, y)];
+    for (int x = 0; x < x1 - x0; x++) {
+      lo = fminf(lo, row[x]);
+      hi = fmaxf(hi, row[x]);
+    }
+  }
+  *out_min = lo;
+  *out_max = hi;
+}
+
+// Ricalcola i texel [x0,x1] x [y0,y1] del livello 0 e propaga verso l'alto
+static void hiz_rebuild(cobra_surface *surf, int x0, int y0, int x1, int y1)
+{
+  struct cobra_hiz *hiz = surf->hiz;
+
+  for (int ty = y0; ty <= y1; ty++) {
+    for (int tx = x0; tx <= x1; tx++) {
+      int i = ty * hiz->w[0] + tx;
+      reduce_tile(surf, tx, ty, &hiz->zmin[0][i], &hiz->zmax[0][i]);
+    }
+  }
+
+  for (int l = 1; l < hiz->levels; l++) {
+    x0 >>= 1; y0 >>= 1; x1 >>= 1; y1 >>= 1;
+    int cw = hiz->w[l - 1], ch = hiz->h[l - 1];
+    const float *cmin = hiz->zmin[l - 1], *cmax = hiz->zmax[l - 1];
+    for (int ty = y0; ty <= y1; ty++) {
+      for (int tx = x0; tx <= x1; tx++) {
+        float lo = FLT_MAX, hi = -FLT_MAX;
+        for (int cy = 2 * ty; cy <= 2 * ty + 1 && cy < ch; cy++) {
+          for (int cx = 2 * tx; cx <= 2 * tx + 1 && cx < cw; cx++) {
+            lo = fminf(lo, cmin[cy * cw + cx]);
+            hi = fmaxf(hi, cmax[cy * cw + cx]);
+          }
+        }
+        hiz->zmin[l][ty * hiz->w[l] + tx] = lo;
+        hiz->zmax[l][ty * hiz->w[l] + tx] = hi;
+      }
+    }
+  }
+}
+
+// Porta la piramide allo stato attuale dello z_buffer (solo i tile nel rettangolo sporco)
+static void hiz_update(cobra_surface *surf)
+{
+  cobra_rect *r = &surf->dirty_hiz;
+  if (r->x0 >= r->x1 || r->y0 >= r->y1)
+    return;
+
+  // Le linee differite registrate non hanno ancora scritto la loro profondità
+  if (surf->deferred)
+    cobra_surface_flush(surf);
+
+  hiz_rebuild(surf, r->x0 / COBRA_HIZ_TILE, r->y0 / COBRA_HIZ_TILE,
+              (r->x1 - 1) / COBRA_HIZ_TILE, (r->y1 - 1) / COBRA_HIZ_TILE);
+  *r = (cobra_rect){0, 0, 0, 0};
+}
+
+bool cobra_surface_enable_hiz(cobra_surface *surf)
+{
+  if (!surf || !surf->z_buffer)
+    return false;
+  if (surf->hiz)
+    return true;
+
+  struct cobra_hiz *hiz = (struct cobra_hiz *)calloc(1, sizeof(*hiz));
+  if (!hiz)
+    return false;
+
+  int w = (surf->width + COBRA_HIZ_TILE - 1) / COBRA_HIZ_TILE;
+  int h = (surf->height + COBRA_HIZ_TILE - 1) / COBRA_HIZ_TILE;
+  while (hiz->levels < HIZ_MAX_LEVELS) {
+    int l = hiz->levels++;
+    hiz->w[l] = w;
+    hiz->h[l] = h;
+    hiz->zmin[l] = (float *)malloc(sizeof(float) * w * h);
+    hiz->zmax[l] = (float *)malloc(sizeof(float) * w * h);
+    if (!hiz->zmin[l] || !hiz->zmax[l]) {
+      hiz_free(hiz);
+      return false;
+    }
+    if (w == 1 && h == 1)
+      break;
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+  }
+
+  surf->hiz = hiz;
+  surf->dirty_hiz = (cobra_rect){0, 0, surf->width, surf->height};
+  return true;
+}
+
+void cobra_surface_disable_hiz(cobra_surface *surf)
+{
+  if (!surf || !surf->hiz)
+    return;
+  hiz_free(surf->hiz);
+  surf->hiz = NULL;
+  surf->dirty_hiz = (cobra_rect){0, 0, 0, 0};
+}
+
+void cobra_hiz_clear(cobra_surface *surf, float depth)
+{
+  struct cobra_hiz *hiz = surf->hiz;
+  for (int l = 0; l < hiz->levels; l++) {
+    long n = (long)hiz->w[l] * hiz->h[l];
+    for (long i = 0; i < n; i++) {
+      hiz->zmin[l][i] = depth;
+      hiz->zmax[l][i] = depth;
+    }
+  }
+  surf->dirty_hiz = (cobra_rect){0, 0, 0, 0};
+}
+
+bool cobra_hiz_occluded(cobra_surface *surf, const cobra_mat4 *model_view, float fov,
+                        cobra_vec3 min, cobra_vec3 max, float margin)
+{
+  struct cobra_hiz *hiz = surf->hiz;
+  cobra_depth_func func = surf->depth_func;
+  if (!hiz || func == COBRA_DEPTH_ALWAYS)
+    return false;
+
+  // Rettangolo a schermo e intervallo di z degli 8 angoli del box
+  const float half_w = (float)surf->width * 0.5f;
+  const float half_h = (float)surf->height * 0.5f;
+  float sx0 = FLT_MAX, sy0 = FLT_MAX, sx1 = -FLT_MAX, sy1 = -FLT_MAX;
+  float z_near = FLT_MAX, z_far = 0.0f;
+  for (int i = 0; i < 8; i++) {
+    cobra_vec3 c = {{(i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z}};
+    cobra_vec3 v = cobra_mat4_transform_point(*model_view, c);
+    // Un box a cavallo del near plane non ha un rettangolo a schermo limitato
+    if (v.z < surf->near_plane)
+      return false;
+    float inv_z = 1.0f / v.z;
+    float x = v.x * fov * inv_z + half_w;
+    float y = -v.y * fov * inv_z + half_h;
+    sx0 = fminf(sx0, x); sx1 = fmaxf(sx1, x);
+    sy0 = fminf(sy0, y); sy1 = fmaxf(sy1, y);
+    z_near = fminf(z_near, v.z); z_far = fmaxf(z_far, v.z);
+  }
+
+  // Pixel coperti (con il margine delle linee), limitati allo schermo.
+  // Ciò che è fuori schermo lo scarta il frustum culling, non l'occlusione.
+  int x0 = (int)floorf(sx0 - margin), y0 = (int)floorf(sy0 - margin);
+  int x1 = (int)floorf(sx1 + margin), y1 = (int)floorf(sy1 + margin);
+  if (x0 < 0) x0 = 0;
+  if (y0 < 0) y0 = 0;
+  if (x1 > surf->width - 1) x1 = surf->width - 1;
+  if (y1 > surf->height - 1) y1 = surf->height - 1;
+  if (x0 > x1 || y0 > y1)
+    return false;
+
+  hiz_update(surf);
+
+  // Livello in cui il rettangolo copre al più 2x2 texel
+  int tx0 = x0 / COBRA_HIZ_TILE, ty0 = y0 / COBRA_HIZ_TILE;
+  int tx1 = x1 / COBRA_HIZ_TILE, ty1 = y1 / COBRA_HIZ_TILE;
+  int l = 0;
+  while (l + 1 < hiz->levels && (tx1 - tx0 > 1 || ty1 - ty0 > 1)) {
+    tx0 >>= 1; ty0 >>= 1; tx1 >>= 1; ty1 >>= 1;
+    l++;
+  }
+
+  const int w = hiz->w[l];
+  bool nearer_wins = (func == COBRA_DEPTH_LESS || func == COBRA_DEPTH_LEQUAL);
+  if (nearer_wins) {
+    // Nascosto se il punto più vicino è dietro il più lontano già scritto
+    float d = cobra_depth_from_z(surf, z_near);
+    for (int ty = ty0; ty <= ty1; ty++)
+      for (int tx = tx0; tx <= tx1; tx++)
+        if (!(d > hiz->zmax[l][ty * w + tx]))
+          return false;
+  } else {
+    float d = cobra_depth_from_z(surf, z_far);
+    for (int ty = ty0; ty <= ty1; ty++)
+      for (int tx = tx0; tx <= tx1; tx++)
+        if (!(d < hiz->zmin[l][ty * w + tx]))
+          return false;
+  }
+  return true;
+}
+
+bool cobra_surface_occluded_aabb(cobra_surface *surf, const cobra_mat4 *model_view, float fov,
+                                 cobra_vec3 min, cobra_vec3 max)
+{
+  if (!surf || !model_view)
+    return false;
+  return cobra_hiz_occluded(surf, model_view, fov, min, max, 0.0f);
+}
@@ -0,0 +1,635 @@
+#ifndef COBRAGL_INTERNAL_H
+#define COBRAGL_INTERNAL_H
+
+// Funzioni interne condivise tra i moduli della libreria.
+// Non fanno parte dell'API pubblica: non vanno incluse dagli esempi.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include "cobragl/surface.h"
+
+// --- Layout dei buffer (tile.c) ---
+#define COBRA_FB_TILE_SHIFT 3 // log2(COBRA_FB_TILE)
+
+// Indice del pixel (x, y) nel layout a tile (per i kernel già specializzati sul layout)
+static inline long cobra_tile_index(const cobra_surface *surf, int x, int y)
+{
+  long tile = (long)(y >> COBRA_FB_TILE_SHIFT) * surf->tiles_x + (x >> COBRA_FB_TILE_SHIFT);
+  return (tile << (2 * COBRA_FB_TILE_SHIFT)) + ((y & (COBRA_FB_TILE - 1)) << COBRA_FB_TILE_SHIFT) +
+         (x & (COBRA_FB_TILE - 1));
+}
+
+// Indice del pixel (x, y) in color_buffer e z_buffer, nel layout corrente della superficie
+static inline long cobra_pixel_index(const cobra_surface *surf, int x, int y)
+{
+  if (!surf->tiled)
+    return (long)y * surf->width + x;
+  return cobra_tile_index(surf, x, y);
+}
+
+// Distanza in memoria tra il pixel k di uno span e il primo. Nel layout lineare è k * stride;
+// nel layout a tile lo span avanza di stride dentro un tile e salta di 'jump' passando al
+// tile successivo. tile_pos è la posizione del primo pixel dentro il suo tile.
+static inline long cobra_span_offset(bool tiled, long jump, int tile_pos, int stride, int k)
+{
+  if (!tiled)
+    return (long)k * stride;
+  int q = tile_pos + k;
+  return (long)(q >> COBRA_FB_TILE_SHIFT) * jump + (long)((q & (COBRA_FB_TILE - 1)) - tile_pos) * stride;
+}
+
+// Pixel da allocare per un buffer della superficie nel layout corrente
+static inline long cobra_buffer_pixels(const cobra_surface *surf)
+{
+  if (!surf->tiled)
+    return (long)surf->width * surf->height;
+  long tiles_y = (surf->height + COBRA_FB_TILE - 1) >> COBRA_FB_TILE_SHIFT;
+  return ((long)surf->tiles_x * tiles_y) << (2 * COBRA_FB_TILE_SHIFT);
+}
+
+// Riempie il rettangolo 'r' di un buffer a tile con 'value'
+void cobra_tile_fill(const cobra_surface *surf, uint32_t *buffer, const cobra_rect *r, uint32_t value, bool stream);
+// Copia il rettangolo 'r' di un buffer a tile con 'tiles_x' tile per riga in 'dst' (lineare,
+// 'dst_pitch' pixel per riga). Non legge la superficie: la usa anche il thread del present.
+void cobra_detile(const uint32_t *src, int tiles_x, const cobra_rect *r, uint32_t *dst, int dst_pitch);
+
+// --- Tracciamento delle aree toccate (per il clear limitato) ---
+static inline void cobra_rect_union(cobra_rect *dst, const cobra_rect *r)
+{
+  if (r->x0 >= r->x1 || r->y0 >= r->y1)
+    return;
+  if (dst->x0 >= dst->x1 || dst->y0 >= dst->y1) {
+    *dst = *r;
+    return;
+  }
+  if (r->x0 < dst->x0) dst->x0 = r->x0;
+  if (r->y0 < dst->y0) dst->y0 = r->y0;
+  if (r->x1 > dst->x1) dst->x1 = r->x1;
+  if (r->y1 > dst->y1) dst->y1 = r->y1;
+}
+
+// Aggiunge un rettangolo alla lista dei danni per il present (surface.c)
+void cobra_damage_add(cobra_surface *surf, const cobra_rect *r);
+
+// cobra_surface_set_buffer_count senza il controllo su buffers_shared (surface.c): per la
+// finestra, che chiama prima presenter_show e quindi sa che nessuna copia è in corso
+bool cobra_surface_resize_buffers(cobra_surface *surf, int count);
+
+// Segna come toccato il box [min_x, max_x] x [min_y, max_y] (in pixel, estremi inclusi),
+// limitato alla superficie. Va chiamata solo dal thread che invia i comandi.
+static inline void cobra_mark_dirty(cobra_surface *surf, float min_x, float min_y, float max_x, float max_y)
+{
+  if (max_x < 0.0f || max_y < 0.0f || min_x >= (float)surf->width || min_y >= (float)surf->height)
+    return;
+  cobra_rect r;
+  r.x0 = (min_x <= 0.0f) ? 0 : (int)min_x;
+  r.y0 = (min_y <= 0.0f) ? 0 : (int)min_y;
+  r.x1 = (max_x >= (float)(surf->width - 1)) ? surf->width : (int)max_x + 1;
+  r.y1 = (max_y >= (float)(surf->height - 1)) ? surf->height : (int)max_y + 1;
+  cobra_rect_union(&surf->dirty_color, &r);
+  cobra_rect_union(&surf->dirty_depth, &r);
+  if (surf->hiz && surf->depth_write)
+    cobra_rect_union(&surf->dirty_hiz, &r);
+  cobra_damage_add(surf, &r);
+}
+
+// Area toccata da una linea AA: bounding box degli estremi allargato della guard band
+static inline void cobra_mark_dirty_line(cobra_surface *surf, float x0, float y0, float x1, float y1, float width)
+{
+  float m = width * 0.5f + 2.0f;
+  cobra_mark_dirty(surf, fminf(x0, x1) - m, fminf(y0, y1) - m, fmaxf(x0, x1) + m, fmaxf(y0, y1) + m);
+}
+
+// --- Blending intero (SWAR) ---
+// I canali a 8 bit vengono elaborati a coppie in una parola a 32 bit: 0x00FF00FF contiene
+// B e R, (c >> 8) & 0x00FF00FF contiene G e A. Ogni canale ha 16 bit di spazio, quindi
+// il prodotto per un fattore 0..256 non invade il canale vicino.
+// Le coperture sono in virgola fissa 0..256 (256 = piena).
+
+// Stato di blending di una draw call, preparato una volta da cobra_blend_init
+typedef struct cobra_blend {
+  uint32_t color;        // colore premoltiplicato (ogni canale <= alpha)
+  uint32_t alpha;        // alpha sorgente in scala 0..256
+  cobra_blend_mode mode;
+} cobra_blend;
+
+// Legge modalità e formato colore dalla superficie e premoltiplica 'color' se serve (surface.c)
+void cobra_blend_init(cobra_blend *b, const cobra_surface *surf, uint32_t color);
+
+// Copertura float [0,1] -> virgola fissa 0..256, arrotondata
+static inline uint32_t cobra_coverage(float alpha)
+{
+  return (uint32_t)(alpha * 256.0f + 0.5f);
+}
+
+// Moltiplica i 4 canali di c per a/256 (a in 0..256), con arrotondamento
+static inline uint32_t cobra_swar_scale(uint32_t c, uint32_t a)
+{
+  uint32_t rb = ((c & 0x00FF00FFu) * a + 0x00800080u) >> 8;
+  uint32_t ag = (((c >> 8) & 0x00FF00FFu) * a + 0x00800080u) >> 8;
+  return (rb & 0x00FF00FFu) | ((ag & 0x00FF00FFu) << 8);
+}
+
+// Somma per canale saturata a 255: il riporto finisce nel bit 8 di ogni canale
+// e viene trasformato in una maschera 0xFF
+static inline uint32_t cobra_swar_adds(uint32_t a, uint32_t b)
+{
+  uint32_t rb = (a & 0x00FF00FFu) + (b & 0x00FF00FFu);
+  uint32_t ag = ((a >> 8) & 0x00FF00FFu) + ((b >> 8) & 0x00FF00FFu);
+  uint32_t rb_c = rb & 0x01000100u;
+  uint32_t ag_c = ag & 0x01000100u;
+  rb |= rb_c - (rb_c >> 8);
+  ag |= ag_c - (ag_c >> 8);
+  return (rb & 0x00FF00FFu) | ((ag & 0x00FF00FFu) << 8);
+}
+
+// Massimo per canale: (a | 0x100) - b lascia il bit 8 acceso dove a >= b
+static inline uint32_t cobra_swar_max(uint32_t a, uint32_t b)
+{
+  uint32_t a_rb = a & 0x00FF00FFu, b_rb = b & 0x00FF00FFu;
+  uint32_t a_ag = (a >> 8) & 0x00FF00FFu, b_ag = (b >> 8) & 0x00FF00FFu;
+  uint32_t m_rb = ((a_rb | 0x01000100u) - b_rb) & 0x01000100u;
+  uint32_t m_ag = ((a_ag | 0x01000100u) - b_ag) & 0x01000100u;
+  m_rb -= m_rb >> 8;
+  m_ag -= m_ag >> 8;
+  uint32_t rb = (a_rb & m_rb) | (b_rb & ~m_rb);
+  uint32_t ag = (a_ag & m_ag) | (b_ag & ~m_ag);
+  return rb | (ag << 8);
+}
+
+// Blending di un pixel con copertura cov (1..256). Il colore è premoltiplicato:
+// over: dst = src * cov + dst * (1 - alpha * cov)
+static inline void cobra_blend_over(uint32_t *p, const cobra_blend *b, uint32_t cov)
+{
+  uint32_t a = (b->alpha * cov + 128) >> 8;
+  if (a >= 256) {
+    *p = b->color;
+    return;
+  }
+  *p = cobra_swar_adds(cobra_swar_scale(b->color, cov), cobra_swar_scale(*p, 256 - a));
+}
+
+static inline void cobra_blend_additive(uint32_t *p, const cobra_blend *b, uint32_t cov)
+{
+  *p = cobra_swar_adds(*p, cobra_swar_scale(b->color, cov));
+}
+
+static inline void cobra_blend_max(uint32_t *p, const cobra_blend *b, uint32_t cov)
+{
+  *p = cobra_swar_max(*p, cobra_swar_scale(b->color, cov));
+}
+
+typedef void (*cobra_blend_fn)(uint32_t *p, const cobra_blend *b, uint32_t cov);
+
+// Funzione di blending per la modalità, da scegliere una volta per draw call
+static inline cobra_blend_fn cobra_blend_select(cobra_blend_mode mode)
+{
+  switch (mode) {
+  case COBRA_BLEND_ADDITIVE: return cobra_blend_additive;
+  case COBRA_BLEND_MAX:      return cobra_blend_max;
+  default:                   return cobra_blend_over;
+  }
+}
+
+// Piano vicino (Near Plane) di default per il clipping delle linee 3D.
+// 0.5f evita coordinate proiettate troppo grandi che causano artefatti.
+#define COBRA_NEAR_PLANE 0.5f
+
+// --- Frustum 3D (frustum.c) ---
+// Piani della proiezione di cobra_vec3_project (x' = x * fov / z + half_w) in spazio camera.
+// Passano tutti per l'occhio (tranne near/far), quindi la distanza con segno di un punto da
+// ciascun piano è lineare in (x, y, z): il clipping parametrico è esatto senza proiettare.
+typedef struct cobra_frustum {
+  float fov;
+  float kx, ky;        // semi-larghezza/altezza dello schermo più il margine, in pixel
+  float near_plane, far_plane;
+} cobra_frustum;
+
+#define COBRA_CLIP_LEFT   1
+#define COBRA_CLIP_RIGHT  2
+#define COBRA_CLIP_BOTTOM 4
+#define COBRA_CLIP_TOP    8
+#define COBRA_CLIP_NEAR   16
+#define COBRA_CLIP_FAR    32
+
+// margin: guard band in pixel attorno allo schermo (raggio della linea + extra)
+void cobra_frustum_init(cobra_frustum *f, const cobra_surface *surf, float fov, float margin);
+
+// Bit dei piani rispetto ai quali il punto è fuori (0 = dentro il frustum)
+static inline unsigned cobra_frustum_outcode(const cobra_frustum *f, float x, float y, float z)
+{
+  float xs = x * f->fov, ys = y * f->fov;
+  float kx = f->kx * z, ky = f->ky * z;
+  return (unsigned)((kx + xs < 0.0f) | ((kx - xs < 0.0f) << 1) |
+                    ((ky + ys < 0.0f) << 2) | ((ky - ys < 0.0f) << 3) |
+                    ((z < f->near_plane) << 4) | ((z > f->far_plane) << 5));
+}
+
+// Liang-Barsky contro i 6 piani. Restituisce false se il segmento è interamente fuori.
+bool cobra_frustum_clip_line(const cobra_frustum *f, cobra_vec3 *a, cobra_vec3 *b);
+
+// Sutherland-Hodgman di un poligono convesso contro i 6 piani. 'out' deve avere spazio per
+// COBRA_CLIP_POLYGON_MAX vertici (count + 6 al massimo, con count <= 6).
+// Restituisce il numero di vertici del poligono tagliato (0 se è interamente fuori).
+#define COBRA_CLIP_POLYGON_MAX 12
+int cobra_frustum_clip_polygon(const cobra_frustum *f, const cobra_vec3 *in, int count, cobra_vec3 *out);
+
+// Classificazione di un AABB in spazio modello (usata dalle mesh con il margine dello spessore)
+cobra_cull_result cobra_frustum_cull_aabb(const cobra_frustum *f, const cobra_mat4 *model_view,
+                                          cobra_vec3 min, cobra_vec3 max);
+
+// --- Profondità ---
+// Stato di profondità di una linea 3D, preparato una volta per linea. z0/z1 sono le profondità
+// degli estremi già trasformate da cobra_depth_from_z: essendo lineari nello schermo, il
+// rasterizzatore le interpola con lo stesso parametro t della linea.
+typedef struct cobra_line_depth {
+  float z0, z1;
+  cobra_depth_func func;
+  bool write;
+} cobra_line_depth;
+
+// true se le primitive 3D devono leggere o scrivere lo z_buffer
+static inline bool cobra_depth_enabled(const cobra_surface *surf)
+{
+  return surf->depth_func != COBRA_DEPTH_ALWAYS || surf->depth_write;
+}
+
+// z in spazio camera (>= near) -> profondità 0..1, stessa mappatura di cobra_mat4_perspective.
+// Con far infinito il fattore di scala vale 1.
+static inline float cobra_depth_from_z(const cobra_surface *surf, float z)
+{
+  float range = isinf(surf->far_plane) ? 1.0f : surf->far_plane / (surf->far_plane - surf->near_plane);
+  return (1.0f - surf->near_plane / z) * range;
+}
+
+static inline void cobra_line_depth_init(cobra_line_depth *d, const cobra_surface *surf, float z0, float z1)
+{
+  d->z0 = cobra_depth_from_z(surf, z0);
+  d->z1 = cobra_depth_from_z(surf, z1);
+  d->func = surf->depth_func;
+  d->write = surf->depth_write;
+}
+
+static inline bool cobra_depth_test(cobra_depth_func func, float z, float stored)
+{
+  switch (func) {
+  case COBRA_DEPTH_LESS:    return z < stored;
+  case COBRA_DEPTH_LEQUAL:  return z <= stored;
+  case COBRA_DEPTH_GREATER: return z > stored;
+  case COBRA_DEPTH_GEQUAL:  return z >= stored;
+  default:                  return true;
+  }
+}
+
+// Parametro del punto (x, y) lungo il segmento (ax, ay) -> (bx, by)
+static inline float cobra_line_param(float ax, float ay, float bx, float by, float x, float y)
+{
+  float dx = bx - ax, dy = by - ay;
+  float len_sq = dx * dx + dy * dy;
+  return (len_sq > 0.0f) ? ((x - ax) * dx + (y - ay) * dy) / len_sq : 0.0f;
+}
+
+// Aggiorna le profondità dopo un clipping 2D che ha portato il segmento (ax, ay) -> (bx, by)
+// in (x0, y0) -> (x1, y1): la profondità è lineare nello schermo, basta riparametrizzare
+static inline void cobra_line_depth_clip(cobra_line_depth *d, float ax, float ay, float bx, float by,
+                                         float x0, float y0, float x1, float y1)
+{
+  float z = d->z0, dz = d->z1 - d->z0;
+  d->z0 = z + dz * cobra_line_param(ax, ay, bx, by, x0, y0);
+  d->z1 = z + dz * cobra_line_param(ax, ay, bx, by, x1, y1);
+}
+
+// Cohen-Sutherland (float) esposto agli altri moduli
+bool cobra_clip_line_f(float *x0, float *y0, float *x1, float *y1,
+                       float min_x, float min_y, float max_x, float max_y);
+
+// Invio di linee con profondità opzionale (depth = NULL: nessun test), usato dai percorsi 3D.
+// Gestiscono modalità differita, aree toccate e clipping come le versioni pubbliche.
+void cobra_submit_line(cobra_surface *surf, int x0, int y0, int x1, int y1, uint32_t color,
+                       const cobra_line_depth *depth);
+void cobra_submit_line_aa(cobra_surface *surf, float x0, float y0, float x1, float y1, float width,
+                          uint32_t color, const cobra_line_depth *depth, cobra_aa_mode aa_mode);
+// Batch SoA (batch.c): depth0/depth1 sono le z in spazio camera degli estremi, NULL = nessun test
+void cobra_submit_lines_aa(cobra_surface *surf, const float *x0, const float *y0,
+                           const float *x1, const float *y1, const float *width, const uint32_t *color,
+                           const float *depth0, const float *depth1, int count, cobra_aa_mode aa_mode);
+
+// Rasterizzatore AA limitato a un rettangolo di clip [x0,x1) x [y0,y1).
+// Scrive solo i pixel dentro 'clip': più thread possono lavorare su tile diversi senza lock.
+// Restituisce false se la linea è fuori dalla guard band di 'clip' (o degenere).
+bool cobra_raster_line_aa(cobra_surface *surf, const cobra_rect *clip,
+                          float x0, float y0, float x1, float y1, float width,
+                          const cobra_blend *blend, const cobra_line_depth *depth, cobra_aa_mode aa_mode);
+// Come sopra, per una linea già tagliata alla guard band di 'clip' e con setup precalcolato
+// (len_sq > 0, inv_len = 1/sqrt(len_sq)). Usata dai percorsi batch.
+// Le profondità di 'depth' si riferiscono agli estremi passati.
+void cobra_raster_line_aa_clipped(cobra_surface *surf, const cobra_rect *clip,
+                                  float x0, float y0, float x1, float y1, float len_sq, float inv_len,
+                                  float width, const cobra_blend *blend, const cobra_line_depth *depth,
+                                  cobra_aa_mode aa_mode);
+
+// Linee SDF con width < 1 (hairline.c): due pixel per passo sull'asse principale, stessa
+// correzione percettiva del percorso generale. Stessi parametri di cobra_raster_line_aa_clipped.
+void cobra_raster_hairline(cobra_surface *surf, const cobra_rect *clip, float x0, float y0, float x1, float y1,
+                           float len_sq, float inv_len, float width, const cobra_blend *blend,
+                           const cobra_line_depth *depth);
+
+// --- Kernel di span (span.c, isa/span.c) ---
+// Filtro box di un semipiano con normale (a, b) (|componenti|, a >= b): la frazione del pixel
+// oltre il bordo a distanza s dal centro è lineare per |s| <= h1 e quadratica fino a h2
+typedef struct cobra_box_shape {
+  float h1, h2;
+  float inv_a, inv_2ab;
+} cobra_box_shape;
+
+static inline void cobra_box_shape_init(cobra_box_shape *b, float a, float c)
+{
+  b->h1 = (a - c) * 0.5f;
+  b->h2 = (a + c) * 0.5f;
+  b->inv_a = 1.0f / a;
+  b->inv_2ab = 0.5f / fmaxf(a * c, 1e-20f);
+}
+
+// Elementi di ogni riga della tabella di copertura (COBRA_AA_LUT)
+#define COBRA_COVERAGE_LUT_SIZE 64
+
+// Parametri di uno span perpendicolare del rasterizzatore SDF.
+// t/d sono la coordinata lungo la linea (normalizzata) e la distanza perpendicolare.
+typedef struct cobra_sdf_span {
+  float t0, d0;       // valori al primo pixel dello span
+  float dt, dd;       // incremento per pixel lungo lo span
+  float len_sq;
+  float r_in_sq;      // sotto questa distanza^2 copertura piena
+  float r_out_sq;     // sopra questa distanza^2 copertura nulla
+  float r_out;
+  // Copertura nella fascia AA (COBRA_AA_SDF, LUT o BOX, vedi cobra_span_setup_coverage)
+  cobra_aa_mode aa;
+  const float *lut;           // LUT: riga della tabella per il raggio della linea
+  float lut_lo_sq, lut_scale; // LUT: indice = (distanza^2 - lut_lo_sq) * lut_scale
+  float radius, len;          // BOX: semispessore e lunghezza del segmento
+  float ux, uy;               // BOX: versore della linea
+  cobra_box_shape box;        // BOX: filtro per la normale della linea (corpo)
+  cobra_blend blend;
+  // Profondità del pixel: z0 + clamp(t, 0, 1) * dz (usate solo con un depth buffer)
+  float z0, dz;
+  cobra_depth_func depth_func;
+  bool depth_write;
+  // Layout a tile: distanza tra tile consecutivi lungo lo span (0 = layout lineare) e
+  // posizione del primo pixel dentro il suo tile
+  long tile_jump;
+  int tile_pos;
+} cobra_sdf_span;
+
+// Copertura SDF e blending di 'count' pixel a partire da 'dst', distanti 'stride' uint32
+// l'uno dall'altro (nel layout a tile: dentro lo stesso tile, vedi tile_jump).
+// Tutti i pixel devono essere già dentro il buffer (nessun bounds check).
+// 'depth' punta al valore dello z_buffer del primo pixel (stesso stride), NULL = nessun test.
+void cobra_span_sdf(uint32_t *dst, float *depth, int stride, int count, const cobra_sdf_span *s);
+
+// Kernel di cobra_span_sdf specializzato per lo stato di 's' (copertura, blending, colore opaco,
+// layout) e per la presenza del depth buffer: va scelto una volta per linea, dopo il setup di 's'.
+// Con depth = false il kernel ignora il puntatore dello z_buffer.
+typedef void (*cobra_span_kernel)(uint32_t *dst, float *depth, int stride, int count, const cobra_sdf_span *s);
+cobra_span_kernel cobra_span_select(const cobra_sdf_span *s, bool depth);
+
+// Prepara 's' per la copertura LUT o BOX (soglie r_in/r_out comprese) di una linea di raggio
+// 'radius', versore (ux, uy) e lunghezza 'len'. Con le altre modalità la copertura resta SDF.
+void cobra_span_setup_coverage(cobra_sdf_span *s, cobra_aa_mode mode, float radius, float ux, float uy, float len);
+
+// --- Linee spesse per scanline (capsule.c) ---
+// Capsula di una linea AA pronta per la rasterizzazione a righe: geometria, parametri del
+// kernel di span e raggi entro cui la copertura è non nulla (r_edge) o piena (r_solid).
+// Con columns le "righe" sono le colonne dello schermo: geometria e coordinate di tutte le
+// funzioni qui sotto hanno x e y scambiate (riga y = colonna y, pixel x = riga x).
+typedef struct cobra_capsule {
+  cobra_surface *surf;
+  bool columns;
+  int stride;                         // distanza in memoria tra pixel consecutivi di una riga
+  float x0, y0, x1, y1;
+  float dt_dx, dt_dy, dd_dx, dd_dy;   // gradienti di t (lungo la linea) e d (perpendicolare)
+  float inv_dt_dx, inv_dd_dx;         // reciproci (0 se il gradiente in x è nullo)
+  float r_edge, r_solid;              // r_solid = 0: nessun riempimento senza copertura
+  cobra_sdf_span sdf;                 // t0/d0/tile_pos aggiornati a ogni span
+  const cobra_line_depth *depth;      // NULL = nessun test
+  float *z_buffer;
+  cobra_span_kernel span;             // kernel SDF specializzato, scelto nel setup
+  // Supersampling RGSS invece del kernel di copertura (NULL = kernel SDF), anch'esso specializzato
+  void (*ss)(const struct cobra_capsule *c, int y, float t, float d, int xa, int xb);
+  float ss_dt[4], ss_dd[4];           // scostamenti di t e d dei 4 campioni dal centro del pixel
+  float radius;
+} cobra_capsule;
+
+// Setup della capsula (x0, y0) - (x1, y1): len_sq > 0, inv_len = 1/sqrt(len_sq).
+// 'blend' viene copiato, 'depth' deve restare valido finché la capsula è in uso.
+// columns = true scandisce per colonne (per le linee con |dy| > |dx|).
+void cobra_capsule_init(cobra_capsule *c, cobra_surface *surf, float x0, float y0, float x1, float y1,
+                        float len_sq, float inv_len, float width, const cobra_blend *blend,
+                        const cobra_line_depth *depth, cobra_aa_mode aa_mode, bool columns);
+// Tutti i pixel della capsula dentro 'clip' (coordinate dello schermo), con cobra_capsule_shade
+void cobra_capsule_raster(cobra_capsule *c, const cobra_rect *clip);
+// Righe [*ya, *yb] dentro 'clip' (coordinate dello schermo) con pixel coperti (false se nessuna)
+bool cobra_capsule_rows(const cobra_capsule *c, const cobra_rect *clip, int *ya, int *yb);
+// Colonne [*xa, *xb] della riga y, dentro [cx0, cx1), con copertura possibile (false se nessuna)
+bool cobra_capsule_cols(const cobra_capsule *c, int y, int cx0, int cx1, int *xa, int *xb);
+// Copertura e blending dei pixel da xa a xb della riga y (nessuno se xa > xb)
+void cobra_capsule_span(cobra_capsule *c, int y, int xa, int xb);
+// Come cobra_capsule_span, ma l'interno a copertura piena viene riempito senza calcolarla
+void cobra_capsule_shade(cobra_capsule *c, int y, int xa, int xb);
+
+// --- Polilinee (polyline.c) ---
+// Raccordo in un vertice della polilinea: calcolato una volta e condiviso dai due segmenti,
+// che si dividono i pixel lungo la bisettrice (il confine è lo stesso per entrambi)
+typedef struct cobra_stroke_joint {
+  float vx, vy;              // vertice
+  float nx, ny;              // normale del confine, verso il segmento uscente
+  float slope;               // -ny / nx: il confine taglia la riga yc in x = vx + (yc - vy) * slope
+  float ext;                 // MITER: prolungamento dei due segmenti oltre il vertice
+  float cx0, cy0, cx1, cy1;  // BEVEL: asse della capsula con il bordo sulla corda
+  float chord_width;
+  bool cut, bevel;           // cut = false: percorso che torna su se stesso, punte tonde
+} cobra_stroke_joint;
+
+// Raccordo nel vertice V tra i segmenti A -> V e V -> B (distinti)
+void cobra_stroke_joint_init(cobra_stroke_joint *j, float ax, float ay, float vx, float vy,
+                             float bx, float by, float width, cobra_line_join join);
+
+// Come cobra_raster_line_aa per un segmento di polilinea. start/end: raccordi agli estremi
+// (NULL = punta tonda). 'depth' si riferisce a (x0, y0) - (x1, y1); width >= 1 con COBRA_AA_SDF.
+bool cobra_raster_stroke(cobra_surface *surf, const cobra_rect *clip, float x0, float y0, float x1, float y1,
+                         const cobra_stroke_joint *start, const cobra_stroke_joint *end, float width,
+                         const cobra_blend *blend, const cobra_line_depth *depth, cobra_aa_mode aa_mode);
+
+// Distanza massima dal segmento dei pixel che riceve: lo spigolo MITER sporge oltre il raggio
+// fino a COBRA_MITER_LIMIT volte, rampa AA compresa
+static inline float cobra_stroke_reach(float width, cobra_line_join join)
+{
+  return join == COBRA_JOIN_MITER ? (width * 0.5f + 1.0f) * COBRA_MITER_LIMIT : width * 0.5f;
+}
+
+// Segmento registrato in modalità differita: i raccordi si ricalcolano dai vertici vicini
+typedef struct cobra_stroke_seg {
+  float x0, y0, x1, y1;
+  float px, py;             // vertice precedente (se has_prev)
+  float nx, ny;             // vertice successivo (se has_next)
+  bool has_prev, has_next;
+} cobra_stroke_seg;
+
+// --- Triangoli (triangle.c, isa/triangle.c) ---
+// Guard band dei triangoli: i lati vengono tagliati in 3D solo oltre uno schermo di distanza,
+// il resto lo scarta il bounding box del rasterizzatore
+static inline float cobra_triangle_guard(const cobra_surface *surf)
+{
+  return (float)(surf->width > surf->height ? surf->width : surf->height);
+}
+
+// Triangolo in coordinate schermo. z: profondità 0..1 dei vertici (cobra_depth_from_z),
+// NULL = nessun test; con z vale lo stato di profondità della superficie.
+void cobra_raster_triangle(cobra_surface *surf, const float *x, const float *y, const float *z,
+                           const cobra_blend *blend);
+// Triangolo in spazio camera a cavallo del frustum: clipping, proiezione e ventaglio
+void cobra_raster_triangle_3d(cobra_surface *surf, const cobra_frustum *f, const cobra_vec3 *v,
+                              const cobra_blend *blend, bool depth);
+
+// Edge function E(px, py) = a * px + b * py + c sui centri dei pixel (interi), E >= 0 dentro
+typedef struct cobra_tri_edge {
+  int64_t a, b, c;
+} cobra_tri_edge;
+
+// Setup comune a tutti i blocchi del triangolo
+typedef struct cobra_tri_setup {
+  cobra_tri_edge e[3];
+  float z0, dzdx, dzdy; // piano della profondità: z0 al pixel (0, 0)
+  cobra_blend blend;
+  cobra_depth_func depth_func;
+  bool depth_write;
+} cobra_tri_setup;
+
+// Attraversamento a blocchi del bounding box [x_min, x_max] x [y_min, y_max] (già dentro la
+// superficie), specializzato per modalità di blending e test di profondità
+typedef void (*cobra_tri_kernel)(cobra_surface *surf, const cobra_tri_setup *t, int x_min, int y_min,
+                                 int x_max, int y_max);
+
+// --- Nuvole di punti (points.c, isa/points.c) ---
+#define COBRA_POINT_CHUNK 256
+
+typedef struct cobra_point_chunk {
+  float x[COBRA_POINT_CHUNK], y[COBRA_POINT_CHUNK], z[COBRA_POINT_CHUNK]; // spazio camera
+  float sx[COBRA_POINT_CHUNK], sy[COBRA_POINT_CHUNK];                     // schermo
+  float depth[COBRA_POINT_CHUNK];   // profondità 0..1 (cobra_depth_from_z)
+  int visible[COBRA_POINT_CHUNK];   // indici dei punti visibili nel blocco
+} cobra_point_chunk;
+
+// Parametri comuni a tutti i blocchi di una draw call
+typedef struct cobra_point_view {
+  float fov, half_w, half_h;
+  float near_plane, far_plane, depth_range;
+  float min_x, min_y, max_x, max_y; // schermo allargato del raggio di splat
+} cobra_point_view;
+
+// --- Kernel per set di istruzioni (isa/*.c, dispatch.c) ---
+// I kernel più caldi sono compilati in più varianti (scalar, sse2, avx2, avx512) e
+// cobra_simd_init sceglie la migliore supportata dalla CPU. Le varianti danno risultati identici.
+// Span SDF, triangoli e proiezione dei punti non hanno una variante avx512 (usano quella avx2).
+typedef struct cobra_kernel_table {
+  const char *name;
+  void (*span_fill)(uint32_t *dst, long count, uint32_t value, bool stream);
+  void (*span_blend)(uint32_t *dst, int count, const cobra_blend *b);
+  void (*transform_points)(const cobra_mat4 *m, const c_float *x, const c_float *y, const c_float *z,
+                           c_float *out_x, c_float *out_y, c_float *out_z, c_float *out_w, int count);
+  const cobra_span_kernel (*span_kernels)[4][4]; // [copertura][blending][tiled * 2 + depth]
+  const cobra_tri_kernel (*tri_kernels)[2];      // [blending][depth]
+  // Proiezione e culling di un blocco: restituisce i punti visibili, elencati in c->visible
+  int (*project_points)(const cobra_point_view *v, cobra_point_chunk *c, int n);
+} cobra_kernel_table;
+
+// La tabella può essere scritta da cobra_simd_init mentre altri thread la leggono:
+// ogni campo si legge e si scrive con accessi atomici (qualunque valore è un kernel valido)
+extern cobra_kernel_table cobra_kernels;
+#define COBRA_KERNEL(field) __atomic_load_n(&cobra_kernels.field, __ATOMIC_RELAXED)
+
+// Sceglie la variante dei kernel (una sola volta; le chiamate successive non fanno nulla).
+// Chiamata da cobra_surface_create e cobra_window_create.
+void cobra_simd_init(void);
+
+// Blending a copertura piena di 'count' pixel consecutivi (interno delle linee spesse).
+static inline void cobra_span_blend(uint32_t *dst, int count, const cobra_blend *b)
+{
+  COBRA_KERNEL(span_blend)(dst, count, b);
+}
+
+// Riempie 'count' uint32 consecutivi con 'value'.
+// stream = true usa store non-temporal (per regioni più grandi della cache).
+static inline void cobra_span_fill(uint32_t *dst, long count, uint32_t value, bool stream)
+{
+  COBRA_KERNEL(span_fill)(dst, count, value, stream);
+}
+
+// --- Occlusion culling (hiz.c) ---
+// Clear della profondità: tutta la piramide vale 'depth'
+void cobra_hiz_clear(cobra_surface *surf, float depth);
+// Test del box contro la piramide; 'margin' allarga il rettangolo a schermo (guard band delle linee)
+bool cobra_hiz_occluded(cobra_surface *surf, const cobra_mat4 *model_view, float fov,
+                        cobra_vec3 min, cobra_vec3 max, float margin);
+
+// --- Arena per frame (arena.c) ---
+// Blocco di 'size' byte allineato a COBRA_ARENA_ALIGN, valido fino al reset (NULL = memoria esaurita)
+void *cobra_arena_alloc(cobra_arena *a, size_t size);
+// Garantisce almeno 'size' byte in b. Se l'ultimo blocco dell'arena è b si estende sul posto,
+// altrimenti si prende un blocco nuovo (con 'keep' il contenuto viene copiato).
+void *cobra_arena_reserve(cobra_arena *a, cobra_arena_buf *b, size_t size, bool keep);
+// Sostituisce il blocco principale con uno di almeno 'capacity' byte (solo con l'arena vuota)
+bool cobra_arena_grow(cobra_arena *a, size_t capacity);
+void cobra_arena_reset(cobra_arena *a);
+void cobra_arena_destroy(cobra_arena *a);
+
+// --- Modalità differita (deferred.c) ---
+void cobra_deferred_record_line_aa(cobra_surface *surf, float x0, float y0, float x1, float y1,
+                                   float width, uint32_t color, const cobra_line_depth *depth, cobra_aa_mode aa_mode);
+void cobra_deferred_record_stroke(cobra_surface *surf, const cobra_stroke_seg *seg, float width,
+                                  cobra_line_join join, const cobra_blend *blend,
+                                  const cobra_line_depth *depth, cobra_aa_mode aa_mode);
+// Scarta i comandi in attesa (usato dai clear quando sovrascrivono tutto ciò che scriverebbero)
+void cobra_deferred_discard(cobra_surface *surf);
+// true se qualche comando in attesa scrive lo z_buffer: un clear del solo colore non può scartarlo
+bool cobra_deferred_depth_pending(const cobra_surface *surf);
+
+// --- Statistiche (stats.c) ---
+// Senza COBRA_STATS le macro non generano codice: gli argomenti di COBRA_STAT_ADD devono essere
+// espressioni senza effetti collaterali (di solito accumulatori locali, eliminati dal compilatore).
+// Uno scope aperto con COBRA_SCOPE_BEGIN va chiuso con COBRA_SCOPE_END su ogni uscita:
+// le funzioni con più return lo aprono in un wrapper.
+typedef enum cobra_timer {
+  COBRA_TIMER_NONE = -1, // solo evento di traccia
+  COBRA_TIMER_CLEAR,
+  COBRA_TIMER_RASTER,
+  COBRA_TIMER_PRESENT,
+  COBRA_TIMER_COUNT
+} cobra_timer;
+
+#ifdef COBRA_STATS
+#include "cobragl/stats.h"
+
+typedef struct cobra_scope {
+  const char *name; // NULL = nessun evento di traccia (primitive singole)
+  cobra_timer timer;
+  bool outer;       // scope più esterno della sua categoria su questo thread
+  bool traced;
+  uint64_t t0;
+} cobra_scope;
+
+extern cobra_stats cobra_stats_current;
+void cobra_scope_begin(cobra_scope *s, const char *name, cobra_timer timer);
+void cobra_scope_end(cobra_scope *s);
+
+#define COBRA_STAT_ADD(field, n) __atomic_fetch_add(&cobra_stats_current.field, (uint64_t)(n), __ATOMIC_RELAXED)
+#define COBRA_SCOPE_BEGIN(var, name, timer) cobra_scope var; cobra_scope_begin(&var, name, timer)
+#define COBRA_SCOPE_END(var) cobra_scope_end(&var)
+#else
+#define COBRA_STAT_ADD(field, n) ((void)(n))
+#define COBRA_SCOPE_BEGIN(var, name, timer) ((void)0)
+#define COBRA_SCOPE_END(var) ((void)0)
+#endif
+
+#endif // COBRAGL_INTERNAL_H
@@ -0,0 +1,20 @@
+#ifndef COBRAGL_ISA_H
+#define COBRAGL_ISA_H
+
+// Intestazione comune dei file compilati una volta per set di istruzioni (vedi dispatch.c).
+// Il Makefile li compila con -DCOBRA_ISA=<variante> e i flag del set: ISA_FN aggiunge la
+// variante ai nomi esportati (cobra_span_fill -> cobra_span_fill_avx2), così gli oggetti di
+// tutte le varianti convivono nello stesso binario.
+
+#include "../internal.h"
+#include "../simd.h"
+
+#ifndef COBRA_ISA
+#error "COBRA_ISA non definito: il file va compilato con -DCOBRA_ISA=<variante> (vedi Makefile)"
+#endif
+
+#define ISA_CAT2(name, isa) name##_##isa
+#define ISA_CAT(name, isa) ISA_CAT2(name, isa)
+#define ISA_FN(name) ISA_CAT(name, COBRA_ISA)
+
+#endif // COBRAGL_ISA_H
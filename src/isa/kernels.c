@@ -0,0 +1,117 @@
+// Fill, blending a copertura piena e trasformazione dei vertici, compilati una volta per set di
+// istruzioni (isa.h, dispatch.c): scalar, sse2, avx2 e avx512. Il corpo è unico e si appoggia a
+// simd.h, che sceglie la larghezza dei vettori dai flag del compilatore; la variante scalare
+// (COBRA_ISA_SCALAR) non usa registri SIMD.
+// Tutte le varianti producono risultati identici: stesse operazioni intere, e per la
+// trasformazione stesse operazioni float nello stesso ordine (senza FMA).
+
+#include "isa.h"
+
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+
+void ISA_FN(cobra_span_fill)(uint32_t *dst, long count, uint32_t value, bool stream)
+{
+  long k = 0;
+
+#ifdef COBRA_SIMD_LANES
+  // Prologo scalare fino all'allineamento del vettore (richiesto dagli store allineati e non-temporal)
+  while (k < count && ((uintptr_t)(dst + k) & (sizeof(vi) - 1)))
+    dst[k++] = value;
+
+  vi v = VI_SET1(value);
+  if (stream) {
+    // Store non-temporal: scrivono in memoria senza passare dalla cache,
+    // così un clear grande non espelle i dati utili al frame.
+    for (; k + COBRA_SIMD_LANES <= count; k += COBRA_SIMD_LANES)
+      VI_STREAM(dst + k, v);
+    _mm_sfence();
+  } else {
+    for (; k + COBRA_SIMD_LANES <= count; k += COBRA_SIMD_LANES)
+      VI_STORE_A(dst + k, v);
+  }
+#else
+  (void)stream;
+#endif
+
+  // Coda (o versione scalare)
+  for (; k < count; k++)
+    dst[k] = value;
+}
+
+// Copertura piena: lo stesso risultato di cobra_blend_* con cov = 256, senza calcolarla
+KERNEL_INLINE void span_blend(uint32_t *dst, int count, const cobra_blend *b, cobra_blend_mode mode)
+{
+  int k = 0;
+#ifdef COBRA_SIMD_LANES
+  const vi color = VI_SET1(b->color);
+  const vi inv = VI_SET1((uint32_t)(256 - b->alpha) * 0x00010001u);
+  for (; k + COBRA_SIMD_LANES <= count; k += COBRA_SIMD_LANES) {
+    vi bg = VI_LOAD(dst + k);
+    vi out;
+    switch (mode) {
+    case COBRA_BLEND_ADDITIVE: out = VI_ADDS8(bg, color); break;
+    case COBRA_BLEND_MAX:      out = VI_MAX8(bg, color); break;
+    default:                   out = VI_ADDS8(color, cobra_scale_lanes(bg, inv)); break;
+    }
+    VI_STORE(dst + k, out);
+  }
+#endif
+  for (; k < count; k++) {
+    switch (mode) {
+    case COBRA_BLEND_ADDITIVE: cobra_blend_additive(&dst[k], b, 256); break;
+    case COBRA_BLEND_MAX:      cobra_blend_max(&dst[k], b, 256); break;
+    default:                   cobra_blend_over(&dst[k], b, 256); break;
+    }
+  }
+}
+
+void ISA_FN(cobra_span_blend)(uint32_t *dst, int count, const cobra_blend *b)
+{
+  switch (b->mode) {
+  case COBRA_BLEND_ADDITIVE: span_blend(dst, count, b, COBRA_BLEND_ADDITIVE); break;
+  case COBRA_BLEND_MAX:      span_blend(dst, count, b, COBRA_BLEND_MAX); break;
+  default:
+    // Colore opaco: il blending è una semplice scrittura
+    if (b->alpha >= 256)
+      ISA_FN(cobra_span_fill)(dst, count, b->color, false);
+    else
+      span_blend(dst, count, b, COBRA_BLEND_OVER);
+    break;
+  }
+}
+
+// Una sola matrice precalcolata (nessuna trigonometria per vertice) applicata a
+// COBRA_SIMD_LANES vertici per iterazione: ogni componente in uscita è una combinazione
+// lineare delle colonne x, y, z, con gli elementi della matrice replicati nei lane.
+// La coda usa la versione scalare con le stesse operazioni nello stesso ordine.
+void ISA_FN(cobra_transform_points)(const cobra_mat4 *m, const c_float *x, const c_float *y, const c_float *z,
+                                    c_float *out_x, c_float *out_y, c_float *out_z, c_float *out_w, int count)
+{
+  int i = 0;
+
+#ifdef COBRA_SIMD_LANES
+  const vf m00 = VF_SET1(m->m[0][0]), m10 = VF_SET1(m->m[1][0]), m20 = VF_SET1(m->m[2][0]), m30 = VF_SET1(m->m[3][0]);
+  const vf m01 = VF_SET1(m->m[0][1]), m11 = VF_SET1(m->m[1][1]), m21 = VF_SET1(m->m[2][1]), m31 = VF_SET1(m->m[3][1]);
+  const vf m02 = VF_SET1(m->m[0][2]), m12 = VF_SET1(m->m[1][2]), m22 = VF_SET1(m->m[2][2]), m32 = VF_SET1(m->m[3][2]);
+  const vf m03 = VF_SET1(m->m[0][3]), m13 = VF_SET1(m->m[1][3]), m23 = VF_SET1(m->m[2][3]), m33 = VF_SET1(m->m[3][3]);
+
+  for (; i + COBRA_SIMD_LANES <= count; i += COBRA_SIMD_LANES) {
+    // Tutti i load prima degli store: la trasformazione in place resta corretta
+    vf px = VF_LOAD(x + i), py = VF_LOAD(y + i), pz = VF_LOAD(z + i);
+    VF_STORE(out_x + i, VF_ADD(VF_ADD(VF_ADD(VF_MUL(m00, px), VF_MUL(m10, py)), VF_MUL(m20, pz)), m30));
+    VF_STORE(out_y + i, VF_ADD(VF_ADD(VF_ADD(VF_MUL(m01, px), VF_MUL(m11, py)), VF_MUL(m21, pz)), m31));
+    VF_STORE(out_z + i, VF_ADD(VF_ADD(VF_ADD(VF_MUL(m02, px), VF_MUL(m12, py)), VF_MUL(m22, pz)), m32));
+    if (out_w)
+      VF_STORE(out_w + i, VF_ADD(VF_ADD(VF_ADD(VF_MUL(m03, px), VF_MUL(m13, py)), VF_MUL(m23, pz)), m33));
+  }
+#endif
+
+  for (; i < count; i++) {
+    c_float px = x[i], py = y[i], pz = z[i];
+    out_x[i] = m->m[0][0] * px + m->m[1][0] * py + m->m[2][0] * pz + m->m[3][0];
+    out_y[i] = m->m[0][1] * px + m->m[1][1] * py + m->m[2][1] * pz + m->m[3][1];
+    out_z[i] = m->m[0][2] * px + m->m[1][2] * py + m->m[2][2] * pz + m->m[3][2];
+    if (out_w)
+      out_w[i] = m->m[0][3] * px + m->m[1][3] * py + m->m[2][3] * pz + m->m[3][3];
+  }
+}
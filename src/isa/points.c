@@ -0,0 +1,54 @@
+// Proiezione e culling dei punti (vedi points.c), compilati per ogni set di istruzioni (isa.h).
+// COBRA_SIMD_LANES punti per iterazione (la variante avx512 usa quella avx2); la coda del blocco
+// usa la versione scalare con le stesse operazioni nello stesso ordine.
+
+#include "isa.h"
+
+// Proiezione e culling: restituisce il numero di punti visibili, i cui indici finiscono in c->visible
+int ISA_FN(cobra_project_points)(const cobra_point_view *v, cobra_point_chunk *c, int n)
+{
+  int m = 0, i = 0;
+
+#ifdef COBRA_SIMD_LANES
+  const vf one = VF_SET1(1.0f), fov = VF_SET1(v->fov);
+  const vf half_w = VF_SET1(v->half_w), half_h = VF_SET1(v->half_h);
+  const vf near_plane = VF_SET1(v->near_plane), far_plane = VF_SET1(v->far_plane);
+  const vf range = VF_SET1(v->depth_range);
+  const vf min_x = VF_SET1(v->min_x), min_y = VF_SET1(v->min_y);
+  const vf max_x = VF_SET1(v->max_x), max_y = VF_SET1(v->max_y);
+
+  for (; i + COBRA_SIMD_LANES <= n; i += COBRA_SIMD_LANES) {
+    vf z = VF_LOAD(c->z + i);
+    vf inv_z = VF_DIV(one, z);
+    vf sx = VF_ADD(VF_MUL(VF_MUL(VF_LOAD(c->x + i), fov), inv_z), half_w);
+    vf sy = VF_SUB(half_h, VF_MUL(VF_MUL(VF_LOAD(c->y + i), fov), inv_z));
+    // Dietro la camera inv_z è negativo o infinito: near scarta il punto prima dello schermo
+    vf in = VF_AND(VF_GE(z, near_plane), VF_LE(z, far_plane));
+    in = VF_AND(in, VF_AND(VF_GE(sx, min_x), VF_LT(sx, max_x)));
+    in = VF_AND(in, VF_AND(VF_GE(sy, min_y), VF_LT(sy, max_y)));
+    VF_STORE(c->sx + i, sx);
+    VF_STORE(c->sy + i, sy);
+    VF_STORE(c->depth + i, VF_MUL(VF_SUB(one, VF_MUL(near_plane, inv_z)), range));
+
+    unsigned bits = (unsigned)VF_MOVEMASK(in);
+    while (bits) {
+      c->visible[m++] = i + __builtin_ctz(bits);
+      bits &= bits - 1;
+    }
+  }
+#endif
+
+  for (; i < n; i++) {
+    float z = c->z[i];
+    float inv_z = 1.0f / z;
+    float sx = c->x[i] * v->fov * inv_z + v->half_w;
+    float sy = v->half_h - c->y[i] * v->fov * inv_z;
+    c->sx[i] = sx;
+    c->sy[i] = sy;
+    c->depth[i] = (1.0f - v->near_plane * inv_z) * v->depth_range;
+    if (z >= v->near_plane && z <= v->far_plane && sx >= v->min_x && sx < v->max_x &&
+        sy >= v->min_y && sy < v->max_y)
+      c->visible[m++] = i;
+  }
+  return m;
+}
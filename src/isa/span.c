@@ -0,0 +1,405 @@
+// Kernel di span per il rasterizzatore SDF delle linee AA, compilati per ogni set di
+// istruzioni (isa.h): span.c prepara i parametri e sceglie il kernel dalla variante in uso.
+//
+// Per ogni pixel dello span calcoliamo t (posizione lungo il segmento), d (distanza
+// perpendicolare), la copertura della capsula e il blending con lo sfondo.
+// Con SSE2 elaboriamo 4 pixel per istruzione, con AVX2 8; la variante avx512 usa quella avx2.
+// I risultati sono identici alla versione scalare: stesse operazioni, stesso ordine,
+// stessa conversione per troncamento dopo il +0.5.
+// Il blending è intero come in internal.h: le coppie di canali B/R e G/A occupano le due
+// metà a 16 bit di ogni lane, quindi una moltiplicazione a 16 bit scala due canali.
+// Con un depth buffer il test di profondità viene prima della copertura: i pixel nascosti
+// non pagano né la radice quadrata né il blending.
+//
+// Nella fascia AA la copertura dipende dalla modalità (cobra_aa_mode):
+// - SDF: rampa lineare r_out - distanza, la più economica;
+// - LUT: tabella indicizzata con la distanza^2 quantizzata, nessuna radice quadrata. Le righe
+//   sono precalcolate per raggi multipli di 1/16 px con un filtro a disco di area unitaria,
+//   quindi le linee sottili hanno la larghezza reale e i bordi il profilo di un filtro;
+// - BOX: area esatta del pixel dentro la striscia del corpo (filtro box, dipende dall'angolo).
+//   Sulle punte il bordo è approssimato con il semipiano tangente alla capsula.
+
+#include "isa.h"
+#include <math.h>
+
+#if defined(COBRA_SIMD_LANES) && COBRA_SIMD_LANES > 8
+#error "i kernel di span usano al più 8 lane"
+#endif
+
+// Le varianti per modalità di blending, colore opaco, copertura, test di profondità e layout
+// vengono espanse con 'mode', 'opaque', 'aa', 'depth' e 'tiled' costanti: ogni combinazione è
+// una funzione separata, scelta una volta per linea da cobra_span_select.
+#define SPAN_INLINE static inline __attribute__((always_inline))
+
+// --- Copertura BOX ---
+// Frazione del pixel dalla parte interna di un bordo a distanza s dal centro
+SPAN_INLINE float box_area(float s, const cobra_box_shape *b)
+{
+  float sc = fminf(fmaxf(s, -b->h2), b->h2);
+  float u = fabsf(sc);
+  float w = b->h2 - u;
+  float half = (u <= b->h1) ? u * b->inv_a : 0.5f - w * w * b->inv_2ab;
+  return (sc < 0.0f) ? 0.5f - half : 0.5f + half;
+}
+
+// Sotto questa distanza^2 dall'estremo (lungo la linea) una punta usa la normale del corpo
+#define BOX_CAP_EPS 1e-8f
+
+// Copertura nella fascia AA (r_in_sq <= dist_sq <= r_out_sq), in [0, 1].
+// dtc è lo sforamento di t oltre il segmento (0 sul corpo), d la distanza perpendicolare.
+SPAN_INLINE float band_alpha(float dist_sq, float dtc, float d, const cobra_sdf_span *s, cobra_aa_mode aa)
+{
+  if (aa == COBRA_AA_LUT) {
+    float x = fminf(fmaxf((dist_sq - s->lut_lo_sq) * s->lut_scale, 0.0f), COBRA_COVERAGE_LUT_SIZE - 1);
+    return s->lut[(int)x];
+  }
+  float alpha;
+  if (aa == COBRA_AA_BOX) {
+    float dist = sqrtf(dist_sq);
+    cobra_box_shape b = s->box;
+    float along = dtc * s->len;
+    if (along * along > BOX_CAP_EPS) {
+      // Punta: normale del bordo lungo la direzione dall'estremo al pixel
+      float nx = fabsf(along * s->ux - d * s->uy);
+      float ny = fabsf(along * s->uy + d * s->ux);
+      float inv = 1.0f / dist;
+      cobra_box_shape_init(&b, fmaxf(nx, ny) * inv, fminf(nx, ny) * inv);
+    }
+    alpha = box_area(s->radius - dist, &b) - box_area(-s->radius - dist, &b);
+    return alpha <= 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha);
+  }
+  alpha = s->r_out - sqrtf(dist_sq);
+  if (alpha <= 0.0f) alpha = 0.0f;
+  else if (alpha > 1.0f) alpha = 1.0f;
+  return alpha;
+}
+
+// Copertura e blending di un singolo pixel (versione scalare di riferimento).
+// Restituisce true se il pixel è stato scritto.
+SPAN_INLINE bool shade_pixel(uint32_t *p, float *zp, float t, float d, const cobra_sdf_span *s,
+                             cobra_blend_mode mode, bool opaque, cobra_aa_mode aa, bool depth)
+{
+  float tc = t;
+  if (tc < 0.0f) tc = 0.0f;
+  else if (tc > 1.0f) tc = 1.0f;
+
+  float z = 0.0f;
+  if (depth) {
+    z = s->z0 + tc * s->dz;
+    if (!cobra_depth_test(s->depth_func, z, *zp))
+      return false;
+  }
+
+  float dtc = t - tc;
+  float dist_sq = d * d + (dtc * dtc) * s->len_sq;
+
+  float alpha;
+  if (dist_sq < s->r_in_sq) {
+    // Interno pieno (Core)
+    alpha = 1.0f;
+  } else if (dist_sq > s->r_out_sq) {
+    // Esterno vuoto -> Skip
+    return false;
+  } else {
+    // Fascia AA
+    alpha = band_alpha(dist_sq, dtc, d, s, aa);
+  }
+
+  uint32_t cov = cobra_coverage(alpha);
+  if (!cov) return false;
+
+  // La profondità viene scritta solo dove la linea copre almeno metà del pixel
+  if (depth && s->depth_write && cov >= 128)
+    *zp = z;
+
+  switch (mode) {
+  case COBRA_BLEND_ADDITIVE: cobra_blend_additive(p, &s->blend, cov); break;
+  case COBRA_BLEND_MAX:      cobra_blend_max(p, &s->blend, cov); break;
+  default:
+    // Con alpha 256 il fattore dello sfondo è 256 - cov (cobra_blend_over senza il prodotto)
+    if (opaque)
+      *p = cov >= 256 ? s->blend.color : cobra_swar_adds(cobra_swar_scale(s->blend.color, cov), cobra_swar_scale(*p, 256 - cov));
+    else
+      cobra_blend_over(p, &s->blend, cov);
+    break;
+  }
+  return true;
+}
+
+#ifdef COBRA_SIMD_LANES
+// Versione vettoriale di box_area: la forma del filtro può cambiare da lane a lane
+SPAN_INLINE vf box_area_lanes(vf sv, vf h1, vf h2, vf inv_a, vf inv_2ab)
+{
+  const vf half_px = VF_SET1(0.5f);
+  vf sc = VF_MIN(VF_MAX(sv, VF_SUB(VF_SET1(0.0f), h2)), h2);
+  vf u = VF_ABS(sc);
+  vf w = VF_SUB(h2, u);
+  vf half = VF_SELECT(VF_LE(u, h1), VF_MUL(u, inv_a), VF_SUB(half_px, VF_MUL(VF_MUL(w, w), inv_2ab)));
+  return VF_SELECT(VF_LT(sc, VF_SET1(0.0f)), VF_SUB(half_px, half), VF_ADD(half_px, half));
+}
+
+// Versione vettoriale di band_alpha (stesse operazioni, stesso ordine)
+SPAN_INLINE vf band_alpha_lanes(vf dist_sq, vf dtc, vf d, const cobra_sdf_span *s, cobra_aa_mode aa)
+{
+  const vf zero = VF_SET1(0.0f);
+  const vf one = VF_SET1(1.0f);
+
+  if (aa == COBRA_AA_LUT) {
+    vf x = VF_MUL(VF_SUB(dist_sq, VF_SET1(s->lut_lo_sq)), VF_SET1(s->lut_scale));
+    x = VF_MIN(VF_MAX(x, zero), VF_SET1((float)(COBRA_COVERAGE_LUT_SIZE - 1)));
+    return VF_GATHER(s->lut, VF_TO_VI(x));
+  }
+  if (aa == COBRA_AA_BOX) {
+    vf dist = VF_SQRT(dist_sq);
+    vf h1 = VF_SET1(s->box.h1), h2 = VF_SET1(s->box.h2);
+    vf inv_a = VF_SET1(s->box.inv_a), inv_2ab = VF_SET1(s->box.inv_2ab);
+    vf along = VF_MUL(dtc, VF_SET1(s->len));
+    vf cap = VF_GT(VF_MUL(along, along), VF_SET1(BOX_CAP_EPS));
+    if (VF_MOVEMASK(cap)) {
+      // Lane sulle punte: filtro per la normale dall'estremo al pixel
+      vf ux = VF_SET1(s->ux), uy = VF_SET1(s->uy);
+      vf nx = VF_ABS(VF_SUB(VF_MUL(along, ux), VF_MUL(d, uy)));
+      vf ny = VF_ABS(VF_ADD(VF_MUL(along, uy), VF_MUL(d, ux)));
+      vf inv = VF_DIV(one, dist);
+      vf a = VF_SELECT(cap, VF_MUL(VF_MAX(nx, ny), inv), VF_SET1(1.0f));
+      vf c = VF_SELECT(cap, VF_MUL(VF_MIN(nx, ny), inv), zero);
+      h1 = VF_SELECT(cap, VF_MUL(VF_SUB(a, c), VF_SET1(0.5f)), h1);
+      h2 = VF_SELECT(cap, VF_MUL(VF_ADD(a, c), VF_SET1(0.5f)), h2);
+      inv_a = VF_SELECT(cap, VF_DIV(one, a), inv_a);
+      inv_2ab = VF_SELECT(cap, VF_DIV(VF_SET1(0.5f), VF_MAX(VF_MUL(a, c), VF_SET1(1e-20f))), inv_2ab);
+    }
+    vf r = VF_SET1(s->radius);
+    vf alpha = VF_SUB(box_area_lanes(VF_SUB(r, dist), h1, h2, inv_a, inv_2ab),
+                      box_area_lanes(VF_SUB(VF_SUB(zero, r), dist), h1, h2, inv_a, inv_2ab));
+    return VF_MIN(VF_MAX(alpha, zero), one);
+  }
+  vf alpha = VF_SUB(VF_SET1(s->r_out), VF_SQRT(dist_sq));
+  return VF_MIN(VF_MAX(alpha, zero), one);
+}
+
+// Calcola il colore finale di COBRA_SIMD_LANES pixel consecutivi dello span.
+// *live riceve la maschera dei lane con copertura > 0 (gli altri restano uguali a bg).
+// Con 'depth' *zb contiene lo z_buffer dei lane e riceve i valori da riscrivere.
+SPAN_INLINE vi shade_lanes(vi bg, vf t, vf d, const cobra_sdf_span *s, vi color, cobra_blend_mode mode,
+                           bool opaque, cobra_aa_mode aa, bool depth, vf *zb, int *live)
+{
+  const vf zero = VF_SET1(0.0f);
+  const vf one = VF_SET1(1.0f);
+
+  vf tc = VF_MIN(VF_MAX(t, zero), one);
+
+  // Test di profondità anticipato: se nessun lane passa usciamo prima della copertura
+  vf z = zero, pass = VF_ONES();
+  if (depth) {
+    z = VF_ADD(VF_SET1(s->z0), VF_MUL(tc, VF_SET1(s->dz)));
+    pass = cobra_depth_lanes(z, *zb, s->depth_func);
+    if (!VF_MOVEMASK(pass)) {
+      *live = 0;
+      return bg;
+    }
+  }
+  vf dtc = VF_SUB(t, tc);
+  vf dist_sq = VF_ADD(VF_MUL(d, d), VF_MUL(VF_MUL(dtc, dtc), VF_SET1(s->len_sq)));
+
+  // Fascia AA per tutti i lane, poi correggiamo interno ed esterno con le maschere
+  vf alpha = band_alpha_lanes(dist_sq, dtc, d, s, aa);
+  alpha = VF_SELECT(VF_GT(dist_sq, VF_SET1(s->r_out_sq)), zero, alpha);
+  alpha = VF_SELECT(VF_LT(dist_sq, VF_SET1(s->r_in_sq)), one, alpha);
+
+  // Copertura in virgola fissa 0..256 (come cobra_coverage): i lane a 0 restano invariati
+  vf cov_f = VF_ADD(VF_MUL(alpha, VF_SET1(256.0f)), VF_SET1(0.5f));
+  vf live_mask = VF_GE(cov_f, one);
+  if (depth) {
+    live_mask = VF_AND(live_mask, pass);
+    if (s->depth_write)
+      *zb = VF_SELECT(VF_AND(live_mask, VF_GE(cov_f, VF_SET1(128.0f))), z, *zb);
+  }
+  *live = VF_MOVEMASK(live_mask);
+  if (!*live)
+    return bg;
+
+  vi cov = VF_TO_VI(cov_f);
+  vi src = cobra_scale_lanes(color, VI_OR(cov, VI_SLLI(cov, 16)));
+
+  vi out;
+  switch (mode) {
+  case COBRA_BLEND_ADDITIVE:
+    out = VI_ADDS8(bg, src);
+    break;
+  case COBRA_BLEND_MAX:
+    out = VI_MAX8(bg, src);
+    break;
+  default: {
+    if (opaque) {
+      // (256 * cov + 128) >> 8 = cov: il fattore dello sfondo è direttamente 256 - cov
+      vi inv = VI_SUB(VI_SET1(256), cov);
+      out = VI_ADDS8(src, cobra_scale_lanes(bg, VI_OR(inv, VI_SLLI(inv, 16))));
+      break;
+    }
+    // alpha * cov + 128 (<= 65664) è esatto in float; * 1/256 e troncamento = >> 8
+    vf a_f = VF_MUL(VF_ADD(VF_MUL(VI_TO_VF(cov), VF_SET1((float)s->blend.alpha)), VF_SET1(128.0f)),
+                    VF_SET1(1.0f / 256.0f));
+    vi inv = VI_SUB(VI_SET1(256), VF_TO_VI(a_f));
+    out = VI_ADDS8(src, cobra_scale_lanes(bg, VI_OR(inv, VI_SLLI(inv, 16))));
+    break;
+  }
+  }
+  return VI_SELECT(live_mask, out, bg);
+}
+#endif
+
+// Corpo del kernel, espanso una volta per ogni combinazione di cobra_span_select
+SPAN_INLINE void span_sdf(uint32_t *dst, float *zdst, int stride, int count, const cobra_sdf_span *s,
+                          cobra_blend_mode mode, bool opaque, cobra_aa_mode aa, bool depth, bool tiled)
+{
+  // d è lineare lungo lo span e dist^2 >= d^2: i pixel con |d| > r_out hanno copertura nulla.
+  // Restringiamo lo span all'intervallo [k_lo, k_hi] dove |d0 + k*dd| <= r_out,
+  // così i lane SIMD lavorano solo sulla fascia utile (arrotondiamo verso l'esterno).
+  int k_lo = 0, k_hi = count - 1;
+  if (s->dd != 0.0f) {
+    float r_lim = sqrtf(s->r_out_sq);
+    float inv_dd = 1.0f / s->dd;
+    float ka = (-r_lim - s->d0) * inv_dd;
+    float kb = ( r_lim - s->d0) * inv_dd;
+    float kmin = fminf(ka, kb), kmax = fmaxf(ka, kb);
+    if (kmax < 0.0f || kmin > (float)(count - 1))
+      return;
+    if (kmin > 0.0f) k_lo = (int)kmin;
+    if (kmax < (float)(count - 1)) k_hi = (int)kmax + 1;
+  } else if (s->d0 * s->d0 > s->r_out_sq) {
+    return;
+  }
+  if (k_hi >= count) k_hi = count - 1;
+
+  const long jump = s->tile_jump;
+  long first = cobra_span_offset(tiled, jump, s->tile_pos, stride, k_lo);
+  const int tile_pos = (s->tile_pos + k_lo) & (COBRA_FB_TILE - 1);
+  dst += first;
+  if (depth)
+    zdst += first;
+  count = k_hi - k_lo + 1;
+  float t0 = s->t0 + (float)k_lo * s->dt;
+  float d0 = s->d0 + (float)k_lo * s->dd;
+
+  int k = 0;
+  int blended = 0; // solo per le statistiche (eliminato senza COBRA_STATS)
+
+#ifdef COBRA_SIMD_LANES
+  static const float lane_index[8] = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f};
+  const vf lanes = VF_LOAD(lane_index);
+  const vf vt0 = VF_SET1(t0), vd0 = VF_SET1(d0);
+  const vf vdt = VF_SET1(s->dt), vdd = VF_SET1(s->dd);
+  const vi color = VI_SET1(s->blend.color);
+
+  for (; k < count; k += COBRA_SIMD_LANES) {
+    int n = count - k;
+    if (n > COBRA_SIMD_LANES) n = COBRA_SIMD_LANES;
+
+    // t0 + k * dt per ogni lane, come nella versione scalare: stessi arrotondamenti con
+    // qualunque numero di lane ((t0 + k * dt) + i * dt darebbe risultati diversi)
+    vf kf = VF_ADD(VF_SET1((float)k), lanes);
+    vf t = VF_ADD(vt0, VF_MUL(kf, vdt));
+    vf d = VF_ADD(vd0, VF_MUL(kf, vdd));
+    // Pixel contigui: span orizzontale con blocco completo (nel layout a tile, dentro un solo tile)
+    if (stride == 1 && n == COBRA_SIMD_LANES &&
+        (!tiled || ((tile_pos + k) & (COBRA_FB_TILE - 1)) + COBRA_SIMD_LANES <= COBRA_FB_TILE)) {
+      long o = cobra_span_offset(tiled, jump, tile_pos, stride, k);
+      uint32_t *p = dst + o;
+      float *zp = depth ? zdst + o : NULL;
+      int live;
+      vf zb = depth ? VF_LOAD(zp) : VF_SET1(0.0f);
+      vi out = shade_lanes(VI_LOAD(p), t, d, s, color, mode, opaque, aa, depth, &zb, &live);
+      if (live) {
+        blended += __builtin_popcount((unsigned)live);
+        VI_STORE(p, out);
+        if (depth && s->depth_write)
+          VF_STORE(zp, zb);
+      }
+      continue;
+    }
+
+    // Span verticale, a cavallo di due tile o coda: raccogliamo i pixel validi,
+    // il resto del vettore resta a zero
+    long off[COBRA_SIMD_LANES];
+    for (int i = 0; i < n; i++)
+      off[i] = cobra_span_offset(tiled, jump, tile_pos, stride, k + i);
+    uint32_t tmp[COBRA_SIMD_LANES] = {0};
+    float ztmp[COBRA_SIMD_LANES] = {0.0f};
+    for (int i = 0; i < n; i++)
+      tmp[i] = dst[off[i]];
+    if (depth) {
+      for (int i = 0; i < n; i++)
+        ztmp[i] = zdst[off[i]];
+    }
+
+    int live;
+    vf zb = VF_LOAD(ztmp);
+    vi out = shade_lanes(VI_LOAD(tmp), t, d, s, color, mode, opaque, aa, depth, &zb, &live);
+    if (!live)
+      continue;
+    VI_STORE(tmp, out);
+
+    // Store mascherato: scriviamo solo i lane dentro lo span con copertura > 0
+    live &= (1 << n) - 1;
+    blended += __builtin_popcount((unsigned)live);
+    for (int i = 0; i < n; i++) {
+      if (live & (1 << i))
+        dst[off[i]] = tmp[i];
+    }
+    if (depth && s->depth_write) {
+      VF_STORE(ztmp, zb);
+      for (int i = 0; i < n; i++) {
+        if (live & (1 << i))
+          zdst[off[i]] = ztmp[i];
+      }
+    }
+  }
+#endif
+
+  // Versione scalare (variante scalar, o coda degli span più corti di un vettore)
+  for (; k < count; k++) {
+    long o = cobra_span_offset(tiled, jump, tile_pos, stride, k);
+    blended += shade_pixel(dst + o, depth ? zdst + o : NULL, t0 + (float)k * s->dt, d0 + (float)k * s->dd,
+                           s, mode, opaque, aa, depth);
+  }
+
+  COBRA_STAT_ADD(pixels_evaluated, count);
+  COBRA_STAT_ADD(pixels_blended, blended);
+}
+
+// Una funzione per combinazione: nel loop restano solo le diramazioni sui dati (copertura,
+// profondità), non quelle sullo stato della linea
+#define SPAN_KERNEL(name, mode, opaque, aa, depth, tiled)                                             \
+  static void name(uint32_t *dst, float *zdst, int stride, int count, const cobra_sdf_span *s)       \
+  {                                                                                                  \
+    span_sdf(dst, zdst, stride, count, s, mode, opaque, aa, depth, tiled);                           \
+  }
+
+// Le quattro varianti di profondità e layout di una modalità di blending e copertura
+#define SPAN_KERNELS(name, mode, opaque, aa)                                                         \
+  SPAN_KERNEL(name##_linear, mode, opaque, aa, false, false)                                         \
+  SPAN_KERNEL(name##_linear_depth, mode, opaque, aa, true, false)                                    \
+  SPAN_KERNEL(name##_tiled, mode, opaque, aa, false, true)                                           \
+  SPAN_KERNEL(name##_tiled_depth, mode, opaque, aa, true, true)
+
+// Le varianti per modalità di blending di una copertura (over opaco a parte)
+#define SPAN_COVERAGE_KERNELS(name, aa)                                                              \
+  SPAN_KERNELS(name##_over, COBRA_BLEND_OVER, false, aa)                                             \
+  SPAN_KERNELS(name##_opaque, COBRA_BLEND_OVER, true, aa)                                            \
+  SPAN_KERNELS(name##_additive, COBRA_BLEND_ADDITIVE, false, aa)                                     \
+  SPAN_KERNELS(name##_max, COBRA_BLEND_MAX, false, aa)
+
+SPAN_COVERAGE_KERNELS(span_ramp, COBRA_AA_SDF)
+SPAN_COVERAGE_KERNELS(span_lut, COBRA_AA_LUT)
+SPAN_COVERAGE_KERNELS(span_box, COBRA_AA_BOX)
+
+#define SPAN_ROW(name) {name##_linear, name##_linear_depth, name##_tiled, name##_tiled_depth}
+#define SPAN_COVERAGE_ROWS(name) \
+  {SPAN_ROW(name##_over), SPAN_ROW(name##_opaque), SPAN_ROW(name##_additive), SPAN_ROW(name##_max)}
+
+// [copertura][blending][tiled * 2 + depth]
+const cobra_span_kernel ISA_FN(cobra_span_kernels)[3][4][4] = {
+    SPAN_COVERAGE_ROWS(span_ramp),
+    SPAN_COVERAGE_ROWS(span_lut),
+    SPAN_COVERAGE_ROWS(span_box),
+};
@@ -0,0 +1,216 @@
+// Attraversamento a blocchi dei triangoli (vedi triangle.c), compilato per ogni set di
+// istruzioni (isa.h). I blocchi 8x8 interamente nella superficie sono valutati con SSE2 o AVX2
+// (la variante avx512 usa quella avx2), quelli tagliati dal bordo dello schermo pixel per pixel.
+// Le due versioni danno lo stesso risultato: stessi test interi, stessa profondità.
+
+#include "isa.h"
+#include <math.h>
+#include <stdint.h>
+
+#define TRI_BLOCK 8
+#if TRI_BLOCK != COBRA_FB_TILE
+#error "i blocchi dei triangoli devono coincidere con i tile del layout a tile"
+#endif
+#if defined(COBRA_SIMD_LANES) && COBRA_SIMD_LANES > TRI_BLOCK
+#error "i blocchi SIMD dei triangoli usano al più TRI_BLOCK lane"
+#endif
+
+#define TRI_INLINE static inline __attribute__((always_inline))
+
+// Colore finale di un pixel coperto (copertura piena). Restituisce true se il pixel è stato scritto.
+TRI_INLINE bool shade_pixel(uint32_t *p, float *zp, float z, const cobra_tri_setup *t, cobra_blend_mode mode, bool depth)
+{
+  if (depth) {
+    if (!cobra_depth_test(t->depth_func, z, *zp))
+      return false;
+    if (t->depth_write)
+      *zp = z;
+  }
+  switch (mode) {
+  case COBRA_BLEND_ADDITIVE: cobra_blend_additive(p, &t->blend, 256); break;
+  case COBRA_BLEND_MAX:      cobra_blend_max(p, &t->blend, 256); break;
+  default:                   cobra_blend_over(p, &t->blend, 256); break;
+  }
+  return true;
+}
+
+// Blocco (anche parziale, ai bordi dello schermo) pixel per pixel.
+// e[k], ey[k], ex[k]: valore al primo pixel e incrementi a 32 bit (0 per i lati accettati).
+// I blocchi restituiscono i pixel scritti (solo per le statistiche).
+TRI_INLINE int block_scalar(cobra_surface *surf, int bx, int by, int w, int h, const int32_t e[3],
+                             const int32_t ex[3], const int32_t ey[3], const cobra_tri_setup *t,
+                             cobra_blend_mode mode, bool depth)
+{
+  int blended = 0;
+  for (int y = 0; y < h; y++) {
+    // I blocchi sono allineati ai tile: una riga di blocco è contigua anche nel layout a tile
+    long row_idx = cobra_pixel_index(surf, bx, by + y);
+    uint32_t *row = &surf->color_buffer[row_idx];
+    float *zrow = depth ? &surf->z_buffer[row_idx] : NULL;
+    float zy = t->z0 + t->dzdy * (float)(by + y);
+    for (int x = 0; x < w; x++) {
+      int32_t e0 = e[0] + x * ex[0] + y * ey[0];
+      int32_t e1 = e[1] + x * ex[1] + y * ey[1];
+      int32_t e2 = e[2] + x * ex[2] + y * ey[2];
+      if ((e0 | e1 | e2) < 0)
+        continue;
+      blended += shade_pixel(&row[x], depth ? &zrow[x] : NULL, zy + t->dzdx * (float)(bx + x), t, mode, depth);
+    }
+  }
+  return blended;
+}
+
+#ifdef COBRA_SIMD_LANES
+// Blending di lane a copertura piena: color è premoltiplicato, inv = 256 - alpha
+TRI_INLINE vi blend_lanes(vi bg, vi color, vi inv16, cobra_blend_mode mode)
+{
+  switch (mode) {
+  case COBRA_BLEND_ADDITIVE: return VI_ADDS8(bg, color);
+  case COBRA_BLEND_MAX:      return VI_MAX8(bg, color);
+  default:                   return VI_ADDS8(color, cobra_scale_lanes(bg, inv16));
+  }
+}
+
+// Blocco 8x8 interamente dentro la superficie. full = true se il blocco è dentro i tre lati.
+TRI_INLINE int block_simd(cobra_surface *surf, int bx, int by, const int32_t e[3],
+                           const int32_t ex[3], const int32_t ey[3], bool full, const cobra_tri_setup *t,
+                           cobra_blend_mode mode, bool depth)
+{
+  static const float lane_f[8] = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f};
+  const bool opaque = (mode == COBRA_BLEND_OVER && t->blend.alpha >= 256);
+  const vi color = VI_SET1(t->blend.color);
+  const uint32_t inv = 256 - t->blend.alpha;
+  const vi inv16 = VI_SET1(inv | (inv << 16));
+  const vi minus_one = VI_SET1(-1);
+  int blended = 0;
+
+  for (int o = 0; o < TRI_BLOCK; o += COBRA_SIMD_LANES) {
+    // Edge function dei lane nella prima riga (SSE2 non ha la moltiplicazione a 32 bit:
+    // gli 8 valori si preparano in scalare una volta per blocco)
+    int32_t tmp[3][COBRA_SIMD_LANES];
+    for (int k = 0; k < 3; k++) {
+      for (int i = 0; i < COBRA_SIMD_LANES; i++)
+        tmp[k][i] = e[k] + (o + i) * ex[k];
+    }
+    vi e0 = VI_LOAD(tmp[0]), e1 = VI_LOAD(tmp[1]), e2 = VI_LOAD(tmp[2]);
+    const vi ey0 = VI_SET1(ey[0]), ey1 = VI_SET1(ey[1]), ey2 = VI_SET1(ey[2]);
+    const vf zx = VF_MUL(VF_ADD(VF_LOAD(lane_f + o), VF_SET1((float)bx)), VF_SET1(t->dzdx));
+
+    for (int y = 0; y < TRI_BLOCK; y++) {
+      long idx = cobra_pixel_index(surf, bx + o, by + y);
+      uint32_t *p = &surf->color_buffer[idx];
+
+      // Copertura: l'OR delle tre edge function è >= 0 solo dentro tutti i lati
+      vf cover = VF_ONES();
+      if (!full) {
+        vi sum = VI_OR(VI_OR(e0, e1), e2);
+        e0 = VI_ADD(e0, ey0);
+        e1 = VI_ADD(e1, ey1);
+        e2 = VI_ADD(e2, ey2);
+        cover = VI_AS_VF(VI_CMPGT(sum, minus_one));
+        if (!VF_MOVEMASK(cover))
+          continue; // nessun pixel coperto in questa riga
+      }
+
+      if (depth) {
+        float *zp = &surf->z_buffer[idx];
+        vf z = VF_ADD(VF_SET1(t->z0 + t->dzdy * (float)(by + y)), zx);
+        vf zb = VF_LOAD(zp);
+        cover = VF_AND(cover, cobra_depth_lanes(z, zb, t->depth_func));
+        if (!VF_MOVEMASK(cover))
+          continue;
+        if (t->depth_write)
+          VF_STORE(zp, VF_SELECT(cover, z, zb));
+      }
+
+      vi bg = VI_LOAD(p);
+      vi out = opaque ? color : blend_lanes(bg, color, inv16, mode);
+      VI_STORE(p, VI_SELECT(cover, out, bg));
+      blended += __builtin_popcount((unsigned)VF_MOVEMASK(cover));
+    }
+  }
+  return blended;
+}
+#endif
+
+TRI_INLINE void raster(cobra_surface *surf, const cobra_tri_setup *t, int x_min, int y_min, int x_max, int y_max,
+                       cobra_blend_mode mode, bool depth)
+{
+  const cobra_tri_edge *e = t->e;
+  // Variazione massima e minima di ogni edge function dentro un blocco (angoli opposti)
+  int64_t lo[3], hi[3];
+  for (int k = 0; k < 3; k++) {
+    int64_t ax = e[k].a * (TRI_BLOCK - 1), by = e[k].b * (TRI_BLOCK - 1);
+    lo[k] = (ax < 0 ? ax : 0) + (by < 0 ? by : 0);
+    hi[k] = (ax > 0 ? ax : 0) + (by > 0 ? by : 0);
+  }
+
+  int bx0 = x_min & ~(TRI_BLOCK - 1);
+  int by0 = y_min & ~(TRI_BLOCK - 1);
+  long evaluated = 0, blended = 0; // solo per le statistiche
+
+  for (int by = by0; by <= y_max; by += TRI_BLOCK) {
+    int64_t row[3];
+    for (int k = 0; k < 3; k++)
+      row[k] = e[k].a * bx0 + e[k].b * by + e[k].c;
+
+    for (int bx = bx0; bx <= x_max; bx += TRI_BLOCK) {
+      int64_t eb[3];
+      for (int k = 0; k < 3; k++)
+        eb[k] = row[k] + e[k].a * (bx - bx0);
+
+      // Trivial reject: il blocco è tutto fuori da almeno un lato
+      if (eb[0] + hi[0] < 0 || eb[1] + hi[1] < 0 || eb[2] + hi[2] < 0)
+        continue;
+
+      // Lati che attraversano il blocco: valori a 32 bit; i lati accettati valgono 0
+      int32_t e32[3] = {0, 0, 0}, ex[3] = {0, 0, 0}, ey[3] = {0, 0, 0};
+      bool full = true;
+      for (int k = 0; k < 3; k++) {
+        if (eb[k] + lo[k] >= 0)
+          continue; // trivial accept per questo lato
+        full = false;
+        e32[k] = (int32_t)eb[k];
+        ex[k] = (int32_t)e[k].a;
+        ey[k] = (int32_t)e[k].b;
+      }
+
+      int w = surf->width - bx < TRI_BLOCK ? surf->width - bx : TRI_BLOCK;
+      int h = surf->height - by < TRI_BLOCK ? surf->height - by : TRI_BLOCK;
+      evaluated += w * h;
+#ifdef COBRA_SIMD_LANES
+      if (w == TRI_BLOCK && h == TRI_BLOCK) {
+        blended += block_simd(surf, bx, by, e32, ex, ey, full, t, mode, depth);
+        continue;
+      }
+#else
+      (void)full;
+#endif
+      blended += block_scalar(surf, bx, by, w, h, e32, ex, ey, t, mode, depth);
+    }
+  }
+  COBRA_STAT_ADD(pixels_evaluated, evaluated);
+  COBRA_STAT_ADD(pixels_blended, blended);
+}
+
+// Una funzione per modalità di blending e test di profondità (risolti una volta per triangolo)
+#define TRI_KERNEL(name, mode, depth)                                                              \
+  static void name(cobra_surface *surf, const cobra_tri_setup *t, int x_min, int y_min, int x_max, \
+                   int y_max)                                                                      \
+  {                                                                                                \
+    raster(surf, t, x_min, y_min, x_max, y_max, mode, depth);                                      \
+  }
+
+TRI_KERNEL(tri_over, COBRA_BLEND_OVER, false)
+TRI_KERNEL(tri_over_depth, COBRA_BLEND_OVER, true)
+TRI_KERNEL(tri_additive, COBRA_BLEND_ADDITIVE, false)
+TRI_KERNEL(tri_additive_depth, COBRA_BLEND_ADDITIVE, true)
+TRI_KERNEL(tri_max, COBRA_BLEND_MAX, false)
+TRI_KERNEL(tri_max_depth, COBRA_BLEND_MAX, true)
+
+// [blending][depth]
+const cobra_tri_kernel ISA_FN(cobra_tri_kernels)[3][2] = {
+    {tri_over, tri_over_depth},
+    {tri_additive, tri_additive_depth},
+    {tri_max, tri_max_depth},
+};
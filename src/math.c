@@ -86,4 +86,151 @@ cobra_vec3 cobra_vec3_rotate_z(cobra_vec3 v, c_float angle) {
         v.x * sinf(angle) + v.y * cosf(angle),
         v.z
     }};
-}
\ No newline at end of file
+}
+
+cobra_mat4 cobra_mat4_identity(void) {
+    cobra_mat4 r = {{{0}}};
+    r.m[0][0] = r.m[1][1] = r.m[2][2] = r.m[3][3] = 1.0f;
+    return r;
+}
+
+cobra_mat4 cobra_mat4_mul(cobra_mat4 a, cobra_mat4 b) {
+    cobra_mat4 r;
+    for (int c = 0; c < 4; c++) {
+        for (int i = 0; i < 4; i++) {
+            r.m[c][i] = a.m[0][i] * b.m[c][0] + a.m[1][i] * b.m[c][1] +
+                        a.m[2][i] * b.m[c][2] + a.m[3][i] * b.m[c][3];
+        }
+    }
+    return r;
+}
+
+cobra_mat4 cobra_mat4_translate(cobra_vec3 t) {
+    cobra_mat4 r = cobra_mat4_identity();
+    r.m[3][0] = t.x;
+    r.m[3][1] = t.y;
+    r.m[3][2] = t.z;
+    return r;
+}
+
+cobra_mat4 cobra_mat4_scale(cobra_vec3 s) {
+    cobra_mat4 r = cobra_mat4_identity();
+    r.m[0][0] = s.x;
+    r.m[1][1] = s.y;
+    r.m[2][2] = s.z;
+    return r;
+}
+
+// Seno e coseno calcolati una volta per matrice, non per vertice
+cobra_mat4 cobra_mat4_rotate_x(c_float angle) {
+    c_float c = cosf(angle), s = sinf(angle);
+    cobra_mat4 r = cobra_mat4_identity();
+    r.m[1][1] = c;  r.m[1][2] = s;
+    r.m[2][1] = -s; r.m[2][2] = c;
+    return r;
+}
+
+cobra_mat4 cobra_mat4_rotate_y(c_float angle) {
+    c_float c = cosf(angle), s = sinf(angle);
+    cobra_mat4 r = cobra_mat4_identity();
+    r.m[0][0] = c;  r.m[0][2] = s;
+    r.m[2][0] = -s; r.m[2][2] = c;
+    return r;
+}
+
+cobra_mat4 cobra_mat4_rotate_z(c_float angle) {
+    c_float c = cosf(angle), s = sinf(angle);
+    cobra_mat4 r = cobra_mat4_identity();
+    r.m[0][0] = c;  r.m[0][1] = s;
+    r.m[1][0] = -s; r.m[1][1] = c;
+    return r;
+}
+
+cobra_mat4 cobra_mat4_from_quat(cobra_quat q) {
+    c_float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    c_float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    c_float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    cobra_mat4 r = cobra_mat4_identity();
+    r.m[0][0] = 1.0f - 2.0f * (yy + zz);
+    r.m[0][1] = 2.0f * (xy + wz);
+    r.m[0][2] = 2.0f * (xz - wy);
+    r.m[1][0] = 2.0f * (xy - wz);
+    r.m[1][1] = 1.0f - 2.0f * (xx + zz);
+    r.m[1][2] = 2.0f * (yz + wx);
+    r.m[2][0] = 2.0f * (xz + wy);
+    r.m[2][1] = 2.0f * (yz - wx);
+    r.m[2][2] = 1.0f - 2.0f * (xx + yy);
+    return r;
+}
+
+cobra_mat4 cobra_mat4_look_at(cobra_vec3 eye, cobra_vec3 target, cobra_vec3 up) {
+    // Base ortonormale della camera: forward verso il target, right e up perpendicolari
+    cobra_vec3 f = cobra_vec3_normalize(cobra_vec3_sub(target, eye));
+    cobra_vec3 r = cobra_vec3_normalize(cobra_vec3_cross(up, f));
+    cobra_vec3 u = cobra_vec3_cross(f, r);
+
+    // Le righe sono gli assi della camera, la traslazione porta 'eye' nell'origine
+    cobra_mat4 m = cobra_mat4_identity();
+    m.m[0][0] = r.x; m.m[1][0] = r.y; m.m[2][0] = r.z;
+    m.m[0][1] = u.x; m.m[1][1] = u.y; m.m[2][1] = u.z;
+    m.m[0][2] = f.x; m.m[1][2] = f.y; m.m[2][2] = f.z;
+    m.m[3][0] = -cobra_vec3_dot(r, eye);
+    m.m[3][1] = -cobra_vec3_dot(u, eye);
+    m.m[3][2] = -cobra_vec3_dot(f, eye);
+    return m;
+}
+
+cobra_mat4 cobra_mat4_perspective(c_float fov_y, c_float aspect, c_float near_plane, c_float far_plane) {
+    c_float f = 1.0f / tanf(fov_y * 0.5f);
+    c_float range = far_plane / (far_plane - near_plane);
+
+    cobra_mat4 r = {{{0}}};
+    r.m[0][0] = f / aspect;
+    r.m[1][1] = f;
+    r.m[2][2] = range;
+    r.m[2][3] = 1.0f;                // w = z di vista
+    r.m[3][2] = -near_plane * range; // z = 0 sul near plane
+    return r;
+}
+
+cobra_vec3 cobra_mat4_transform_point(cobra_mat4 m, cobra_vec3 p) {
+    return (cobra_vec3){{
+        m.m[0][0] * p.x + m.m[1][0] * p.y + m.m[2][0] * p.z + m.m[3][0],
+        m.m[0][1] * p.x + m.m[1][1] * p.y + m.m[2][1] * p.z + m.m[3][1],
+        m.m[0][2] * p.x + m.m[1][2] * p.y + m.m[2][2] * p.z + m.m[3][2]
+    }};
+}
+
+cobra_quat cobra_quat_identity(void) {
+    return (cobra_quat){{0.0f, 0.0f, 0.0f, 1.0f}};
+}
+
+cobra_quat cobra_quat_from_axis_angle(cobra_vec3 axis, c_float angle) {
+    cobra_vec3 n = cobra_vec3_normalize(axis);
+    c_float s = sinf(angle * 0.5f);
+    return (cobra_quat){{n.x * s, n.y * s, n.z * s, cosf(angle * 0.5f)}};
+}
+
+cobra_quat cobra_quat_mul(cobra_quat a, cobra_quat b) {
+    return (cobra_quat){{
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+    }};
+}
+
+cobra_quat cobra_quat_normalize(cobra_quat q) {
+    c_float len = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    if (len == 0.0f) return cobra_quat_identity();
+    c_float inv = 1.0f / len;
+    return (cobra_quat){{q.x * inv, q.y * inv, q.z * inv, q.w * inv}};
+}
+
+cobra_vec3 cobra_quat_rotate(cobra_quat q, cobra_vec3 v) {
+    // v' = v + 2w (q x v) + 2 q x (q x v), senza costruire la matrice
+    cobra_vec3 qv = {{q.x, q.y, q.z}};
+    cobra_vec3 t = cobra_vec3_scale(cobra_vec3_cross(qv, v), 2.0f);
+    return cobra_vec3_add(cobra_vec3_add(v, cobra_vec3_scale(t, q.w)), cobra_vec3_cross(qv, t));
+}
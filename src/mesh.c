@@ -0,0 +1,428 @@
+// Mesh indicizzata: trasformazione e proiezione una volta per vertice.
+//
+// Nel disegno con cobra_window_draw_line_3d ogni spigolo proietta i propri estremi,
+// quindi un vertice condiviso da k spigoli viene trasformato e proiettato k volte.
+// Qui invece:
+//   0. l'AABB della mesh viene confrontato con il frustum: se è fuori non si fa altro lavoro
+//   1. cobra_transform_points porta tutti i vertici nello spazio camera (SIMD, una matrice)
+//   2. una passata calcola l'outcode dei piani del frustum e proietta ogni vertice una volta
+//   3. gli spigoli leggono le posizioni a schermo già calcolate e vengono inviati a blocchi
+//      all'API batch; solo gli spigoli a cavallo di un piano vengono tagliati a parte.
+//      Allo stesso modo i triangoli pieni vanno direttamente al rasterizzatore, e solo quelli
+//      a cavallo di un piano passano dal clipping del poligono in spazio camera.
+
+#include "cobragl/mesh.h"
+#include "internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MESH_EDGE_CHUNK 256
+
+void cobra_mesh_init(cobra_mesh *mesh)
+{
+  if (mesh)
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+void cobra_mesh_destroy(cobra_mesh *mesh)
+{
+  if (!mesh)
+    return;
+  free(mesh->x);
+  free(mesh->y);
+  free(mesh->z);
+  free(mesh->edges);
+  free(mesh->edge_hash);
+  free(mesh->triangles);
+  memset(mesh, 0, sizeof(*mesh));
+}
+
+// Rialloca un array di float mantenendo il contenuto; false se la memoria è esaurita
+static bool grow_floats(float **p, int capacity)
+{
+  float *q = (float *)realloc(*p, sizeof(float) * capacity);
+  if (!q)
+    return false;
+  *p = q;
+  return true;
+}
+
+int cobra_mesh_add_vertex(cobra_mesh *mesh, cobra_vec3 v)
+{
+  if (!mesh)
+    return -1;
+
+  if (mesh->vertex_count == mesh->vertex_capacity) {
+    int capacity = mesh->vertex_capacity ? mesh->vertex_capacity * 2 : 64;
+    if (!grow_floats(&mesh->x, capacity) || !grow_floats(&mesh->y, capacity) || !grow_floats(&mesh->z, capacity))
+      return -1;
+    mesh->vertex_capacity = capacity;
+  }
+
+  if (mesh->vertex_count == 0) {
+    mesh->bounds_min = v;
+    mesh->bounds_max = v;
+  } else {
+    for (int c = 0; c < 3; c++) {
+      if (v.comp[c] < mesh->bounds_min.comp[c]) mesh->bounds_min.comp[c] = v.comp[c];
+      if (v.comp[c] > mesh->bounds_max.comp[c]) mesh->bounds_max.comp[c] = v.comp[c];
+    }
+  }
+
+  int i = mesh->vertex_count++;
+  mesh->x[i] = v.x;
+  mesh->y[i] = v.y;
+  mesh->z[i] = v.z;
+  return i;
+}
+
+static inline unsigned edge_hash(int a, int b)
+{
+  return ((unsigned)a * 0x9E3779B1u) ^ ((unsigned)b * 0x85EBCA77u);
+}
+
+// Inserisce l'indice dello spigolo e nella tabella (che deve avere almeno uno slot libero)
+static void hash_insert(int *table, int capacity, const int *edges, int e)
+{
+  unsigned mask = (unsigned)capacity - 1;
+  unsigned h = edge_hash(edges[2 * e], edges[2 * e + 1]) & mask;
+  while (table[h] >= 0)
+    h = (h + 1) & mask;
+  table[h] = e;
+}
+
+// Raddoppia la tabella hash quando supera il 50% di riempimento
+static bool grow_edge_hash(cobra_mesh *mesh)
+{
+  int capacity = mesh->edge_hash_capacity ? mesh->edge_hash_capacity * 2 : 256;
+  int *table = (int *)malloc(sizeof(int) * capacity);
+  if (!table)
+    return false;
+  for (int i = 0; i < capacity; i++)
+    table[i] = -1;
+  for (int e = 0; e < mesh->edge_count; e++)
+    hash_insert(table, capacity, mesh->edges, e);
+
+  free(mesh->edge_hash);
+  mesh->edge_hash = table;
+  mesh->edge_hash_capacity = capacity;
+  return true;
+}
+
+bool cobra_mesh_add_edge(cobra_mesh *mesh, int a, int b)
+{
+  if (!mesh || a < 0 || b < 0 || a >= mesh->vertex_count || b >= mesh->vertex_count || a == b)
+    return false;
+
+  // Forma canonica: lo spigolo b-a coincide con a-b
+  if (a > b) {
+    int t = a; a = b; b = t;
+  }
+
+  if ((mesh->edge_count + 1) * 2 > mesh->edge_hash_capacity && !grow_edge_hash(mesh))
+    return false;
+
+  unsigned mask = (unsigned)mesh->edge_hash_capacity - 1;
+  unsigned h = edge_hash(a, b) & mask;
+  while (mesh->edge_hash[h] >= 0) {
+    int e = mesh->edge_hash[h];
+    if (mesh->edges[2 * e] == a && mesh->edges[2 * e + 1] == b)
+      return true; // già presente
+    h = (h + 1) & mask;
+  }
+
+  if (mesh->edge_count == mesh->edge_capacity) {
+    int capacity = mesh->edge_capacity ? mesh->edge_capacity * 2 : 64;
+    int *edges = (int *)realloc(mesh->edges, sizeof(int) * 2 * capacity);
+    if (!edges)
+      return false;
+    mesh->edges = edges;
+    mesh->edge_capacity = capacity;
+  }
+
+  int e = mesh->edge_count++;
+  mesh->edges[2 * e] = a;
+  mesh->edges[2 * e + 1] = b;
+  mesh->edge_hash[h] = e;
+  return true;
+}
+
+bool cobra_mesh_add_triangle(cobra_mesh *mesh, int a, int b, int c)
+{
+  if (!mesh || a < 0 || b < 0 || c < 0 ||
+      a >= mesh->vertex_count || b >= mesh->vertex_count || c >= mesh->vertex_count)
+    return false;
+
+  if (mesh->triangle_count == mesh->triangle_capacity) {
+    int capacity = mesh->triangle_capacity ? mesh->triangle_capacity * 2 : 64;
+    int *triangles = (int *)realloc(mesh->triangles, sizeof(int) * 3 * capacity);
+    if (!triangles)
+      return false;
+    mesh->triangles = triangles;
+    mesh->triangle_capacity = capacity;
+  }
+
+  int t = mesh->triangle_count++;
+  mesh->triangles[3 * t] = a;
+  mesh->triangles[3 * t + 1] = b;
+  mesh->triangles[3 * t + 2] = c;
+  return true;
+}
+
+bool cobra_mesh_add_polygon(cobra_mesh *mesh, const int *indices, int count)
+{
+  if (!mesh || !indices || count < 2)
+    return false;
+
+  bool ok = true;
+  for (int i = 0; i < count; i++)
+    ok &= cobra_mesh_add_edge(mesh, indices[i], indices[(i + 1) % count]);
+  for (int i = 1; i + 1 < count; i++)
+    ok &= cobra_mesh_add_triangle(mesh, indices[0], indices[i], indices[i + 1]);
+  return ok;
+}
+
+// Buffer di appoggio del disegno: posizioni in spazio camera e a schermo, outcode del frustum.
+// Stanno nell'arena della superficie e vengono riusati da tutte le mesh disegnate nel frame.
+typedef struct {
+  float *view_x, *view_y, *view_z;
+  float *screen_x, *screen_y;
+  float *screen_depth; // profondità 0..1 (solo con il test di profondità attivo)
+  unsigned char *clip_codes;
+} mesh_scratch;
+
+static bool get_scratch(cobra_surface *surf, int n, mesh_scratch *s)
+{
+  // Sette array consecutivi, ognuno allineato come l'arena
+  size_t stride = ((size_t)n * sizeof(float) + COBRA_ARENA_ALIGN - 1) & ~(size_t)(COBRA_ARENA_ALIGN - 1);
+  unsigned char *p = (unsigned char *)cobra_arena_reserve(&surf->arena, &surf->mesh_scratch,
+                                                          stride * 6 + (size_t)n, false);
+  if (!p)
+    return false;
+  s->view_x = (float *)(p + 0 * stride);
+  s->view_y = (float *)(p + 1 * stride);
+  s->view_z = (float *)(p + 2 * stride);
+  s->screen_x = (float *)(p + 3 * stride);
+  s->screen_y = (float *)(p + 4 * stride);
+  s->screen_depth = (float *)(p + 5 * stride);
+  s->clip_codes = p + 6 * stride;
+  return true;
+}
+
+// Blocco di spigoli pronti per l'API batch
+typedef struct {
+  float x0[MESH_EDGE_CHUNK], y0[MESH_EDGE_CHUNK];
+  float x1[MESH_EDGE_CHUNK], y1[MESH_EDGE_CHUNK];
+  float width[MESH_EDGE_CHUNK];
+  uint32_t color[MESH_EDGE_CHUNK];
+  float z0[MESH_EDGE_CHUNK], z1[MESH_EDGE_CHUNK]; // z in spazio camera degli estremi
+  int count;
+} edge_chunk;
+
+static void flush_edges(cobra_surface *surf, edge_chunk *c, bool aa, bool depth, cobra_aa_mode aa_mode)
+{
+  if (aa) {
+    cobra_submit_lines_aa(surf, c->x0, c->y0, c->x1, c->y1, c->width, c->color,
+                          depth ? c->z0 : NULL, depth ? c->z1 : NULL, c->count, aa_mode);
+  } else {
+    cobra_line_depth d;
+    for (int i = 0; i < c->count; i++) {
+      if (depth)
+        cobra_line_depth_init(&d, surf, c->z0[i], c->z1[i]);
+      cobra_submit_line(surf, (int)c->x0[i], (int)c->y0[i], (int)c->x1[i], (int)c->y1[i], c->color[i],
+                        depth ? &d : NULL);
+    }
+  }
+  c->count = 0;
+}
+
+// Passi 0-2 comuni a wireframe e facce piene. Restituisce false se la mesh è fuori dal frustum
+// o nascosta dalla profondità già scritta. 'margin': pixel coperti oltre la proiezione dei vertici.
+static bool prepare_vertices(cobra_surface *surf, cobra_mesh *mesh, const mesh_scratch *scratch,
+                             const cobra_mat4 *model_view, const cobra_frustum *frustum, float margin, bool depth)
+{
+  const int n = mesh->vertex_count;
+  float *vx = scratch->view_x, *vy = scratch->view_y, *vz = scratch->view_z;
+  float *sx = scratch->screen_x, *sy = scratch->screen_y, *sz = scratch->screen_depth;
+  unsigned char *codes = scratch->clip_codes;
+  const float fov = frustum->fov;
+  const float half_w = (float)surf->width * 0.5f;
+  const float half_h = (float)surf->height * 0.5f;
+
+  // 0. Culling dell'intera mesh (guard band compresa)
+  cobra_cull_result cull = cobra_frustum_cull_aabb(frustum, model_view, mesh->bounds_min, mesh->bounds_max);
+  if (cull == COBRA_CULL_OUTSIDE) {
+    COBRA_STAT_ADD(meshes_culled, 1);
+    return false;
+  }
+  if (surf->hiz && cobra_hiz_occluded(surf, model_view, fov, mesh->bounds_min, mesh->bounds_max, margin)) {
+    COBRA_STAT_ADD(meshes_occluded, 1);
+    return false;
+  }
+
+  // 1. Trasformazione nello spazio camera (una volta per vertice)
+  cobra_transform_points(model_view, mesh->x, mesh->y, mesh->z, vx, vy, vz, NULL, n);
+
+  // 2. Outcode e proiezione (stessa formula di cobra_vec3_project). Se la mesh è tutta dentro
+  //    gli outcode sono nulli; i vertici fuori dal near plane ricevono una proiezione qualsiasi,
+  //    tanto le primitive che li usano vengono tagliate al passo 3.
+  const float near_plane = frustum->near_plane;
+  for (int i = 0; i < n; i++) {
+    codes[i] = (cull == COBRA_CULL_INSIDE) ? 0 : (unsigned char)cobra_frustum_outcode(frustum, vx[i], vy[i], vz[i]);
+    float inv_z = 1.0f / (vz[i] >= near_plane ? vz[i] : near_plane);
+    sx[i] = vx[i] * fov * inv_z + half_w;
+    sy[i] = -vy[i] * fov * inv_z + half_h;
+  }
+  if (depth) {
+    for (int i = 0; i < n; i++)
+      sz[i] = cobra_depth_from_z(surf, vz[i] >= near_plane ? vz[i] : near_plane);
+  }
+  return true;
+}
+
+static void draw_mesh(cobra_surface *surf, cobra_mesh *mesh, const cobra_mat4 *model_view,
+                      float fov, float thickness, uint32_t color, bool aa, cobra_aa_mode aa_mode)
+{
+  mesh_scratch scratch;
+  if (!get_scratch(surf, mesh->vertex_count, &scratch))
+    return;
+
+  float *vx = scratch.view_x, *vy = scratch.view_y, *vz = scratch.view_z;
+  float *sx = scratch.screen_x, *sy = scratch.screen_y;
+  unsigned char *codes = scratch.clip_codes;
+  const float half_w = (float)surf->width * 0.5f;
+  const float half_h = (float)surf->height * 0.5f;
+
+  // Guard band dello spessore della linea
+  const float guard = (aa ? thickness : 1.0f) * 0.5f + 2.0f;
+  cobra_frustum frustum;
+  cobra_frustum_init(&frustum, surf, fov, guard);
+  if (!prepare_vertices(surf, mesh, &scratch, model_view, &frustum, guard, false))
+    return;
+
+  // 3. Spigoli: posizioni a schermo dalla cache, clipping solo per chi attraversa un piano
+  const bool depth = cobra_depth_enabled(surf);
+  edge_chunk chunk;
+  chunk.count = 0;
+  int culled = 0; // solo per le statistiche
+  for (int e = 0; e < mesh->edge_count; e++) {
+    int a = mesh->edges[2 * e];
+    int b = mesh->edges[2 * e + 1];
+    if (codes[a] & codes[b]) {
+      culled++;
+      continue;
+    }
+
+    float x0 = sx[a], y0 = sy[a], x1 = sx[b], y1 = sy[b];
+    float z0 = vz[a], z1 = vz[b];
+    if (codes[a] | codes[b]) {
+      cobra_vec3 pa = {{vx[a], vy[a], vz[a]}};
+      cobra_vec3 pb = {{vx[b], vy[b], vz[b]}};
+      if (!cobra_frustum_clip_line(&frustum, &pa, &pb)) {
+        culled++;
+        continue;
+      }
+      x0 = pa.x * fov / pa.z + half_w;
+      y0 = -pa.y * fov / pa.z + half_h;
+      x1 = pb.x * fov / pb.z + half_w;
+      y1 = -pb.y * fov / pb.z + half_h;
+      z0 = pa.z;
+      z1 = pb.z;
+    }
+
+    int k = chunk.count++;
+    chunk.x0[k] = x0; chunk.y0[k] = y0;
+    chunk.x1[k] = x1; chunk.y1[k] = y1;
+    chunk.width[k] = thickness;
+    chunk.color[k] = color;
+    chunk.z0[k] = z0;
+    chunk.z1[k] = z1;
+    if (chunk.count == MESH_EDGE_CHUNK)
+      flush_edges(surf, &chunk, aa, depth, aa_mode);
+  }
+  if (chunk.count > 0)
+    flush_edges(surf, &chunk, aa, depth, aa_mode);
+  COBRA_STAT_ADD(lines_culled, culled);
+}
+
+static void draw_mesh_filled(cobra_surface *surf, cobra_mesh *mesh, const cobra_mat4 *model_view,
+                             float fov, const uint32_t *colors, uint32_t color)
+{
+  mesh_scratch scratch;
+  if (!get_scratch(surf, mesh->vertex_count, &scratch))
+    return;
+
+  if (surf->deferred)
+    cobra_surface_flush(surf);
+
+  const bool depth = cobra_depth_enabled(surf);
+  cobra_frustum frustum;
+  cobra_frustum_init(&frustum, surf, fov, cobra_triangle_guard(surf));
+  if (!prepare_vertices(surf, mesh, &scratch, model_view, &frustum, 1.0f, depth))
+    return;
+
+  const float *vx = scratch.view_x, *vy = scratch.view_y, *vz = scratch.view_z;
+  const float *sx = scratch.screen_x, *sy = scratch.screen_y, *sz = scratch.screen_depth;
+  const unsigned char *codes = scratch.clip_codes;
+
+  // Il colore premoltiplicato si prepara una volta se è uguale per tutti i triangoli
+  cobra_blend blend;
+  cobra_blend_init(&blend, surf, color);
+
+  // 3. Triangoli: posizioni a schermo dalla cache, clipping solo per chi attraversa un piano
+  int culled = 0; // solo per le statistiche
+  for (int t = 0; t < mesh->triangle_count; t++) {
+    const int *idx = &mesh->triangles[3 * t];
+    int a = idx[0], b = idx[1], c = idx[2];
+    if (codes[a] & codes[b] & codes[c]) {
+      culled++;
+      continue;
+    }
+
+    if (colors)
+      cobra_blend_init(&blend, surf, colors[t]);
+
+    if (codes[a] | codes[b] | codes[c]) {
+      cobra_vec3 v[3] = {
+        {{vx[a], vy[a], vz[a]}},
+        {{vx[b], vy[b], vz[b]}},
+        {{vx[c], vy[c], vz[c]}},
+      };
+      cobra_raster_triangle_3d(surf, &frustum, v, &blend, depth);
+      continue;
+    }
+
+    float x[3] = {sx[a], sx[b], sx[c]};
+    float y[3] = {sy[a], sy[b], sy[c]};
+    float z[3] = {0.0f, 0.0f, 0.0f};
+    if (depth) {
+      z[0] = sz[a];
+      z[1] = sz[b];
+      z[2] = sz[c];
+    }
+    cobra_raster_triangle(surf, x, y, depth ? z : NULL, &blend);
+  }
+  COBRA_STAT_ADD(triangles_culled, culled);
+}
+
+void cobra_window_draw_mesh(cobra_surface *surf, cobra_mesh *mesh, const cobra_mat4 *model_view,
+                            float fov, float thickness, uint32_t color, bool aa, cobra_aa_mode aa_mode)
+{
+  if (!surf || !mesh || !model_view || mesh->edge_count == 0)
+    return;
+
+  COBRA_SCOPE_BEGIN(scope, "mesh", COBRA_TIMER_RASTER);
+  draw_mesh(surf, mesh, model_view, fov, thickness, color, aa, aa_mode);
+  COBRA_SCOPE_END(scope);
+}
+
+void cobra_window_draw_mesh_filled(cobra_surface *surf, cobra_mesh *mesh, const cobra_mat4 *model_view,
+                                   float fov, const uint32_t *colors, uint32_t color)
+{
+  if (!surf || !mesh || !model_view || mesh->triangle_count == 0)
+    return;
+
+  COBRA_SCOPE_BEGIN(scope, "mesh_filled", COBRA_TIMER_RASTER);
+  draw_mesh_filled(surf, mesh, model_view, fov, colors, color);
+  COBRA_SCOPE_END(scope);
+}
@@ -0,0 +1,227 @@
+// Nuvole di punti 3D (structure-of-arrays).
+//
+// Una sola draw call per tutta la nuvola invece di una proiezione e una draw_point per punto.
+// I punti vengono elaborati a blocchi di COBRA_POINT_CHUNK elementi, in passate senza dipendenze
+// tra elementi:
+//   1. cobra_transform_points porta il blocco nello spazio camera (SIMD, una matrice)
+//   2. proiezione e culling (isa/points.c) a COBRA_SIMD_LANES punti per iterazione: un
+//      reciproco per punto, maschera dai piani near/far e dallo schermo allargato del raggio,
+//      profondità 0..1;
+//      i bit della maschera diventano direttamente la lista compatta dei punti visibili
+//   3. splat dei punti visibili: quadrato pieno o disco AA
+// La coda di ogni blocco usa la versione scalare con le stesse operazioni nello stesso ordine.
+// I blocchi stanno sullo stack: nessuna allocazione per chiamata.
+
+#include "cobragl/surface.h"
+#include "internal.h"
+#include <math.h>
+#include <string.h>
+
+static inline int point_floor(float v)
+{
+  int k = (int)v;
+  if ((float)k > v) k--; // v può essere negativo nel margine
+  return k;
+}
+
+// Quadrati pieni: il colore viene scritto così com'è (come cobra_window_draw_point).
+// 'extent' è la distanza dal centro dei pixel estremi, 0 = un solo pixel.
+static void splat_squares(cobra_surface *surf, const cobra_point_chunk *c, int m, const uint32_t *colors,
+                          uint32_t color, float extent, bool has_depth)
+{
+  const int w = surf->width, h = surf->height;
+  uint32_t *color_buffer = surf->color_buffer;
+  float *z_buffer = surf->z_buffer;
+  const cobra_depth_func func = surf->depth_func;
+  const bool write = surf->depth_write;
+  int blended = 0;
+
+  for (int k = 0; k < m; k++) {
+    int i = c->visible[k];
+    int x0 = point_floor(c->sx[i] - extent), x1 = point_floor(c->sx[i] + extent);
+    int y0 = point_floor(c->sy[i] - extent), y1 = point_floor(c->sy[i] + extent);
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > w - 1) x1 = w - 1;
+    if (y1 > h - 1) y1 = h - 1;
+    uint32_t col = colors ? colors[i] : color;
+    float z = c->depth[i];
+
+    for (int y = y0; y <= y1; y++) {
+      for (int x = x0; x <= x1; x++) {
+        long idx = cobra_pixel_index(surf, x, y);
+        if (has_depth) {
+          if (!cobra_depth_test(func, z, z_buffer[idx]))
+            continue;
+          if (write)
+            z_buffer[idx] = z;
+        }
+        color_buffer[idx] = col;
+        blended++;
+      }
+    }
+  }
+  COBRA_STAT_ADD(pixels_blended, blended);
+}
+
+// Dischi AA di raggio 'radius' con il blending della superficie (come cobra_window_draw_point_aa).
+// Copertura = radius + 0.5 - distanza del centro del pixel, limitata a [0, 1]; sotto il mezzo
+// pixel il disco resta di raggio 0.5 e l'intensità scala con l'area, così i punti piccoli
+// si attenuano invece di sparire tra un pixel e l'altro.
+// Il corpo viene espanso per ogni modalità di blending: niente chiamata indiretta per pixel.
+static inline __attribute__((always_inline)) void
+splat_discs(cobra_surface *surf, const cobra_point_chunk *c, int m, const uint32_t *colors, uint32_t color,
+            float radius, bool has_depth, cobra_blend_mode mode)
+{
+  const int w = surf->width, h = surf->height;
+  uint32_t *color_buffer = surf->color_buffer;
+  float *z_buffer = surf->z_buffer;
+  const cobra_depth_func func = surf->depth_func;
+  const bool write = surf->depth_write;
+
+  float r = radius > 0.5f ? radius : 0.5f;
+  float intensity = radius > 0.5f ? 1.0f : 4.0f * radius * radius;
+  float outer = r + 0.5f, outer_sq = outer * outer;
+  float inner = r - 0.5f, inner_sq = inner > 0.0f ? inner * inner : -1.0f; // copertura piena
+  uint32_t full = cobra_coverage(intensity);
+
+  cobra_blend blend;
+  cobra_blend_init(&blend, surf, color);
+  int evaluated = 0, blended = 0;
+
+  for (int k = 0; k < m; k++) {
+    int i = c->visible[k];
+    if (colors)
+      cobra_blend_init(&blend, surf, colors[i]);
+    float cx = c->sx[i], cy = c->sy[i];
+    int x0 = point_floor(cx - outer), x1 = point_floor(cx + outer);
+    int y0 = point_floor(cy - outer), y1 = point_floor(cy + outer);
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > w - 1) x1 = w - 1;
+    if (y1 > h - 1) y1 = h - 1;
+    float z = c->depth[i];
+
+    for (int y = y0; y <= y1; y++) {
+      float dy = (float)y + 0.5f - cy;
+      for (int x = x0; x <= x1; x++) {
+        float dx = (float)x + 0.5f - cx;
+        float d_sq = dx * dx + dy * dy;
+        if (d_sq >= outer_sq)
+          continue;
+        evaluated++;
+        uint32_t cov = full;
+        if (d_sq > inner_sq) {
+          float alpha = (outer - sqrtf(d_sq)) * intensity;
+          cov = cobra_coverage(alpha > intensity ? intensity : alpha);
+          if (!cov)
+            continue;
+        }
+
+        long idx = cobra_pixel_index(surf, x, y);
+        if (has_depth) {
+          if (!cobra_depth_test(func, z, z_buffer[idx]))
+            continue;
+          if (write && cov >= 128)
+            z_buffer[idx] = z;
+        }
+        switch (mode) {
+        case COBRA_BLEND_ADDITIVE: cobra_blend_additive(&color_buffer[idx], &blend, cov); break;
+        case COBRA_BLEND_MAX:      cobra_blend_max(&color_buffer[idx], &blend, cov); break;
+        default:                   cobra_blend_over(&color_buffer[idx], &blend, cov); break;
+        }
+        blended++;
+      }
+    }
+  }
+  COBRA_STAT_ADD(pixels_evaluated, evaluated);
+  COBRA_STAT_ADD(pixels_blended, blended);
+}
+
+static void splat_chunk(cobra_surface *surf, const cobra_point_chunk *c, int m, const uint32_t *colors, uint32_t color,
+                        float radius, cobra_point_mode mode, bool has_depth)
+{
+  if (mode != COBRA_POINT_DISC) {
+    splat_squares(surf, c, m, colors, color, radius > 0.5f ? radius - 0.5f : 0.0f, has_depth);
+    return;
+  }
+  switch (surf->blend_mode) {
+  case COBRA_BLEND_ADDITIVE:
+    splat_discs(surf, c, m, colors, color, radius, has_depth, COBRA_BLEND_ADDITIVE);
+    break;
+  case COBRA_BLEND_MAX:
+    splat_discs(surf, c, m, colors, color, radius, has_depth, COBRA_BLEND_MAX);
+    break;
+  default:
+    splat_discs(surf, c, m, colors, color, radius, has_depth, COBRA_BLEND_OVER);
+    break;
+  }
+}
+
+void cobra_window_draw_points_3d(cobra_surface *surf, const float *x, const float *y, const float *z, int count,
+                                 const cobra_mat4 *model_view, float fov, const uint32_t *colors, uint32_t color,
+                                 float radius, cobra_point_mode mode)
+{
+  if (!surf || !x || !y || !z || count <= 0)
+    return;
+
+  // Le primitive immediate devono comparire sopra le linee differite già registrate
+  if (surf->deferred)
+    cobra_surface_flush(surf);
+
+  // Distanza massima dal centro di un pixel toccato (il disco AA sfuma per mezzo pixel in più)
+  float reach = (radius > 0.5f ? radius : 0.5f) + (mode == COBRA_POINT_DISC ? 0.5f : 0.0f);
+  cobra_point_view v;
+  v.fov = fov;
+  v.half_w = (float)surf->width * 0.5f;
+  v.half_h = (float)surf->height * 0.5f;
+  v.near_plane = surf->near_plane;
+  v.far_plane = surf->far_plane;
+  v.depth_range = isinf(surf->far_plane) ? 1.0f : surf->far_plane / (surf->far_plane - surf->near_plane);
+  v.min_x = -reach;
+  v.min_y = -reach;
+  v.max_x = (float)surf->width + reach;
+  v.max_y = (float)surf->height + reach;
+  const bool has_depth = cobra_depth_enabled(surf);
+
+  cobra_point_chunk c;
+  int culled = 0; // solo per le statistiche
+
+  COBRA_SCOPE_BEGIN(scope, "points_3d", COBRA_TIMER_RASTER);
+  for (int base = 0; base < count; base += COBRA_POINT_CHUNK) {
+    int n = count - base;
+    if (n > COBRA_POINT_CHUNK) n = COBRA_POINT_CHUNK;
+
+    // Passata 1: spazio camera (senza matrice i punti lo sono già)
+    if (model_view) {
+      cobra_transform_points(model_view, x + base, y + base, z + base, c.x, c.y, c.z, NULL, n);
+    } else {
+      memcpy(c.x, x + base, (size_t)n * sizeof(float));
+      memcpy(c.y, y + base, (size_t)n * sizeof(float));
+      memcpy(c.z, z + base, (size_t)n * sizeof(float));
+    }
+
+    // Passata 2: proiezione, culling e compattazione
+    int m = COBRA_KERNEL(project_points)(&v, &c, n);
+    culled += n - m;
+    if (m == 0)
+      continue;
+
+    // Area toccata: box dei centri visibili allargato del raggio
+    float lo_x = c.sx[c.visible[0]], hi_x = lo_x, lo_y = c.sy[c.visible[0]], hi_y = lo_y;
+    for (int k = 1; k < m; k++) {
+      int i = c.visible[k];
+      lo_x = c.sx[i] < lo_x ? c.sx[i] : lo_x;
+      hi_x = c.sx[i] > hi_x ? c.sx[i] : hi_x;
+      lo_y = c.sy[i] < lo_y ? c.sy[i] : lo_y;
+      hi_y = c.sy[i] > hi_y ? c.sy[i] : hi_y;
+    }
+    cobra_mark_dirty(surf, lo_x - reach, lo_y - reach, hi_x + reach, hi_y + reach);
+
+    // Passata 3: splat
+    splat_chunk(surf, &c, m, colors ? colors + base : NULL, color, radius, mode, has_depth);
+  }
+  COBRA_STAT_ADD(points_submitted, count);
+  COBRA_STAT_ADD(points_culled, culled);
+  COBRA_SCOPE_END(scope);
+}
@@ -0,0 +1,430 @@
+// Polilinee AA: un percorso di punti tracciato come un'unica linea.
+//
+// Ogni segmento viene rasterizzato con le righe della sua capsula (capsule.c), ma vicino a un
+// vertice condiviso le capsule dei due segmenti si sovrappongono: disegnandole entrambe il
+// raccordo verrebbe sfumato due volte (più scuro con alpha < 1, saturo in additivo).
+// Dividiamo quindi il piano lungo la bisettrice del vertice, di normale b = u_in + u_out:
+// il segmento entrante tiene i pixel con (P - V)·b < 0, l'uscente quelli con >= 0. Il confine
+// è calcolato da entrambi con gli stessi float, quindi ogni pixel finisce in uno solo.
+// Sul proprio lato ogni segmento aggiunge la sua metà del raccordo:
+//   - ROUND: la punta tonda della capsula, così com'è;
+//   - MITER: il segmento si allunga oltre il vertice fin dove il bordo esterno incontra la
+//     bisettrice (oltre COBRA_MITER_LIMIT si ripiega su BEVEL);
+//   - BEVEL: oltre il vertice (t > 1 o t < 0) la copertura viene da una seconda capsula,
+//     larga e con il bordo sulla corda tra gli spigoli esterni dei due segmenti.
+// Restano sfumati due volte solo gli incroci tra segmenti non consecutivi.
+
+#include "internal.h"
+#include <math.h>
+#include <string.h>
+
+// Sotto questa distanza al quadrato (pixel^2) due punti consecutivi sono lo stesso punto
+#define STROKE_MIN_LEN_SQ 1e-6f
+// Sotto questo |u_in + u_out|^2 il percorso torna indietro su se stesso: nessun confine
+#define STROKE_REVERSE_EPS 1e-6f
+// Sotto questo |sin| i segmenti sono allineati: nessuno spigolo da raccordare
+#define STROKE_STRAIGHT_EPS 1e-4f
+// Oltre il raggio, distanza massima a cui i kernel di copertura danno ancora contributo
+// (0.5 per SDF, 0.71 per BOX): il prolungamento MITER deve coprirla
+#define STROKE_AA_REACH 1.0f
+// Margine della capsula dello smusso: il suo bordo interno e le sue punte restano lontani
+// dalla zona del raccordo, che riceve solo la rampa lungo la corda
+#define STROKE_BEVEL_PAD 2.0f
+// Limite delle ascisse dei confini quasi orizzontali (nx -> 0), ben fuori da ogni clip
+#define STROKE_FAR 1e7f
+
+// Direzione unitaria di a -> b (false se i punti coincidono)
+static bool stroke_dir(float ax, float ay, float bx, float by, float *ux, float *uy)
+{
+  float dx = bx - ax, dy = by - ay;
+  float len_sq = dx * dx + dy * dy;
+  if (len_sq <= 0.0f)
+    return false;
+  float inv_len = 1.0f / sqrtf(len_sq);
+  *ux = dx * inv_len;
+  *uy = dy * inv_len;
+  return true;
+}
+
+// Pendenza -ny / nx di un confine di normale n, limitata per i confini quasi orizzontali
+static float stroke_slope(float nx, float ny)
+{
+  if (nx == 0.0f)
+    return 0.0f;
+  float k = -ny / nx;
+  return fminf(fmaxf(k, -STROKE_FAR), STROKE_FAR);
+}
+
+void cobra_stroke_joint_init(cobra_stroke_joint *j, float ax, float ay, float vx, float vy,
+                             float bx, float by, float width, cobra_line_join join)
+{
+  memset(j, 0, sizeof(*j));
+  j->vx = vx;
+  j->vy = vy;
+  float ix, iy, ox, oy;
+  if (!stroke_dir(ax, ay, vx, vy, &ix, &iy) || !stroke_dir(vx, vy, bx, by, &ox, &oy))
+    return;
+
+  float nx = ix + ox, ny = iy + oy;
+  float n_sq = nx * nx + ny * ny;
+  if (n_sq < STROKE_REVERSE_EPS)
+    return;
+  float inv_n = 1.0f / sqrtf(n_sq);
+  j->cut = true;
+  j->nx = nx * inv_n;
+  j->ny = ny * inv_n;
+  j->slope = stroke_slope(j->nx, j->ny);
+
+  float cos_t = ix * ox + iy * oy; // angolo di svolta
+  float sin_t = ix * oy - iy * ox;
+  if (join == COBRA_JOIN_ROUND || fabsf(sin_t) < STROKE_STRAIGHT_EPS)
+    return;
+
+  // Lunghezza dello spigolo / spessore = 1 / cos(svolta / 2) = sqrt(2 / (1 + cos))
+  float radius = width * 0.5f;
+  if (join == COBRA_JOIN_MITER && 2.0f <= COBRA_MITER_LIMIT * COBRA_MITER_LIMIT * (1.0f + cos_t)) {
+    // Il bordo esterno (a distanza raggio + rampa AA) incontra la bisettrice a tan(svolta / 2)
+    j->ext = (radius + STROKE_AA_REACH) * fabsf(sin_t) / (1.0f + cos_t);
+    return;
+  }
+
+  // Smusso. Lato esterno: opposto alla svolta, o = -sign(sin) * (-uy, ux) per ogni segmento
+  float side = sin_t > 0.0f ? 1.0f : -1.0f;
+  float oix = side * iy, oiy = -side * ix;
+  float oox = side * oy, ooy = -side * ox;
+  float wx = oix + oox, wy = oiy + ooy;
+  float inv_w = 1.0f / sqrtf(wx * wx + wy * wy); // |w| = 2 cos(svolta / 2) > 0
+  wx *= inv_w;
+  wy *= inv_w;
+  // La corda tra gli spigoli V + o * raggio dista h dal vertice lungo w: la capsula ha il
+  // bordo sulla corda e si estende verso l'interno
+  float h = radius * (oix * wx + oiy * wy);
+  float rc = radius + STROKE_BEVEL_PAD;
+  float half = radius + 2.0f * STROKE_BEVEL_PAD;
+  float mx = vx + wx * (h - rc), my = vy + wy * (h - rc);
+  j->bevel = true;
+  j->cx0 = mx + wy * half; j->cy0 = my - wx * half;
+  j->cx1 = mx - wy * half; j->cy1 = my + wx * half;
+  j->chord_width = 2.0f * rc;
+}
+
+// Restringe le colonne [*xa, *xb] della riga con centro yc al semipiano (P - V)·n >= 0 (ge)
+// o < 0, con slope = stroke_slope(nx, ny)
+static inline void stroke_halfplane(float vx, float vy, float nx, float ny, float slope, float yc,
+                                    bool ge, int *xa, int *xb)
+{
+  if (nx == 0.0f) {
+    // Confine orizzontale: la riga sta tutta da una parte
+    if (((yc - vy) * ny >= 0.0f) != ge)
+      *xb = *xa - 1;
+    return;
+  }
+  // Pixel px: px + 0.5 dalla parte di n rispetto all'ascissa del confine
+  float xs = vx + (yc - vy) * slope - 0.5f;
+  xs = xs < -STROKE_FAR ? -STROKE_FAR : (xs > STROKE_FAR ? STROKE_FAR : xs);
+  int k = (int)xs; // arrotondamento verso zero, corretto sotto
+  if (nx > 0.0f) {
+    if ((float)k < xs) k++; // ceil: primo pixel con s >= 0
+    if (ge) { if (*xa < k) *xa = k; }
+    else    { if (*xb > k - 1) *xb = k - 1; }
+  } else {
+    if ((float)k > xs) k--; // floor: ultimo pixel con s >= 0
+    if (ge) { if (*xb > k) *xb = k; }
+    else    { if (*xa < k + 1) *xa = k + 1; }
+  }
+}
+
+// Capsula dello smusso a un estremo del segmento, preparata solo se serve
+typedef struct stroke_chord {
+  const cobra_stroke_joint *joint;
+  cobra_line_depth depth; // profondità costante del vertice (solo con has_depth)
+  bool has_depth;
+  bool ready;
+  cobra_capsule capsule;
+} stroke_chord;
+
+// Parte dello smusso nelle colonne [xa, xb] della riga y
+static void stroke_chord_span(cobra_surface *surf, stroke_chord *ch, const cobra_rect *clip, int y,
+                              int xa, int xb, float radius, const cobra_blend *blend, cobra_aa_mode aa_mode)
+{
+  if (xa > xb)
+    return;
+  if (!ch->ready) {
+    const cobra_stroke_joint *j = ch->joint;
+    float len = 2.0f * (radius + 2.0f * STROKE_BEVEL_PAD);
+    cobra_capsule_init(&ch->capsule, surf, j->cx0, j->cy0, j->cx1, j->cy1, len * len, 1.0f / len,
+                       j->chord_width, blend, ch->has_depth ? &ch->depth : NULL, aa_mode, false);
+    ch->ready = true;
+  }
+  int ca, cb;
+  if (!cobra_capsule_cols(&ch->capsule, y, clip->x0, clip->x1, &ca, &cb))
+    return;
+  cobra_capsule_span(&ch->capsule, y, xa > ca ? xa : ca, xb < cb ? xb : cb);
+}
+
+bool cobra_raster_stroke(cobra_surface *surf, const cobra_rect *clip, float x0, float y0, float x1, float y1,
+                         const cobra_stroke_joint *start, const cobra_stroke_joint *end, float width,
+                         const cobra_blend *blend, const cobra_line_depth *depth, cobra_aa_mode aa_mode)
+{
+  float ux, uy;
+  if (!stroke_dir(x0, y0, x1, y1, &ux, &uy))
+    return false;
+  float radius = width * 0.5f;
+  static const cobra_stroke_joint cap = {0};
+  const cobra_stroke_joint *js = start ? start : &cap;
+  const cobra_stroke_joint *je = end ? end : &cap;
+
+  // Segmento allungato dagli spigoli MITER; la profondità prosegue linearmente
+  float ax = x0 - ux * js->ext, ay = y0 - uy * js->ext;
+  float bx = x1 + ux * je->ext, by = y1 + uy * je->ext;
+  cobra_line_depth main_depth;
+  if (depth) {
+    float dx = x1 - x0, dy = y1 - y0;
+    float dz = (depth->z1 - depth->z0) / sqrtf(dx * dx + dy * dy);
+    main_depth = *depth;
+    main_depth.z0 = depth->z0 - dz * js->ext;
+    main_depth.z1 = depth->z1 + dz * je->ext;
+  }
+
+  // Guard band attorno al clip come per le linee singole. I confini e gli smussi usano i
+  // vertici originali, quindi non risentono del taglio.
+  float cx0 = ax, cy0 = ay, cx1 = bx, cy1 = by;
+  float gb_margin = radius + 2.0f;
+  if (!cobra_clip_line_f(&cx0, &cy0, &cx1, &cy1,
+                         (float)clip->x0 - gb_margin, (float)clip->y0 - gb_margin,
+                         (float)clip->x1 + gb_margin, (float)clip->y1 + gb_margin))
+    return false;
+  float fdx = cx1 - cx0, fdy = cy1 - cy0;
+  float len_sq = fdx * fdx + fdy * fdy;
+  if (len_sq <= 0.0f)
+    return false;
+  if (depth)
+    cobra_line_depth_clip(&main_depth, ax, ay, bx, by, cx0, cy0, cx1, cy1);
+
+  cobra_capsule main;
+  cobra_capsule_init(&main, surf, cx0, cy0, cx1, cy1, len_sq, 1.0f / sqrtf(len_sq), width, blend,
+                     depth ? &main_depth : NULL, aa_mode, false);
+
+  // Oltre un vertice smussato (t < 0 o t > 1) i pixel vanno alla capsula della corda, con
+  // la profondità del vertice: il confine è la normale del segmento. Le capsule vengono
+  // preparate alla prima riga che le usa (spesso nessuna, nelle curve strette e corte).
+  stroke_chord chord[2];
+  for (int e = 0; e < 2; e++) {
+    chord[e].joint = e ? je : js;
+    chord[e].ready = false;
+    chord[e].has_depth = depth != NULL;
+    if (depth) {
+      chord[e].depth = *depth;
+      chord[e].depth.z0 = chord[e].depth.z1 = e ? depth->z1 : depth->z0;
+    }
+  }
+  float u_slope = stroke_slope(ux, uy);
+
+  int ya, yb;
+  if (!cobra_capsule_rows(&main, clip, &ya, &yb))
+    return true;
+  for (int y = ya; y <= yb; y++) {
+    int xa, xb;
+    if (!cobra_capsule_cols(&main, y, clip->x0, clip->x1, &xa, &xb))
+      continue;
+    float yc = (float)y + 0.5f;
+    if (js->cut)
+      stroke_halfplane(x0, y0, js->nx, js->ny, js->slope, yc, true, &xa, &xb);
+    if (je->cut)
+      stroke_halfplane(x1, y1, je->nx, je->ny, je->slope, yc, false, &xa, &xb);
+    if (xa > xb)
+      continue;
+
+    int ma = xa, mb = xb;
+    if (js->bevel) {
+      int sa = xa, sb = xb;
+      stroke_halfplane(x0, y0, ux, uy, u_slope, yc, false, &sa, &sb);
+      stroke_halfplane(x0, y0, ux, uy, u_slope, yc, true, &ma, &mb);
+      stroke_chord_span(surf, &chord[0], clip, y, sa, sb, radius, blend, aa_mode);
+    }
+    if (je->bevel) {
+      int sa = xa, sb = xb;
+      stroke_halfplane(x1, y1, ux, uy, u_slope, yc, true, &sa, &sb);
+      stroke_halfplane(x1, y1, ux, uy, u_slope, yc, false, &ma, &mb);
+      stroke_chord_span(surf, &chord[1], clip, y, sa, sb, radius, blend, aa_mode);
+    }
+    if (ma <= mb)
+      cobra_capsule_shade(&main, y, ma, mb);
+  }
+  return true;
+}
+
+// --- Percorsi ---
+// I punti arrivano uno alla volta: il segmento a -> b parte quando si conosce il punto
+// successivo (o la fine del percorso), senza copiare l'array né allocare memoria.
+// Il raccordo in b serve sia ad a -> b che al segmento seguente e viene calcolato una volta.
+typedef struct stroker {
+  cobra_surface *surf;
+  cobra_rect full;
+  float width;
+  cobra_line_join join;
+  cobra_aa_mode aa_mode;
+  cobra_blend blend;
+  bool has_depth;
+  int n;                  // punti in attesa: [precedente,] a, b
+  float x[3], y[3], z[3]; // z: profondità 0..1 (solo con has_depth)
+  cobra_stroke_joint joint; // raccordo in a (se n == 3)
+} stroker;
+
+static void stroker_init(stroker *s, cobra_surface *surf, float width, uint32_t color,
+                         cobra_line_join join, cobra_aa_mode aa_mode, bool has_depth)
+{
+  s->surf = surf;
+  s->full = (cobra_rect){0, 0, surf->width, surf->height};
+  s->join = join;
+  s->aa_mode = aa_mode;
+  s->has_depth = has_depth;
+  s->n = 0;
+  cobra_blend_init(&s->blend, surf, color);
+  // Sotto 1px in SDF il percorso hairline delle linee singole non conosce i raccordi:
+  // tracciamo 1px con la stessa intensità sqrt(width), applicata all'alpha
+  s->width = width;
+  if (aa_mode == COBRA_AA_SDF && width < 1.0f) {
+    uint32_t k = cobra_coverage(sqrtf(fmaxf(width, 0.0f)));
+    s->blend.color = cobra_swar_scale(s->blend.color, k);
+    s->blend.alpha = (s->blend.alpha * k + 128) >> 8;
+    s->width = 1.0f;
+  }
+}
+
+// Invia il segmento a -> b della finestra; next: raccordo in b (NULL a fine percorso)
+static void stroker_emit(stroker *s, const cobra_stroke_joint *next, float nx, float ny)
+{
+  cobra_surface *surf = s->surf;
+  int a = s->n - 2;
+  float x0 = s->x[a], y0 = s->y[a], x1 = s->x[a + 1], y1 = s->y[a + 1];
+  cobra_line_depth depth;
+  if (s->has_depth) {
+    depth.z0 = s->z[a];
+    depth.z1 = s->z[a + 1];
+    depth.func = surf->depth_func;
+    depth.write = surf->depth_write;
+  }
+  const cobra_line_depth *dp = s->has_depth ? &depth : NULL;
+
+  COBRA_STAT_ADD(lines_submitted, 1);
+  if (surf->deferred) {
+    cobra_stroke_seg seg = {x0, y0, x1, y1, s->x[0], s->y[0], nx, ny, a > 0, next != NULL};
+    cobra_deferred_record_stroke(surf, &seg, s->width, s->join, &s->blend, dp, s->aa_mode);
+    return;
+  }
+  cobra_mark_dirty_line(surf, x0, y0, x1, y1, 2.0f * cobra_stroke_reach(s->width, s->join));
+  if (!cobra_raster_stroke(surf, &s->full, x0, y0, x1, y1, a > 0 ? &s->joint : NULL, next,
+                           s->width, &s->blend, dp, s->aa_mode))
+    COBRA_STAT_ADD(lines_clipped, 1);
+}
+
+static void stroker_point(stroker *s, float x, float y, float z)
+{
+  if (s->n > 0) {
+    float dx = x - s->x[s->n - 1], dy = y - s->y[s->n - 1];
+    if (dx * dx + dy * dy < STROKE_MIN_LEN_SQ)
+      return;
+  }
+  if (s->n < 2) {
+    s->x[s->n] = x; s->y[s->n] = y; s->z[s->n] = z;
+    s->n++;
+    return;
+  }
+  // Il punto nuovo completa il raccordo in b: parte il segmento a -> b
+  int b = s->n - 1;
+  cobra_stroke_joint joint;
+  cobra_stroke_joint_init(&joint, s->x[b - 1], s->y[b - 1], s->x[b], s->y[b], x, y, s->width, s->join);
+  stroker_emit(s, &joint, x, y);
+  // La finestra scorre: [a, b, nuovo]
+  for (int i = 0; i < 2; i++) {
+    s->x[i] = s->x[b - 1 + i];
+    s->y[i] = s->y[b - 1 + i];
+    s->z[i] = s->z[b - 1 + i];
+  }
+  s->x[2] = x; s->y[2] = y; s->z[2] = z;
+  s->n = 3;
+  s->joint = joint;
+}
+
+// Chiude il percorso: l'ultimo segmento termina con la punta tonda
+static void stroker_end(stroker *s)
+{
+  if (s->n >= 2)
+    stroker_emit(s, NULL, 0.0f, 0.0f);
+  s->n = 0;
+}
+
+void cobra_window_draw_polyline_aa(cobra_surface *surf, const float *x, const float *y, int count,
+                                   float width, uint32_t color, cobra_line_join join, cobra_aa_mode aa_mode)
+{
+  if (!surf || !x || !y || count < 2)
+    return;
+
+  COBRA_SCOPE_BEGIN(scope, "polyline", COBRA_TIMER_RASTER);
+  stroker s;
+  stroker_init(&s, surf, width, color, join, aa_mode, false);
+  for (int i = 0; i < count; i++)
+    stroker_point(&s, x[i], y[i], 0.0f);
+  stroker_end(&s);
+  COBRA_SCOPE_END(scope);
+}
+
+// Proietta un punto davanti al piano near e lo aggiunge al percorso
+static void stroker_point_3d(stroker *s, cobra_vec3 p, float fov)
+{
+  cobra_surface *surf = s->surf;
+  cobra_vec3 q = cobra_vec3_project(p, fov, (float)surf->width, (float)surf->height);
+  stroker_point(s, q.x, q.y, s->has_depth ? cobra_depth_from_z(surf, p.z) : 0.0f);
+}
+
+void cobra_window_draw_polyline_3d(cobra_surface *surf, const float *x, const float *y, const float *z, int count,
+                                   float fov, float thickness, uint32_t color, cobra_line_join join,
+                                   cobra_aa_mode aa_mode)
+{
+  if (!surf || !x || !y || !z || count < 2)
+    return;
+
+  COBRA_SCOPE_BEGIN(scope, "polyline_3d", COBRA_TIMER_RASTER);
+  stroker s;
+  stroker_init(&s, surf, thickness, color, join, aa_mode, cobra_depth_enabled(surf));
+
+  // I lati del frustum scartano solo i segmenti interamente fuori (il resto lo taglia la guard
+  // band 2D, che conserva i raccordi); near e far vanno tagliati in 3D prima di proiettare
+  cobra_frustum f;
+  cobra_frustum_init(&f, surf, fov, cobra_stroke_reach(s.width, join) + 2.0f);
+
+  int culled = 0;
+  cobra_vec3 pa = {{x[0], y[0], z[0]}};
+  unsigned ca = cobra_frustum_outcode(&f, pa.x, pa.y, pa.z);
+  for (int i = 1; i < count; i++) {
+    cobra_vec3 pb = {{x[i], y[i], z[i]}};
+    unsigned cb = cobra_frustum_outcode(&f, pb.x, pb.y, pb.z);
+    if (ca & cb) {
+      // Fuori vista: il percorso si interrompe (il vicino non deve cedergli pixel)
+      stroker_end(&s);
+      culled++;
+    } else if ((ca | cb) & (COBRA_CLIP_NEAR | COBRA_CLIP_FAR)) {
+      // Tagliato da near/far: disegnato da solo, con le punte tonde
+      stroker_end(&s);
+      cobra_vec3 a = pa, b = pb;
+      if (cobra_frustum_clip_line(&f, &a, &b)) {
+        stroker_point_3d(&s, a, fov);
+        stroker_point_3d(&s, b, fov);
+        stroker_end(&s);
+      } else {
+        culled++;
+      }
+    } else {
+      // Ogni vertice viene proiettato una volta: a è già nel percorso se il segmento prima c'era
+      if (s.n == 0)
+        stroker_point_3d(&s, pa, fov);
+      stroker_point_3d(&s, pb, fov);
+    }
+    pa = pb;
+    ca = cb;
+  }
+  stroker_end(&s);
+  COBRA_STAT_ADD(lines_culled, culled);
+  COBRA_SCOPE_END(scope);
+}
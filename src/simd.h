@@ -0,0 +1,178 @@
+#ifndef COBRAGL_SIMD_H
+#define COBRAGL_SIMD_H
+
+// Astrazione minima sui registri SIMD, condivisa dai kernel interni (span.c, isa/kernels.c, triangle.c).
+// vf = COBRA_SIMD_LANES float, vi = COBRA_SIMD_LANES interi a 32 bit.
+// AVX2 se il compilatore lo abilita (-mavx2), altrimenti SSE2 (sempre presente su x86-64).
+// Senza nessuno dei due COBRA_SIMD_LANES non è definito e i kernel usano la versione scalare;
+// COBRA_ISA_SCALAR ottiene lo stesso risultato anche su x86 (variante scalar di isa/kernels.c).
+// COBRA_SIMD_AVX512 abilita i 16 lane AVX-512: definisce solo le operazioni usate da
+// isa/kernels.c (niente confronti, selezioni e gather), quindi è riservato a quel file.
+
+#if defined(COBRA_ISA_SCALAR)
+// Nessun registro SIMD
+#elif defined(COBRA_SIMD_AVX512) && defined(__AVX512F__) && defined(__AVX512BW__)
+#include <immintrin.h>
+#define COBRA_SIMD_LANES 16
+typedef __m512 vf;
+typedef __m512i vi;
+#define VF_SET1(x)      _mm512_set1_ps(x)
+#define VF_LOAD(p)      _mm512_loadu_ps(p)
+#define VF_STORE(p, v)  _mm512_storeu_ps(p, v)
+#define VF_ADD(a, b)    _mm512_add_ps(a, b)
+#define VF_SUB(a, b)    _mm512_sub_ps(a, b)
+#define VF_MUL(a, b)    _mm512_mul_ps(a, b)
+#define VI_SET1(x)      _mm512_set1_epi32((int)(x))
+#define VI_LOAD(p)      _mm512_loadu_si512((const void *)(p))
+#define VI_STORE(p, v)  _mm512_storeu_si512((void *)(p), v)
+#define VI_STORE_A(p, v) _mm512_store_si512((void *)(p), v)
+#define VI_STREAM(p, v) _mm512_stream_si512((void *)(p), v)
+#define VI_AND(a, b)    _mm512_and_si512(a, b)
+#define VI_OR(a, b)     _mm512_or_si512(a, b)
+#define VI_SRLI(a, n)   _mm512_srli_epi32(a, n)
+#define VI_SLLI(a, n)   _mm512_slli_epi32(a, n)
+#define VI_SUB(a, b)    _mm512_sub_epi32(a, b)
+#define VI_MUL16(a, b)  _mm512_mullo_epi16(a, b)
+#define VI_ADD16(a, b)  _mm512_add_epi16(a, b)
+#define VI_SRLI16(a, n) _mm512_srli_epi16(a, n)
+#define VI_SLLI16(a, n) _mm512_slli_epi16(a, n)
+#define VI_ADDS8(a, b)  _mm512_adds_epu8(a, b)
+#define VI_MAX8(a, b)   _mm512_max_epu8(a, b)
+#define VI_ADD(a, b)    _mm512_add_epi32(a, b)
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define COBRA_SIMD_LANES 8
+typedef __m256 vf;
+typedef __m256i vi;
+#define VF_SET1(x)      _mm256_set1_ps(x)
+#define VF_LOAD(p)      _mm256_loadu_ps(p)
+#define VF_STORE(p, v)  _mm256_storeu_ps(p, v)
+#define VF_ADD(a, b)    _mm256_add_ps(a, b)
+#define VF_SUB(a, b)    _mm256_sub_ps(a, b)
+#define VF_MUL(a, b)    _mm256_mul_ps(a, b)
+#define VF_MIN(a, b)    _mm256_min_ps(a, b)
+#define VF_MAX(a, b)    _mm256_max_ps(a, b)
+#define VF_DIV(a, b)    _mm256_div_ps(a, b)
+#define VF_SQRT(a)      _mm256_sqrt_ps(a)
+#define VF_ABS(a)       _mm256_and_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF)))
+#define VF_GATHER(p, i) _mm256_i32gather_ps(p, i, 4)
+#define VF_LT(a, b)     _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define VF_GT(a, b)     _mm256_cmp_ps(a, b, _CMP_GT_OQ)
+#define VF_GE(a, b)     _mm256_cmp_ps(a, b, _CMP_GE_OQ)
+#define VF_LE(a, b)     _mm256_cmp_ps(a, b, _CMP_LE_OQ)
+#define VF_AND(a, b)    _mm256_and_ps(a, b)
+#define VF_ONES()       _mm256_castsi256_ps(_mm256_set1_epi32(-1))
+#define VF_SELECT(m, a, b) _mm256_blendv_ps(b, a, m)
+#define VF_MOVEMASK(m)  _mm256_movemask_ps(m)
+#define VF_TO_VI(a)     _mm256_cvttps_epi32(a)
+#define VI_TO_VF(a)     _mm256_cvtepi32_ps(a)
+#define VI_SET1(x)      _mm256_set1_epi32((int)(x))
+#define VI_LOAD(p)      _mm256_loadu_si256((const __m256i *)(p))
+#define VI_STORE(p, v)  _mm256_storeu_si256((__m256i *)(p), v)
+#define VI_STORE_A(p, v) _mm256_store_si256((__m256i *)(p), v)
+#define VI_STREAM(p, v) _mm256_stream_si256((__m256i *)(p), v)
+#define VI_AND(a, b)    _mm256_and_si256(a, b)
+#define VI_OR(a, b)     _mm256_or_si256(a, b)
+#define VI_SRLI(a, n)   _mm256_srli_epi32(a, n)
+#define VI_SLLI(a, n)   _mm256_slli_epi32(a, n)
+#define VI_SELECT(m, a, b) _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b), _mm256_castsi256_ps(a), m))
+#define VI_SUB(a, b)    _mm256_sub_epi32(a, b)
+#define VI_MUL16(a, b)  _mm256_mullo_epi16(a, b)
+#define VI_ADD16(a, b)  _mm256_add_epi16(a, b)
+#define VI_SRLI16(a, n) _mm256_srli_epi16(a, n)
+#define VI_SLLI16(a, n) _mm256_slli_epi16(a, n)
+#define VI_ADDS8(a, b)  _mm256_adds_epu8(a, b)
+#define VI_MAX8(a, b)   _mm256_max_epu8(a, b)
+#define VI_ADD(a, b)    _mm256_add_epi32(a, b)
+#define VI_SRAI(a, n)   _mm256_srai_epi32(a, n)
+#define VI_CMPGT(a, b)  _mm256_cmpgt_epi32(a, b)
+#define VI_AS_VF(a)     _mm256_castsi256_ps(a)
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define COBRA_SIMD_LANES 4
+typedef __m128 vf;
+typedef __m128i vi;
+#define VF_SET1(x)      _mm_set1_ps(x)
+#define VF_LOAD(p)      _mm_loadu_ps(p)
+#define VF_STORE(p, v)  _mm_storeu_ps(p, v)
+#define VF_ADD(a, b)    _mm_add_ps(a, b)
+#define VF_SUB(a, b)    _mm_sub_ps(a, b)
+#define VF_MUL(a, b)    _mm_mul_ps(a, b)
+#define VF_MIN(a, b)    _mm_min_ps(a, b)
+#define VF_MAX(a, b)    _mm_max_ps(a, b)
+#define VF_DIV(a, b)    _mm_div_ps(a, b)
+#define VF_SQRT(a)      _mm_sqrt_ps(a)
+#define VF_ABS(a)       _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)))
+// SSE2 non ha gather: quattro load scalari
+#define VF_GATHER(p, i) cobra_gather_ps(p, i)
+#define VF_LT(a, b)     _mm_cmplt_ps(a, b)
+#define VF_GT(a, b)     _mm_cmpgt_ps(a, b)
+#define VF_GE(a, b)     _mm_cmpge_ps(a, b)
+#define VF_LE(a, b)     _mm_cmple_ps(a, b)
+#define VF_AND(a, b)    _mm_and_ps(a, b)
+#define VF_ONES()       _mm_castsi128_ps(_mm_set1_epi32(-1))
+// SSE2 non ha blendv: selezione con and/andnot/or
+#define VF_SELECT(m, a, b) _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+#define VF_MOVEMASK(m)  _mm_movemask_ps(m)
+#define VF_TO_VI(a)     _mm_cvttps_epi32(a)
+#define VI_TO_VF(a)     _mm_cvtepi32_ps(a)
+#define VI_SET1(x)      _mm_set1_epi32((int)(x))
+#define VI_LOAD(p)      _mm_loadu_si128((const __m128i *)(p))
+#define VI_STORE(p, v)  _mm_storeu_si128((__m128i *)(p), v)
+#define VI_STORE_A(p, v) _mm_store_si128((__m128i *)(p), v)
+#define VI_STREAM(p, v) _mm_stream_si128((__m128i *)(p), v)
+#define VI_AND(a, b)    _mm_and_si128(a, b)
+#define VI_OR(a, b)     _mm_or_si128(a, b)
+#define VI_SRLI(a, n)   _mm_srli_epi32(a, n)
+#define VI_SLLI(a, n)   _mm_slli_epi32(a, n)
+#define VI_SELECT(m, a, b) _mm_or_si128(_mm_and_si128(_mm_castps_si128(m), a), _mm_andnot_si128(_mm_castps_si128(m), b))
+#define VI_SUB(a, b)    _mm_sub_epi32(a, b)
+#define VI_MUL16(a, b)  _mm_mullo_epi16(a, b)
+#define VI_ADD16(a, b)  _mm_add_epi16(a, b)
+#define VI_SRLI16(a, n) _mm_srli_epi16(a, n)
+#define VI_SLLI16(a, n) _mm_slli_epi16(a, n)
+#define VI_ADDS8(a, b)  _mm_adds_epu8(a, b)
+#define VI_MAX8(a, b)   _mm_max_epu8(a, b)
+#define VI_ADD(a, b)    _mm_add_epi32(a, b)
+#define VI_SRAI(a, n)   _mm_srai_epi32(a, n)
+#define VI_CMPGT(a, b)  _mm_cmpgt_epi32(a, b)
+#define VI_AS_VF(a)     _mm_castsi128_ps(a)
+
+static inline __m128 cobra_gather_ps(const float *p, __m128i idx)
+{
+  int i[4];
+  _mm_storeu_si128((__m128i *)i, idx);
+  return _mm_set_ps(p[i[3]], p[i[2]], p[i[1]], p[i[0]]);
+}
+#endif
+
+#ifdef COBRA_SIMD_LANES
+#include "cobragl/surface.h"
+
+// Versione vettoriale di cobra_swar_scale: a16 contiene il fattore 0..256 replicato
+// nelle due metà a 16 bit di ogni lane
+static inline vi cobra_scale_lanes(vi c, vi a16)
+{
+  const vi lo = VI_SET1(0x00FF00FFu);
+  const vi round = VI_SET1(0x00800080u);
+  vi rb = VI_SRLI16(VI_ADD16(VI_MUL16(VI_AND(c, lo), a16), round), 8);
+  vi ag = VI_SRLI16(VI_ADD16(VI_MUL16(VI_AND(VI_SRLI(c, 8), lo), a16), round), 8);
+  return VI_OR(rb, VI_SLLI16(ag, 8));
+}
+
+#ifdef VF_LT
+// Maschera dei lane che superano il test di profondità
+static inline vf cobra_depth_lanes(vf z, vf stored, cobra_depth_func func)
+{
+  switch (func) {
+  case COBRA_DEPTH_LESS:    return VF_LT(z, stored);
+  case COBRA_DEPTH_LEQUAL:  return VF_LE(z, stored);
+  case COBRA_DEPTH_GREATER: return VF_GT(z, stored);
+  case COBRA_DEPTH_GEQUAL:  return VF_GE(z, stored);
+  default:                  return VF_ONES();
+  }
+}
+#endif
+#endif
+
+#endif // COBRAGL_SIMD_H
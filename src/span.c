@@ -0,0 +1,111 @@
+// Setup degli span del rasterizzatore SDF delle linee AA.
+//
+// I kernel che elaborano gli span (copertura, test di profondità e blending, con SSE2 o AVX2)
+// stanno in isa/span.c e sono compilati per ogni set di istruzioni: qui prepariamo la
+// copertura di una linea e scegliamo il kernel dalla variante scelta da dispatch.c.
+//
+// Nella fascia AA la copertura dipende dalla modalità (cobra_aa_mode):
+// - SDF: rampa lineare r_out - distanza, la più economica;
+// - LUT: tabella indicizzata con la distanza^2 quantizzata, nessuna radice quadrata. Le righe
+//   sono precalcolate per raggi multipli di 1/16 px con un filtro a disco di area unitaria,
+//   quindi le linee sottili hanno la larghezza reale e i bordi il profilo di un filtro;
+// - BOX: area esatta del pixel dentro la striscia del corpo (filtro box, dipende dall'angolo).
+//   Sulle punte il bordo è approssimato con il semipiano tangente alla capsula.
+
+#define _POSIX_C_SOURCE 200809L
+#include "internal.h"
+#include <math.h>
+#include <pthread.h>
+
+// --- Copertura LUT ---
+#define LUT_STEPS 16                       // righe per pixel di raggio
+#define LUT_ROWS (8 * LUT_STEPS + 1)       // raggi da 0 a 8 px; oltre si usa l'ultima riga
+#define DISK_RADIUS 0.56418958f            // 1/sqrt(pi): disco di area 1
+
+static float coverage_lut[LUT_ROWS][COBRA_COVERAGE_LUT_SIZE];
+static pthread_once_t coverage_lut_once = PTHREAD_ONCE_INIT;
+
+// Frazione del disco filtro a sinistra della retta x = s
+static float disk_below(float s)
+{
+  float x = s / DISK_RADIUS;
+  if (x <= -1.0f) return 0.0f;
+  if (x >= 1.0f) return 1.0f;
+  return 0.5f + (asinf(x) + x * sqrtf(1.0f - x * x)) * 0.31830989f;
+}
+
+// Estremi della fascia AA in distanza^2: sotto lo^2 copertura piena, sopra hi^2 nulla
+static void lut_band(float radius, float *lo, float *hi)
+{
+  *lo = radius > DISK_RADIUS ? radius - DISK_RADIUS : 0.0f;
+  *hi = radius + DISK_RADIUS;
+}
+
+static void build_coverage_lut(void)
+{
+  for (int row = 0; row < LUT_ROWS; row++) {
+    float r = (float)row / LUT_STEPS, lo, hi;
+    lut_band(r, &lo, &hi);
+    // Ogni elemento vale al centro del suo intervallo di distanza^2
+    for (int i = 0; i < COBRA_COVERAGE_LUT_SIZE; i++) {
+      float dist = sqrtf(lo * lo + (i + 0.5f) * (hi * hi - lo * lo) / COBRA_COVERAGE_LUT_SIZE);
+      coverage_lut[row][i] = disk_below(r - dist) - disk_below(-r - dist);
+    }
+  }
+}
+
+void cobra_span_setup_coverage(cobra_sdf_span *s, cobra_aa_mode mode, float radius, float ux, float uy, float len)
+{
+  s->aa = COBRA_AA_SDF;
+  if (mode == COBRA_AA_LUT) {
+    pthread_once(&coverage_lut_once, build_coverage_lut);
+    // Raggi negativi o NaN (larghezze non valide) usano la prima riga, come un raggio nullo;
+    // il confronto precede la conversione, che per raggi enormi non sarebbe definita
+    float steps = radius * LUT_STEPS + 0.5f;
+    int row = 0;
+    if (steps >= (float)LUT_ROWS)
+      row = LUT_ROWS - 1;
+    else if (radius > 0.0f)
+      row = (int)steps;
+    float lo, hi;
+    lut_band(radius, &lo, &hi);
+    s->aa = COBRA_AA_LUT;
+    s->lut = coverage_lut[row];
+    s->lut_lo_sq = lo * lo;
+    s->lut_scale = COBRA_COVERAGE_LUT_SIZE / (hi * hi - lo * lo);
+    s->r_in_sq = (radius > DISK_RADIUS) ? lo * lo : 0.0f;
+    s->r_out = hi;
+    s->r_out_sq = hi * hi;
+  } else if (mode == COBRA_AA_BOX) {
+    // Il pixel sporge dal centro al massimo di mezza diagonale
+    const float reach = 0.7072f;
+    s->aa = COBRA_AA_BOX;
+    s->radius = radius;
+    s->len = len;
+    s->ux = ux;
+    s->uy = uy;
+    float ax = fabsf(ux), ay = fabsf(uy);
+    cobra_box_shape_init(&s->box, fmaxf(ax, ay), fminf(ax, ay));
+    s->r_in_sq = (radius > reach) ? (radius - reach) * (radius - reach) : 0.0f;
+    s->r_out = radius + reach;
+    s->r_out_sq = s->r_out * s->r_out;
+  }
+}
+
+// [copertura][blending][tiled * 2 + depth], nella variante scelta da dispatch.c
+cobra_span_kernel cobra_span_select(const cobra_sdf_span *s, bool depth)
+{
+  int aa = s->aa == COBRA_AA_LUT ? 1 : (s->aa == COBRA_AA_BOX ? 2 : 0);
+  int mode;
+  switch (s->blend.mode) {
+  case COBRA_BLEND_ADDITIVE: mode = 2; break;
+  case COBRA_BLEND_MAX:      mode = 3; break;
+  default:                   mode = s->blend.alpha >= 256 ? 1 : 0; break;
+  }
+  return COBRA_KERNEL(span_kernels)[aa][mode][(s->tile_jump ? 2 : 0) + (depth ? 1 : 0)];
+}
+
+void cobra_span_sdf(uint32_t *dst, float *depth, int stride, int count, const cobra_sdf_span *s)
+{
+  cobra_span_select(s, depth != NULL)(dst, depth, stride, count, s);
+}
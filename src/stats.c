@@ -0,0 +1,213 @@
+// Contatori per frame e tracce Chrome (vedi cobragl/stats.h).
+//
+// I contatori del frame in corso sono uint64_t aggiornati con add atomici rilassati: i kernel
+// accumulano in variabili locali e sommano una volta per span o per triangolo.
+// Gli scope misurano il tempo solo al livello più esterno di ogni categoria (profondità per
+// thread), così una draw di mesh che esegue un flush non conta due volte lo stesso intervallo.
+// Gli eventi di traccia vengono scritti subito nel file, sotto un mutex: sono pochi per frame
+// (clear, flush, tile, mesh, batch, present), le singole linee non generano eventi.
+
+#define _POSIX_C_SOURCE 200809L
+#include "cobragl/stats.h"
+#include "internal.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define STATS_FIELDS (sizeof(cobra_stats) / sizeof(uint64_t))
+
+#ifdef COBRA_STATS
+
+cobra_stats cobra_stats_current;
+static cobra_stats stats_last;
+
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *trace_file;
+static bool trace_active;   // letto senza lock dagli scope
+static bool trace_first;    // nessun evento ancora scritto (niente virgola)
+static uint64_t trace_origin;
+static int trace_threads;
+
+static __thread int thread_id; // 0 = non ancora assegnato
+static __thread int scope_depth[COBRA_TIMER_COUNT];
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t *timer_field(cobra_timer timer)
+{
+  switch (timer) {
+  case COBRA_TIMER_CLEAR:   return &cobra_stats_current.ns_clear;
+  case COBRA_TIMER_PRESENT: return &cobra_stats_current.ns_present;
+  default:                  return &cobra_stats_current.ns_raster;
+  }
+}
+
+// Va chiamata con trace_lock acquisito
+static void trace_write(const char *event)
+{
+  fprintf(trace_file, "%s\n%s", trace_first ? "" : ",", event);
+  trace_first = false;
+}
+
+void cobra_scope_begin(cobra_scope *s, const char *name, cobra_timer timer)
+{
+  s->name = name;
+  s->timer = timer;
+  s->outer = (timer != COBRA_TIMER_NONE) && scope_depth[timer]++ == 0;
+  s->traced = name && __atomic_load_n(&trace_active, __ATOMIC_RELAXED);
+  s->t0 = (s->outer || s->traced) ? now_ns() : 0;
+}
+
+void cobra_scope_end(cobra_scope *s)
+{
+  if (s->timer != COBRA_TIMER_NONE)
+    scope_depth[s->timer]--;
+  if (!s->outer && !s->traced)
+    return;
+
+  uint64_t t1 = now_ns();
+  if (s->outer)
+    __atomic_fetch_add(timer_field(s->timer), t1 - s->t0, __ATOMIC_RELAXED);
+  if (!s->traced)
+    return;
+
+  if (!thread_id)
+    thread_id = __atomic_add_fetch(&trace_threads, 1, __ATOMIC_RELAXED);
+
+  char event[256];
+  pthread_mutex_lock(&trace_lock);
+  if (trace_file && s->t0 >= trace_origin) {
+    snprintf(event, sizeof(event),
+             "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+             s->name, (double)(s->t0 - trace_origin) * 1e-3, (double)(t1 - s->t0) * 1e-3, thread_id);
+    trace_write(event);
+  }
+  pthread_mutex_unlock(&trace_lock);
+}
+
+void cobra_stats_get(cobra_stats *out)
+{
+  if (!out)
+    return;
+  const uint64_t *src = (const uint64_t *)&cobra_stats_current;
+  uint64_t *dst = (uint64_t *)out;
+  for (size_t i = 0; i < STATS_FIELDS; i++)
+    dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+}
+
+void cobra_stats_end_frame(void)
+{
+  uint64_t *src = (uint64_t *)&cobra_stats_current;
+  uint64_t *dst = (uint64_t *)&stats_last;
+  uint64_t frame = cobra_stats_current.frame;
+  for (size_t i = 0; i < STATS_FIELDS; i++)
+    dst[i] = __atomic_exchange_n(&src[i], 0, __ATOMIC_RELAXED);
+  stats_last.frame = frame;
+  cobra_stats_current.frame = frame + 1;
+
+  if (!__atomic_load_n(&trace_active, __ATOMIC_RELAXED))
+    return;
+
+  // Contatori del frame come eventi "C": nel visualizzatore diventano grafici nel tempo
+  const cobra_stats *st = &stats_last;
+  double ts = (double)(now_ns() - trace_origin) * 1e-3;
+  char event[512];
+  pthread_mutex_lock(&trace_lock);
+  if (trace_file) {
+    snprintf(event, sizeof(event),
+             "{\"name\":\"pixels\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,"
+             "\"args\":{\"evaluated\":%llu,\"blended\":%llu}}",
+             ts, (unsigned long long)st->pixels_evaluated, (unsigned long long)st->pixels_blended);
+    trace_write(event);
+    snprintf(event, sizeof(event),
+             "{\"name\":\"primitives\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,"
+             "\"args\":{\"lines\":%llu,\"lines_clipped\":%llu,\"lines_culled\":%llu,"
+             "\"triangles\":%llu,\"triangles_culled\":%llu,\"meshes_culled\":%llu,\"meshes_occluded\":%llu,"
+             "\"points\":%llu,\"points_culled\":%llu}}",
+             ts, (unsigned long long)st->lines_submitted, (unsigned long long)st->lines_clipped,
+             (unsigned long long)st->lines_culled, (unsigned long long)st->triangles_submitted,
+             (unsigned long long)st->triangles_culled, (unsigned long long)st->meshes_culled,
+             (unsigned long long)st->meshes_occluded, (unsigned long long)st->points_submitted,
+             (unsigned long long)st->points_culled);
+    trace_write(event);
+    snprintf(event, sizeof(event),
+             "{\"name\":\"frame %llu\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":0}",
+             (unsigned long long)st->frame, ts);
+    trace_write(event);
+  }
+  pthread_mutex_unlock(&trace_lock);
+}
+
+void cobra_stats_last_frame(cobra_stats *out)
+{
+  if (out)
+    *out = stats_last;
+}
+
+bool cobra_stats_trace_begin(const char *path)
+{
+  if (!path)
+    return false;
+  cobra_stats_trace_end();
+
+  FILE *f = fopen(path, "w");
+  if (!f)
+    return false;
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", f);
+
+  pthread_mutex_lock(&trace_lock);
+  trace_file = f;
+  trace_first = true;
+  trace_origin = now_ns();
+  pthread_mutex_unlock(&trace_lock);
+  __atomic_store_n(&trace_active, true, __ATOMIC_RELAXED);
+  return true;
+}
+
+void cobra_stats_trace_end(void)
+{
+  __atomic_store_n(&trace_active, false, __ATOMIC_RELAXED);
+  pthread_mutex_lock(&trace_lock);
+  if (trace_file) {
+    fputs("\n]}\n", trace_file);
+    fclose(trace_file);
+    trace_file = NULL;
+  }
+  pthread_mutex_unlock(&trace_lock);
+}
+
+#else // !COBRA_STATS
+
+void cobra_stats_get(cobra_stats *out)
+{
+  if (out)
+    memset(out, 0, sizeof(*out));
+}
+
+void cobra_stats_end_frame(void)
+{
+}
+
+void cobra_stats_last_frame(cobra_stats *out)
+{
+  if (out)
+    memset(out, 0, sizeof(*out));
+}
+
+bool cobra_stats_trace_begin(const char *path)
+{
+  (void)path;
+  return false;
+}
+
+void cobra_stats_trace_end(void)
+{
+}
+
+#endif
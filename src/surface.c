@@ -0,0 +1,929 @@
+#include "cobragl/surface.h"
+#include "cobragl/math.h"
+#include "internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+bool cobra_surface_create(cobra_surface *surf, int width, int height)
+{
+  if (!surf)
+    return false;
+
+  cobra_simd_init();
+
+  surf->color_buffer = NULL;
+  surf->z_buffer = NULL;
+  surf->width = 0;
+  surf->height = 0;
+  surf->tiled = false;
+  surf->tiles_x = 0;
+  surf->deferred = NULL;
+  surf->hiz = NULL;
+  surf->dirty_color = (cobra_rect){0, 0, 0, 0};
+  surf->dirty_depth = (cobra_rect){0, 0, 0, 0};
+  surf->dirty_hiz = (cobra_rect){0, 0, 0, 0};
+  surf->clear_dirty_only = false;
+  surf->last_clear_color = 0;
+  surf->last_clear_depth = 0.0f;
+  surf->color_cleared = false;
+  surf->depth_cleared = false;
+  surf->damage_count = 0;
+  surf->blend_mode = COBRA_BLEND_OVER;
+  surf->premultiplied = false;
+  surf->near_plane = COBRA_NEAR_PLANE;
+  surf->far_plane = INFINITY;
+  surf->depth_func = COBRA_DEPTH_ALWAYS;
+  surf->depth_write = false;
+  memset(surf->color_buffers, 0, sizeof(surf->color_buffers));
+  memset(surf->buffer_state, 0, sizeof(surf->buffer_state));
+  surf->buffer_count = 0;
+  surf->draw_buffer = 0;
+  surf->buffers_shared = false;
+  memset(&surf->arena, 0, sizeof(surf->arena));
+  memset(&surf->mesh_scratch, 0, sizeof(surf->mesh_scratch));
+
+  if (width <= 0 || height <= 0)
+    return false;
+
+  // Allocazione buffer
+  surf->color_buffer = (uint32_t *)malloc(sizeof(uint32_t) * width * height);
+  surf->z_buffer = (float *)malloc(sizeof(float) * width * height);
+
+  if (!surf->color_buffer || !surf->z_buffer)
+  {
+    fprintf(stderr, "Errore allocazione memoria buffer.\n");
+    cobra_surface_destroy(surf); // Libera eventuali buffer parziali
+    return false;
+  }
+
+  surf->width = width;
+  surf->height = height;
+  surf->tiles_x = (width + COBRA_FB_TILE - 1) / COBRA_FB_TILE;
+  surf->color_buffers[0] = surf->color_buffer;
+  surf->buffer_count = 1;
+
+  // Il contenuto iniziale del buffer non è definito: il primo present deve caricarlo tutto
+  surf->damage[0] = (cobra_rect){0, 0, width, height};
+  surf->damage_count = 1;
+
+  return true;
+}
+
+static inline long rect_area(const cobra_rect *r)
+{
+  return (long)(r->x1 - r->x0) * (long)(r->y1 - r->y0);
+}
+
+// Aggiunge 'r' a una lista di rettangoli di danno (quella della superficie o di un buffer salvato)
+static void damage_list_add(cobra_rect *list, int *count, const cobra_rect *r)
+{
+  if (r->x0 >= r->x1 || r->y0 >= r->y1)
+    return;
+
+  // Caso comune (es. pixel di una stessa linea): già contenuto in un rettangolo esistente
+  for (int i = 0; i < *count; i++) {
+    const cobra_rect *d = &list[i];
+    if (r->x0 >= d->x0 && r->y0 >= d->y0 && r->x1 <= d->x1 && r->y1 <= d->y1)
+      return;
+  }
+
+  // Rettangoli che si toccano o si sovrappongono vengono fusi
+  for (int i = 0; i < *count; i++) {
+    const cobra_rect *d = &list[i];
+    if (r->x0 <= d->x1 && r->x1 >= d->x0 && r->y0 <= d->y1 && r->y1 >= d->y0) {
+      cobra_rect_union(&list[i], r);
+      return;
+    }
+  }
+
+  if (*count < COBRA_MAX_DAMAGE_RECTS) {
+    list[(*count)++] = *r;
+    return;
+  }
+
+  // Lista piena: fondiamo con il rettangolo che cresce di meno
+  int best = 0;
+  long best_growth = -1;
+  for (int i = 0; i < *count; i++) {
+    cobra_rect u = list[i];
+    cobra_rect_union(&u, r);
+    long growth = rect_area(&u) - rect_area(&list[i]);
+    if (best_growth < 0 || growth < best_growth) {
+      best_growth = growth;
+      best = i;
+    }
+  }
+  cobra_rect_union(&list[best], r);
+}
+
+void cobra_damage_add(cobra_surface *surf, const cobra_rect *r)
+{
+  damage_list_add(surf->damage, &surf->damage_count, r);
+}
+
+void cobra_surface_destroy(cobra_surface *surf)
+{
+  if (!surf)
+    return;
+
+  // Ferma il pool di thread (se attivo) prima di liberare i buffer
+  cobra_surface_disable_deferred(surf);
+  cobra_surface_disable_hiz(surf);
+  cobra_arena_destroy(&surf->arena);
+
+  // Senza buffer multipli registrati (creazione fallita) l'unico buffer è color_buffer
+  if (!surf->buffer_count)
+    free(surf->color_buffer);
+  for (int i = 0; i < surf->buffer_count; i++)
+    free(surf->color_buffers[i]);
+  if (surf->z_buffer)
+    free(surf->z_buffer);
+
+  surf->color_buffer = NULL;
+  surf->z_buffer = NULL;
+  memset(surf->color_buffers, 0, sizeof(surf->color_buffers));
+  surf->buffer_count = 0;
+  surf->draw_buffer = 0;
+  surf->width = 0;
+  surf->height = 0;
+}
+
+// Nello slot del buffer di disegno restano i danni ereditati dai frame presentati nel frattempo,
+// mentre surf->damage raccoglie solo quelli del frame in corso: sono questi che cambieranno la
+// texture e vanno propagati agli altri buffer. Propagare anche quelli ereditati li farebbe
+// rimbalzare tra i buffer senza mai esaurirsi.
+static void merge_damage(cobra_rect *list, int *count, const cobra_rect *src, int src_count)
+{
+  for (int i = 0; i < src_count; i++)
+    damage_list_add(list, count, &src[i]);
+}
+
+// Rende 'index' il buffer di disegno, ripristinandone lo stato (danni del frame vuoti)
+static void load_buffer_state(cobra_surface *surf, int index)
+{
+  const cobra_buffer_state *st = &surf->buffer_state[index];
+  surf->draw_buffer = index;
+  surf->color_buffer = surf->color_buffers[index];
+  surf->dirty_color = st->dirty_color;
+  surf->last_clear_color = st->last_clear_color;
+  surf->color_cleared = st->color_cleared;
+  surf->damage_count = 0;
+}
+
+bool cobra_surface_set_buffer_count(cobra_surface *surf, int count)
+{
+  if (!surf || surf->buffers_shared)
+    return false;
+  return cobra_surface_resize_buffers(surf, count);
+}
+
+bool cobra_surface_resize_buffers(cobra_surface *surf, int count)
+{
+  if (!surf->buffer_count || count < 1 || count > COBRA_MAX_BUFFERS)
+    return false;
+  if (count == surf->buffer_count)
+    return true;
+
+  // Le linee differite scrivono nel buffer corrente, che potrebbe sparire
+  cobra_surface_flush(surf);
+
+  for (int i = surf->buffer_count; i < count; i++) {
+    surf->color_buffers[i] = (uint32_t *)malloc(sizeof(uint32_t) * cobra_buffer_pixels(surf));
+    if (!surf->color_buffers[i]) {
+      for (int j = surf->buffer_count; j < i; j++) {
+        free(surf->color_buffers[j]);
+        surf->color_buffers[j] = NULL;
+      }
+      return false;
+    }
+    // Contenuto non definito: il primo clear e il primo present devono essere completi
+    memset(&surf->buffer_state[i], 0, sizeof(surf->buffer_state[i]));
+    surf->buffer_state[i].damage[0] = (cobra_rect){0, 0, surf->width, surf->height};
+    surf->buffer_state[i].damage_count = 1;
+  }
+  for (int i = count; i < surf->buffer_count; i++) {
+    free(surf->color_buffers[i]);
+    surf->color_buffers[i] = NULL;
+  }
+  surf->buffer_count = count;
+
+  // Il buffer corrente è stato liberato: il frame in corso va perso
+  if (surf->draw_buffer >= count)
+    load_buffer_state(surf, 0);
+  // Con un solo buffer il present usa direttamente surf->damage
+  if (count == 1) {
+    cobra_buffer_state *st = &surf->buffer_state[0];
+    merge_damage(surf->damage, &surf->damage_count, st->damage, st->damage_count);
+    st->damage_count = 0;
+  }
+  return true;
+}
+
+int cobra_surface_draw_buffer(const cobra_surface *surf)
+{
+  return surf ? surf->draw_buffer : 0;
+}
+
+int cobra_surface_swap_buffers(cobra_surface *surf)
+{
+  if (!surf || surf->buffer_count < 2)
+    return surf ? surf->draw_buffer : 0;
+
+  // Il frame chiuso deve contenere anche le linee differite
+  cobra_surface_flush(surf);
+
+  // Quando il frame chiuso verrà presentato la texture cambierà dove è stato disegnato:
+  // lì anche gli altri buffer differiscono dalla texture e vanno ricaricati al loro present
+  for (int i = 0; i < surf->buffer_count; i++) {
+    cobra_buffer_state *st = &surf->buffer_state[i];
+    merge_damage(st->damage, &st->damage_count, surf->damage, surf->damage_count);
+    if (i != surf->draw_buffer)
+      continue;
+    // Nello slot del frame chiuso: tutto ciò che il present dovrà caricare
+    st->dirty_color = surf->dirty_color;
+    st->last_clear_color = surf->last_clear_color;
+    st->color_cleared = surf->color_cleared;
+  }
+
+  load_buffer_state(surf, (surf->draw_buffer + 1) % surf->buffer_count);
+  return surf->draw_buffer;
+}
+
+// Sopra questa dimensione il clear usa store non-temporal: la regione non starebbe
+// comunque in cache e così non espelle i dati utili al frame.
+#define CLEAR_STREAM_BYTES (1 << 20)
+
+// Riempie la regione 'r' di un buffer a 32 bit della superficie con 'value'
+static void fill_region(const cobra_surface *surf, uint32_t *buffer, const cobra_rect *r, uint32_t value)
+{
+  if (r->x0 >= r->x1 || r->y0 >= r->y1)
+    return;
+
+  const int pitch = surf->width;
+  long row = r->x1 - r->x0;
+  long pixels = row * (r->y1 - r->y0);
+  bool stream = pixels * (long)sizeof(uint32_t) >= CLEAR_STREAM_BYTES;
+
+  if (surf->tiled) {
+    cobra_tile_fill(surf, buffer, r, value, stream);
+    return;
+  }
+
+  // Righe intere: un'unica corsa contigua
+  if (row == pitch) {
+    cobra_span_fill(buffer + (long)r->y0 * pitch, pixels, value, stream);
+    return;
+  }
+
+  for (int y = r->y0; y < r->y1; y++)
+    cobra_span_fill(buffer + (long)y * pitch + r->x0, row, value, stream);
+}
+
+void cobra_surface_set_clear_dirty_only(cobra_surface *surf, bool enabled)
+{
+  if (!surf)
+    return;
+  surf->clear_dirty_only = enabled;
+}
+
+void cobra_window_clear_color(cobra_surface *surf, uint32_t color)
+{
+  if (!surf)
+    return;
+
+  // Il clear sovrascrive il colore dei comandi differiti in attesa: si possono scartare,
+  // a meno che qualcuno scriva anche lo z_buffer (quelle scritture devono restare)
+  if (surf->deferred) {
+    if (cobra_deferred_depth_pending(surf))
+      cobra_surface_flush(surf);
+    else
+      cobra_deferred_discard(surf);
+  }
+
+  cobra_rect full = {0, 0, surf->width, surf->height};
+  const cobra_rect *region = &full;
+  // Fuori dalle aree toccate il buffer contiene già 'color' dal clear precedente
+  if (surf->clear_dirty_only && surf->color_cleared && surf->last_clear_color == color)
+    region = &surf->dirty_color;
+
+  COBRA_SCOPE_BEGIN(scope, "clear_color", COBRA_TIMER_CLEAR);
+  fill_region(surf, surf->color_buffer, region, color);
+  COBRA_SCOPE_END(scope);
+
+  if (region == &full) {
+    // Tutto il buffer è cambiato: un solo rettangolo sostituisce la lista
+    surf->damage[0] = full;
+    surf->damage_count = 1;
+  } else {
+    cobra_damage_add(surf, region);
+  }
+
+  surf->last_clear_color = color;
+  surf->color_cleared = true;
+  surf->dirty_color = (cobra_rect){0, 0, 0, 0};
+}
+
+void cobra_window_clear_depth(cobra_surface *surf, float depth)
+{
+  if (!surf)
+    return;
+
+  // I comandi differiti in attesa vanno eseguiti (test e scritture) sulla profondità precedente
+  if (surf->deferred)
+    cobra_surface_flush(surf);
+
+  cobra_rect full = {0, 0, surf->width, surf->height};
+  const cobra_rect *region = &full;
+  if (surf->clear_dirty_only && surf->depth_cleared && surf->last_clear_depth == depth)
+    region = &surf->dirty_depth;
+
+  // Il riempimento lavora sui bit: copiamo il float in un uint32 senza violare l'aliasing
+  uint32_t bits;
+  memcpy(&bits, &depth, sizeof(bits));
+  COBRA_SCOPE_BEGIN(scope, "clear_depth", COBRA_TIMER_CLEAR);
+  fill_region(surf, (uint32_t *)surf->z_buffer, region, bits);
+  COBRA_SCOPE_END(scope);
+
+  surf->last_clear_depth = depth;
+  surf->depth_cleared = true;
+  surf->dirty_depth = (cobra_rect){0, 0, 0, 0};
+  // Anche il clear parziale lascia l'intero z_buffer a 'depth' (fuori dalla regione non c'erano scritture)
+  if (surf->hiz)
+    cobra_hiz_clear(surf, depth);
+}
+
+void cobra_window_clear(cobra_surface *surf, uint32_t color)
+{
+  if (!surf)
+    return;
+
+  // Colore e profondità vengono sovrascritti entrambi: i comandi differiti in attesa non lascerebbero traccia
+  if (surf->deferred)
+    cobra_deferred_discard(surf);
+
+  cobra_window_clear_color(surf, color);
+  cobra_window_clear_depth(surf, 1.0f); // Inizializziamo Z a 1.0 (profondità massima)
+}
+
+// Scrittura pixel con bounds check, senza controlli sulla modalità differita.
+// Usata internamente dai rasterizzatori (anche dai thread worker).
+static inline void put_pixel(cobra_surface *surf, int x, int y, uint32_t color)
+{
+  if (x >= 0 && x < surf->width && y >= 0 && y < surf->height)
+  {
+    surf->color_buffer[cobra_pixel_index(surf, x, y)] = color;
+  }
+}
+
+// Helper interno per il blending Alpha
+// Fonde il colore preparato in 'b' con copertura 'alpha' (0.0-1.0).
+static inline void blend_pixel(cobra_surface *surf, int x, int y, const cobra_blend *b, float alpha)
+{
+  if (x < 0 || x >= surf->width || y < 0 || y >= surf->height)
+    return;
+
+  if (alpha <= 0.0f) return;
+  if (alpha > 1.0f) alpha = 1.0f;
+
+  uint32_t cov = cobra_coverage(alpha);
+  if (cov)
+    cobra_blend_select(b->mode)(&surf->color_buffer[cobra_pixel_index(surf, x, y)], b, cov);
+}
+
+void cobra_blend_init(cobra_blend *b, const cobra_surface *surf, uint32_t color)
+{
+  uint32_t a = color >> 24;
+  uint32_t a256 = a + (a >> 7); // 255 -> 256
+
+  if (surf->premultiplied) {
+    // Canali maggiori dell'alpha non sono premoltiplicati validi: li limitiamo,
+    // così la somma del blending "over" non può traboccare
+    uint32_t r = (color >> 16) & 0xFF, g = (color >> 8) & 0xFF, bl = color & 0xFF;
+    if (r > a) r = a;
+    if (g > a) g = a;
+    if (bl > a) bl = a;
+    color = (a << 24) | (r << 16) | (g << 8) | bl;
+  } else {
+    color = (a << 24) | (cobra_swar_scale(color, a256) & 0x00FFFFFFu);
+  }
+
+  b->color = color;
+  b->alpha = a256;
+  b->mode = surf->blend_mode;
+}
+
+void cobra_surface_set_blend_mode(cobra_surface *surf, cobra_blend_mode mode)
+{
+  if (surf)
+    surf->blend_mode = mode;
+}
+
+void cobra_surface_set_premultiplied(cobra_surface *surf, bool premultiplied)
+{
+  if (surf)
+    surf->premultiplied = premultiplied;
+}
+
+void cobra_surface_set_clip_planes(cobra_surface *surf, float near_plane, float far_plane)
+{
+  if (!surf)
+    return;
+  // Il near plane deve restare davanti all'occhio: la proiezione divide per z
+  if (near_plane < 1e-4f) near_plane = 1e-4f;
+  if (!(far_plane > near_plane))
+    return;
+  surf->near_plane = near_plane;
+  surf->far_plane = far_plane;
+}
+
+void cobra_surface_set_depth_test(cobra_surface *surf, cobra_depth_func func, bool write)
+{
+  if (!surf)
+    return;
+  surf->depth_func = func;
+  surf->depth_write = write;
+}
+
+void cobra_window_draw_point(cobra_surface *surf, int x, int y, uint32_t color)
+{
+  if (!surf)
+    return;
+
+  // Le primitive immediate devono comparire sopra le linee differite già registrate
+  if (surf->deferred)
+    cobra_surface_flush(surf);
+
+  cobra_mark_dirty(surf, (float)x, (float)y, (float)x, (float)y);
+  put_pixel(surf, x, y, color);
+}
+
+// Versione pubblica del blending Alpha per singolo pixel
+void cobra_window_draw_point_aa(cobra_surface *surf, int x, int y, uint32_t color, float alpha)
+{
+  if (!surf)
+    return;
+
+  if (surf->deferred)
+    cobra_surface_flush(surf);
+
+  cobra_blend b;
+  cobra_blend_init(&b, surf, color);
+  cobra_mark_dirty(surf, (float)x, (float)y, (float)x, (float)y);
+  blend_pixel(surf, x, y, &b, alpha);
+}
+
+// --- COHEN-SUTHERLAND CLIPPING ALGORITHM ---
+// Definizioni dei codici di regione (Bitmask)
+#define CS_INSIDE 0  // 0000
+#define CS_LEFT   1  // 0001
+#define CS_RIGHT  2  // 0010
+#define CS_BOTTOM 4  // 0100
+#define CS_TOP    8  // 1000
+
+// Calcola il codice di regione - versione branchless ottimizzata
+static inline int compute_outcode(int x, int y, int min_x, int min_y, int max_x, int max_y) {
+    return ((x < min_x) << 0) |      // CS_LEFT
+           ((x >= max_x) << 1) |      // CS_RIGHT
+           ((y < min_y) << 2) |       // CS_BOTTOM
+           ((y >= max_y) << 3);       // CS_TOP
+}
+
+// Helper per il clipping su un bordo specifico (Integer)
+static inline void clip_to_edge(int *x, int *y, int x0, int y0, int x1, int y1, 
+                                 int edge_bit, int edge_coord) {
+    int dx = x1 - x0;
+    int dy = y1 - y0;
+    
+    // edge_bit: LEFT=1, RIGHT=2, BOTTOM=4, TOP=8
+    // Verticale se bit 0 o 1 è settato (1 o 2)
+    int is_vertical = edge_bit & 3; 
+    
+    if (is_vertical) {
+        *x = edge_coord;
+        *y = dy ? (y0 + (int)((double)dy * (edge_coord - x0) / dx)) : y0;
+    } else {
+        *y = edge_coord;
+        *x = dx ? (x0 + (int)((double)dx * (edge_coord - y0) / dy)) : x0;
+    }
+}
+
+// Algoritmo di Clipping - versione compatta (int)
+static bool cohen_sutherland_clip(int *x0, int *y0, int *x1, int *y1, 
+                                  int min_x, int min_y, int max_x, int max_y) {
+    int outcode0 = compute_outcode(*x0, *y0, min_x, min_y, max_x, max_y);
+    int outcode1 = compute_outcode(*x1, *y1, min_x, min_y, max_x, max_y);
+
+    // Massimo 4 iterazioni (una per ogni bordo)
+    for (int iter = 0; iter < 4; iter++) {
+        // Trivial Accept: entrambi dentro
+        if (!(outcode0 | outcode1)) {
+            return true;
+        } 
+        // Trivial Reject: entrambi fuori dalla stessa parte
+        if (outcode0 & outcode1) {
+            return false;
+        }
+
+        // Seleziona il punto fuori e il bit di bordo da clippare
+        int code_out = outcode0 ? outcode0 : outcode1;
+        int bit = code_out & -code_out;  // Isola il bit meno significativo (LSB)
+        
+        // Tabella di coordinate dei bordi
+        int edges[4] = {min_x, max_x - 1, min_y, max_y - 1};
+        int edge_idx = __builtin_ctz(bit);  // Count Trailing Zeros (log2 del bit)
+        int edge_coord = edges[edge_idx];
+        
+        // Calcola intersezione
+        int x, y;
+        clip_to_edge(&x, &y, *x0, *y0, *x1, *y1, bit, edge_coord);
+        
+        // Aggiorna punto e codice
+        int *px = (code_out == outcode0) ? x0 : x1;
+        int *py = (code_out == outcode0) ? y0 : y1;
+        *px = x; *py = y;
+        
+        // Ricalcola codice solo per il punto modificato
+        if (code_out == outcode0)
+             outcode0 = compute_outcode(x, y, min_x, min_y, max_x, max_y);
+        else
+             outcode1 = compute_outcode(x, y, min_x, min_y, max_x, max_y);
+    }
+    return true;
+}
+
+void cobra_window_draw_line(cobra_surface *surf, int x0, int y0, int x1, int y1, uint32_t color)
+{
+  if (!surf)
+    return;
+
+  cobra_submit_line(surf, x0, y0, x1, y1, color, NULL);
+}
+
+// Passi di Bresenham da (x0, y0) a (x1, y1), con profondità z + k * dz al passo k.
+// Il corpo viene espanso per ogni combinazione di 'checked' (estremi non garantiti dentro la
+// superficie), 'has_depth' e 'tiled': la variante è scelta una volta per linea e il loop delle
+// linee interamente visibili non ha diramazioni per pixel oltre a quelle dei dati.
+static inline __attribute__((always_inline)) void
+line_bresenham(cobra_surface *surf, int x0, int y0, int x1, int y1, uint32_t color, float z, float dz,
+               cobra_depth_func func, bool write, bool checked, bool has_depth, bool tiled)
+{
+  // Algoritmo di Bresenham super-compatto
+  // Serve a tracciare una linea rettatra due punti su 
+  // una griglia di pixel (rasterizzazione).
+
+  // Retta in forma implicita (segmento orientato)
+  // f(x,y) = (x-x0)*(y1-y0) - (y-y0)*(x1-x0)
+  //
+  // Con le convenzioni:
+  //   dx = |x1-x0| > 0
+  //   dy = -|y1-y0| < 0
+  // Calcoliamo le differenze assolute (delta) tra le coordinate
+  int dx = abs(x1 - x0);
+  int dy = -abs(y1 - y0);
+
+  //   sx = sign(x1-x0)
+  //   sy = sign(y1-y0)
+  // Determiniamo la direzione del passo (+1 o -1) per ogni asse
+  int sx = (x0 < x1) ? 1 : -1;
+  int sy = (y0 < y1) ? 1 : -1;
+
+  // valgono le identità:
+  //   x1-x0 = sx*dx
+  //   y1-y0 = -sy*dy
+  //
+  // quindi:
+  //   f(x,y) = - [ (x-x0)*sy*dy + (y-y0)*sx*dx ]
+  //
+  // Moltiplicare f per -1 NON cambia lo zero-set (f=0), ma inverte il segno.
+  // Questo è utile perché possiamo scegliere una funzione equivalente e poi
+  // usare disuguaglianze coerenti (>= / <=) nei test.
+  // Introduciamo quindi:
+  // La variabile di stato 'decision' è una trasformazione affine di f:
+  //   S(x,y) = -2*sx*sy*f(x,y) + 2*dx + 2*dy
+  //
+  // Nel loop, 'decision' è mantenuta incrementalmente: non si ricalcola da zero.
+  // È una forma affine del valore f_i = E(f_i,f_i) al pixel corrente.
+  // Questa scelta non è arbitraria:
+  // - preserva i segni rilevanti per i test geometrici
+  // - consente aggiornamenti incrementali costanti (+2*dx, +2*dy)
+  // - rende le soglie di decisione indipendenti dai quadranti
+  //
+  // Valore iniziale:
+  //   S_0 = -2*sx*sy*f(x0,y0) + 2*dx + 2*dy = 2*dx + 2*dy
+
+  // dx2 e dy2 sono variabili ausiliari in modo da operare meno 
+  // calcoli in loop
+  int dx2 = 2 * dx;
+  int dy2 = 2 * dy; 
+  int S = dx2 + dy2; // decision_0
+
+  // Nel layout lineare l'indice avanza insieme alle coordinate
+  const int width = surf->width, height = surf->height;
+  const long step_y = (long)sy * width;
+  long idx = (long)y0 * width + x0;
+  uint32_t *color_buffer = surf->color_buffer;
+  float *z_buffer = surf->z_buffer;
+
+  while (true)
+  {
+    // Disegniamo il pixel corrente. Senza 'checked' gli estremi (e quindi tutti i passi, che
+    // restano nel loro rettangolo) sono dentro la superficie: nessun bounds check
+    if (!checked || ((unsigned)x0 < (unsigned)width && (unsigned)y0 < (unsigned)height)) {
+      long p = tiled ? cobra_tile_index(surf, x0, y0) : idx;
+      if (!has_depth) {
+        color_buffer[p] = color;
+      } else if (cobra_depth_test(func, z, z_buffer[p])) {
+        color_buffer[p] = color;
+        if (write)
+          z_buffer[p] = z;
+      }
+    }
+    if (has_depth)
+      z += dz;
+
+    // Se abbiamo raggiunto il punto finale, usciamo dal loop
+    if (x0 == x1 && y0 == y1)
+      break;
+
+
+    // mi sposto in X se S>=dy che corrisponde a porre sx*sy*f(W) <= 0
+    // con W = (x_i + 1/2*sx, y_i + 1*sy)
+    int condX = (S >= dy); 
+    // mi sposto in Y se S<=dy che corrisponde a porre sx*sy*f(Q) >= 0
+    // con Q = (x_i + 1*sx, y_i + 1/2*sy)
+    int condY = (S <= dx); 
+
+    x0 += condX * sx; // aggiorniamo il valore di x0 in base a condX
+    y0 += condY * sy; // aggiorniamo il valore di y0 in base a condY
+    idx += condX * sx + condY * step_y;
+    S += condX * dy2 + condY * dx2; // aggiorniamo decision
+  }
+}
+
+#define BRESENHAM_KERNEL(name, checked, has_depth, tiled)                                             \
+  static void name(cobra_surface *surf, int x0, int y0, int x1, int y1, uint32_t color, float z,     \
+                   float dz, cobra_depth_func func, bool write)                                      \
+  {                                                                                                  \
+    line_bresenham(surf, x0, y0, x1, y1, color, z, dz, func, write, checked, has_depth, tiled);      \
+  }
+
+#define BRESENHAM_KERNELS(name, checked)                                                             \
+  BRESENHAM_KERNEL(name##_linear, checked, false, false)                                             \
+  BRESENHAM_KERNEL(name##_linear_depth, checked, true, false)                                        \
+  BRESENHAM_KERNEL(name##_tiled, checked, false, true)                                               \
+  BRESENHAM_KERNEL(name##_tiled_depth, checked, true, true)
+
+BRESENHAM_KERNELS(bresenham_inside, false)
+BRESENHAM_KERNELS(bresenham_checked, true)
+
+typedef void (*bresenham_kernel)(cobra_surface *surf, int x0, int y0, int x1, int y1, uint32_t color,
+                                 float z, float dz, cobra_depth_func func, bool write);
+
+// [checked][tiled * 2 + depth]
+static const bresenham_kernel bresenham_kernels[2][4] = {
+    {bresenham_inside_linear, bresenham_inside_linear_depth, bresenham_inside_tiled, bresenham_inside_tiled_depth},
+    {bresenham_checked_linear, bresenham_checked_linear_depth, bresenham_checked_tiled, bresenham_checked_tiled_depth},
+};
+
+void cobra_submit_line(cobra_surface *surf, int x0, int y0, int x1, int y1, uint32_t color,
+                       const cobra_line_depth *depth)
+{
+  if (surf->deferred)
+    cobra_surface_flush(surf);
+
+  int ox0 = x0, oy0 = y0, ox1 = x1, oy1 = y1;
+
+  COBRA_STAT_ADD(lines_submitted, 1);
+  // Applichiamo il clipping geometrico.
+  // Usiamo 0,0,w,h per clipping esatto, la funzione ora supporta "Guard Bands" (es. -10, -10, w+10, h+10)
+  if (!cohen_sutherland_clip(&x0, &y0, &x1, &y1, 0, 0, surf->width, surf->height)) {
+      COBRA_STAT_ADD(lines_clipped, 1);
+      return; // Linea completamente fuori
+  }
+  COBRA_SCOPE_BEGIN(scope, NULL, COBRA_TIMER_RASTER);
+
+  // Profondità: lineare nello schermo, quindi un incremento costante per passo.
+  // Ogni passo di Bresenham avanza di 1 sull'asse maggiore: i passi sono max(|dx|, |dy|).
+  float z = 0.0f, dz = 0.0f;
+  if (depth) {
+    cobra_line_depth d = *depth;
+    cobra_line_depth_clip(&d, (float)ox0, (float)oy0, (float)ox1, (float)oy1,
+                          (float)x0, (float)y0, (float)x1, (float)y1);
+    int steps = abs(x1 - x0) > abs(y1 - y0) ? abs(x1 - x0) : abs(y1 - y0);
+    z = d.z0;
+    dz = steps ? (d.z1 - d.z0) / (float)steps : 0.0f;
+  }
+
+  cobra_mark_dirty(surf, (float)(x0 < x1 ? x0 : x1), (float)(y0 < y1 ? y0 : y1),
+                   (float)(x0 > x1 ? x0 : x1), (float)(y0 > y1 ? y0 : y1));
+
+  // Dopo il clipping gli estremi sono quasi sempre dentro la superficie; i rari casi in cui
+  // l'arrotondamento delle intersezioni li lascia fuori usano la variante con bounds check
+  bool checked = (compute_outcode(x0, y0, 0, 0, surf->width, surf->height) |
+                  compute_outcode(x1, y1, 0, 0, surf->width, surf->height)) != 0;
+  bresenham_kernels[checked][(surf->tiled ? 2 : 0) + (depth ? 1 : 0)](
+      surf, x0, y0, x1, y1, color, z, dz, depth ? depth->func : COBRA_DEPTH_ALWAYS, depth && depth->write);
+  COBRA_SCOPE_END(scope);
+}
+
+// Versione float di compute_outcode branchless
+static inline int compute_outcode_f(float x, float y, float min_x, float min_y, float max_x, float max_y) {
+    return ((x < min_x) << 0) |
+           ((x >= max_x) << 1) |
+           ((y < min_y) << 2) |
+           ((y >= max_y) << 3);
+}
+
+// Helper per il clipping su un bordo specifico (Float)
+static inline void clip_to_edge_f(float *x, float *y, float x0, float y0, 
+                                   float x1, float y1, int edge_bit, 
+                                   float edge_coord) {
+    float dx = x1 - x0;
+    float dy = y1 - y0;
+    int is_vertical = edge_bit & 3;
+    
+    if (is_vertical) {
+        *x = edge_coord;
+        *y = (fabsf(dx) > 1e-6f) ? (y0 + dy * (edge_coord - x0) / dx) : y0;
+    } else {
+        *y = edge_coord;
+        *x = (fabsf(dy) > 1e-6f) ? (x0 + dx * (edge_coord - y0) / dy) : x0;
+    }
+}
+
+// Versione float di Cohen-Sutherland per l'Anti-Aliasing (Compact)
+static bool cohen_sutherland_clip_f(float *x0, float *y0, float *x1, float *y1, 
+                                    float min_x, float min_y, float max_x, float max_y) {
+    int outcode0 = compute_outcode_f(*x0, *y0, min_x, min_y, max_x, max_y);
+    int outcode1 = compute_outcode_f(*x1, *y1, min_x, min_y, max_x, max_y);
+
+    for (int iter = 0; iter < 4; iter++) {
+        if (!(outcode0 | outcode1)) {
+            return true;
+        }
+        if (outcode0 & outcode1) {
+            return false;
+        }
+
+        int code_out = outcode0 ? outcode0 : outcode1;
+        int bit = code_out & -code_out;
+        
+        float edges[4] = {min_x, max_x, min_y, max_y};
+        int edge_idx = __builtin_ctz(bit);
+        float edge_coord = edges[edge_idx];
+        
+        float x, y;
+        clip_to_edge_f(&x, &y, *x0, *y0, *x1, *y1, bit, edge_coord);
+        
+        float *px = (code_out == outcode0) ? x0 : x1;
+        float *py = (code_out == outcode0) ? y0 : y1;
+        *px = x; *py = y;
+        
+        if (code_out == outcode0)
+            outcode0 = compute_outcode_f(x, y, min_x, min_y, max_x, max_y);
+        else
+            outcode1 = compute_outcode_f(x, y, min_x, min_y, max_x, max_y);
+    }
+    return true;
+}
+
+bool cobra_clip_line_f(float *x0, float *y0, float *x1, float *y1,
+                       float min_x, float min_y, float max_x, float max_y)
+{
+  return cohen_sutherland_clip_f(x0, y0, x1, y1, min_x, min_y, max_x, max_y);
+}
+
+void cobra_window_draw_line_aa(cobra_surface *surf, float x0, float y0, float x1, float y1, float width, uint32_t color, cobra_aa_mode aa_mode)
+{
+  if (!surf) return;
+
+  cobra_submit_line_aa(surf, x0, y0, x1, y1, width, color, NULL, aa_mode);
+}
+
+void cobra_submit_line_aa(cobra_surface *surf, float x0, float y0, float x1, float y1, float width,
+                          uint32_t color, const cobra_line_depth *depth, cobra_aa_mode aa_mode)
+{
+  COBRA_STAT_ADD(lines_submitted, 1);
+  // In modalità differita la linea viene solo registrata e rasterizzata al flush
+  if (surf->deferred) {
+    cobra_deferred_record_line_aa(surf, x0, y0, x1, y1, width, color, depth, aa_mode);
+    return;
+  }
+
+  COBRA_SCOPE_BEGIN(scope, NULL, COBRA_TIMER_RASTER);
+  cobra_mark_dirty_line(surf, x0, y0, x1, y1, width);
+
+  cobra_blend blend;
+  cobra_blend_init(&blend, surf, color);
+  cobra_rect full = {0, 0, surf->width, surf->height};
+  if (!cobra_raster_line_aa(surf, &full, x0, y0, x1, y1, width, &blend, depth, aa_mode))
+    COBRA_STAT_ADD(lines_clipped, 1);
+  COBRA_SCOPE_END(scope);
+}
+
+bool cobra_raster_line_aa(cobra_surface *surf, const cobra_rect *clip,
+                          float x0, float y0, float x1, float y1, float width,
+                          const cobra_blend *blend, const cobra_line_depth *depth, cobra_aa_mode aa_mode)
+{
+  float ox0 = x0, oy0 = y0, ox1 = x1, oy1 = y1;
+
+  // --- GUARD BAND CLIPPING ---
+  // Usiamo una "Guard Band" (cornice di sicurezza) attorno allo schermo.
+  // Questo serve a:
+  // 1. Tagliare linee enormi (ottimizzazione)
+  // 2. Mantenere i "Caps" (punte arrotondate) fuori dalla vista, così non si vedono artefatti di taglio.
+  // Il margine deve essere almeno pari al raggio della linea + un extra.
+  float gb_margin = width * 0.5f + 2.0f;
+  
+  // La guard band è costruita attorno al rettangolo di clip (schermo intero o singolo tile)
+  if (!cohen_sutherland_clip_f(&x0, &y0, &x1, &y1, 
+                               (float)clip->x0 - gb_margin, (float)clip->y0 - gb_margin, 
+                               (float)clip->x1 + gb_margin, (float)clip->y1 + gb_margin)) {
+      return false; // Linea completamente fuori dalla Guard Band
+  }
+
+  // Ricalcoliamo i delta dopo il clipping (la geometria è cambiata)
+  float fdx = x1 - x0;
+  float fdy = y1 - y0;
+  float len_sq = fdx*fdx + fdy*fdy;
+  if (len_sq <= 0.0f) return false;
+
+  // Le profondità seguono gli estremi tagliati
+  cobra_line_depth clipped_depth;
+  if (depth) {
+    clipped_depth = *depth;
+    cobra_line_depth_clip(&clipped_depth, ox0, oy0, ox1, oy1, x0, y0, x1, y1);
+    depth = &clipped_depth;
+  }
+
+  cobra_raster_line_aa_clipped(surf, clip, x0, y0, x1, y1, len_sq, 1.0f / sqrtf(len_sq), width, blend, depth, aa_mode);
+  return true;
+}
+
+void cobra_raster_line_aa_clipped(cobra_surface *surf, const cobra_rect *clip,
+                                  float x0, float y0, float x1, float y1, float len_sq, float inv_len,
+                                  float width, const cobra_blend *blend, const cobra_line_depth *depth,
+                                  cobra_aa_mode aa_mode)
+{
+  // Linee sottili (< 1.0px) in modalità SDF: percorso dedicato a due pixel per passo con
+  // correzione percettiva (hairline.c). SS, LUT e BOX campionano la geometria reale.
+  if (aa_mode == COBRA_AA_SDF && width < 1.0f) {
+    cobra_raster_hairline(surf, clip, x0, y0, x1, y1, len_sq, inv_len, width, blend, depth);
+    return;
+  }
+
+  // Scan conversion della capsula (capsule.c), per colonne se la linea è ripida
+  cobra_capsule c;
+  cobra_capsule_init(&c, surf, x0, y0, x1, y1, len_sq, inv_len, width, blend, depth, aa_mode,
+                     fabsf(y1 - y0) > fabsf(x1 - x0));
+  cobra_capsule_raster(&c, clip);
+}
+
+static void draw_line_3d(cobra_surface *surf, cobra_vec3 p1, cobra_vec3 p2,
+                         float fov, float thickness, uint32_t color, bool aa, cobra_aa_mode aa_mode) {
+
+    // 1. Clipping 3D contro i 6 piani del frustum (near/far della superficie, lati dello
+    //    schermo allargati della guard band della linea): ciò che è fuori vista non viene proiettato
+    cobra_frustum frustum;
+    cobra_frustum_init(&frustum, surf, fov, (aa ? thickness : 1.0f) * 0.5f + 2.0f);
+
+    unsigned code1 = cobra_frustum_outcode(&frustum, p1.x, p1.y, p1.z);
+    unsigned code2 = cobra_frustum_outcode(&frustum, p2.x, p2.y, p2.z);
+    if ((code1 & code2) || // Trivial Reject: entrambi fuori dallo stesso piano
+        ((code1 | code2) && !cobra_frustum_clip_line(&frustum, &p1, &p2))) {
+        COBRA_STAT_ADD(lines_culled, 1);
+        return;
+    }
+
+    // 2. Proiezione (ora sicura perché z >= near_plane)
+    cobra_vec3 proj1 = cobra_vec3_project(p1, fov, (float)surf->width, (float)surf->height);
+    cobra_vec3 proj2 = cobra_vec3_project(p2, fov, (float)surf->width, (float)surf->height);
+
+    // 3. Profondità degli estremi tagliati (z >= near, quindi nell'intervallo 0..1)
+    cobra_line_depth depth;
+    const cobra_line_depth *dp = NULL;
+    if (cobra_depth_enabled(surf)) {
+        cobra_line_depth_init(&depth, surf, p1.z, p2.z);
+        dp = &depth;
+    }
+
+    // 4. Disegno 2D (il clipping schermo accetta subito: siamo già dentro la guard band)
+    if (aa) {
+        cobra_submit_line_aa(surf, proj1.x, proj1.y, proj2.x, proj2.y, thickness, color, dp, aa_mode);
+    } else {
+        cobra_submit_line(surf, (int)proj1.x, (int)proj1.y, (int)proj2.x, (int)proj2.y, color, dp);
+    }
+}
+
+void cobra_window_draw_line_3d(cobra_surface *surf, cobra_vec3 p1, cobra_vec3 p2,
+                               float fov, float thickness, uint32_t color, bool aa, cobra_aa_mode aa_mode)
+{
+  if (!surf)
+    return;
+
+  COBRA_SCOPE_BEGIN(scope, NULL, COBRA_TIMER_RASTER);
+  draw_line_3d(surf, p1, p2, fov, thickness, color, aa, aa_mode);
+  COBRA_SCOPE_END(scope);
+}
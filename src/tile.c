@@ -0,0 +1,192 @@
+// Layout a tile dei buffer della superficie.
+//
+// I tile di COBRA_FB_TILE x COBRA_FB_TILE pixel sono memorizzati per righe di tile e dentro
+// ogni tile i pixel sono per righe (cobra_pixel_index in internal.h). Una riga di tile è di
+// 8 pixel consecutivi: 32 byte, cioè un registro AVX2 o due SSE2. Il detile copia quindi una
+// riga di tile per istruzione e scrive ogni riga di destinazione in ordine, senza salti.
+// Il layout lineare resta il default: qui ci sono solo le conversioni e il riempimento.
+
+#include "cobragl/surface.h"
+#include "internal.h"
+#include "simd.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TILE_PIXELS (COBRA_FB_TILE * COBRA_FB_TILE)
+
+// Copia una riga di tile (COBRA_FB_TILE pixel consecutivi)
+static inline void copy_tile_row(uint32_t *dst, const uint32_t *src)
+{
+#ifdef COBRA_SIMD_LANES
+  for (int i = 0; i < COBRA_FB_TILE; i += COBRA_SIMD_LANES)
+    VI_STORE(dst + i, VI_LOAD(src + i));
+#else
+  memcpy(dst, src, COBRA_FB_TILE * sizeof(uint32_t));
+#endif
+}
+
+void cobra_detile(const uint32_t *src, int tiles_x, const cobra_rect *r, uint32_t *dst, int dst_pitch)
+{
+  const int mask = COBRA_FB_TILE - 1;
+  for (int y = r->y0; y < r->y1; y++) {
+    const uint32_t *tile_row = src + ((long)(y >> COBRA_FB_TILE_SHIFT) * tiles_x) * TILE_PIXELS +
+                               ((y & mask) << COBRA_FB_TILE_SHIFT);
+    uint32_t *out = dst + (long)(y - r->y0) * dst_pitch;
+    int x = r->x0;
+
+    // Tile iniziale parziale
+    if (x & mask) {
+      int end = (x | mask) + 1 < r->x1 ? (x | mask) + 1 : r->x1;
+      memcpy(out, tile_row + (long)(x >> COBRA_FB_TILE_SHIFT) * TILE_PIXELS + (x & mask),
+             (size_t)(end - x) * sizeof(uint32_t));
+      out += end - x;
+      x = end;
+    }
+    // Tile interi: una riga di tile per copia
+    for (; x + COBRA_FB_TILE <= r->x1; x += COBRA_FB_TILE, out += COBRA_FB_TILE)
+      copy_tile_row(out, tile_row + (long)(x >> COBRA_FB_TILE_SHIFT) * TILE_PIXELS);
+    // Tile finale parziale
+    if (x < r->x1)
+      memcpy(out, tile_row + (long)(x >> COBRA_FB_TILE_SHIFT) * TILE_PIXELS,
+             (size_t)(r->x1 - x) * sizeof(uint32_t));
+  }
+}
+
+// Inversa di cobra_detile su tutta la superficie (usata solo al cambio di layout)
+static void tile_from_linear(const cobra_surface *surf, uint32_t *dst, const uint32_t *src)
+{
+  int full = surf->width & ~(COBRA_FB_TILE - 1);
+  for (int y = 0; y < surf->height; y++) {
+    const uint32_t *in = src + (long)y * surf->width;
+    uint32_t *tile_row = dst + ((long)(y >> COBRA_FB_TILE_SHIFT) * surf->tiles_x) * TILE_PIXELS +
+                         ((y & (COBRA_FB_TILE - 1)) << COBRA_FB_TILE_SHIFT);
+    int x = 0;
+    for (; x < full; x += COBRA_FB_TILE)
+      copy_tile_row(tile_row + (long)(x >> COBRA_FB_TILE_SHIFT) * TILE_PIXELS, in + x);
+    if (x < surf->width)
+      memcpy(tile_row + (long)(x >> COBRA_FB_TILE_SHIFT) * TILE_PIXELS, in + x,
+             (size_t)(surf->width - x) * sizeof(uint32_t));
+  }
+}
+
+void cobra_tile_fill(const cobra_surface *surf, uint32_t *buffer, const cobra_rect *r, uint32_t value, bool stream)
+{
+  if (r->x0 >= r->x1 || r->y0 >= r->y1)
+    return;
+
+  const int mask = COBRA_FB_TILE - 1;
+  // Tile coperti per intero in orizzontale: [tx_in0, tx_in1). Il bordo della superficie conta
+  // come fine del tile: i pixel di riempimento non vengono mai letti, quindi si possono
+  // scrivere insieme agli altri pur di avere un'unica corsa contigua.
+  int tx_in0 = (r->x0 + mask) >> COBRA_FB_TILE_SHIFT;
+  int tx_in1 = (r->x1 == surf->width) ? surf->tiles_x : r->x1 >> COBRA_FB_TILE_SHIFT;
+
+  for (int ty = r->y0 >> COBRA_FB_TILE_SHIFT; ty <= (r->y1 - 1) >> COBRA_FB_TILE_SHIFT; ty++) {
+    int y0 = ty << COBRA_FB_TILE_SHIFT, y1 = y0 + COBRA_FB_TILE;
+    bool all_rows = r->y0 <= y0 && (r->y1 >= y1 || r->y1 == surf->height);
+    if (y0 < r->y0) y0 = r->y0;
+    if (y1 > r->y1) y1 = r->y1;
+    uint32_t *tiles = buffer + (long)ty * surf->tiles_x * TILE_PIXELS;
+
+    // Tile interi consecutivi: un'unica corsa contigua
+    if (all_rows && tx_in0 < tx_in1)
+      cobra_span_fill(tiles + (long)tx_in0 * TILE_PIXELS, (long)(tx_in1 - tx_in0) * TILE_PIXELS, value, stream);
+
+    // Il resto riga per riga, un segmento per tile
+    for (int y = y0; y < y1; y++) {
+      uint32_t *row = tiles + ((y & mask) << COBRA_FB_TILE_SHIFT);
+      for (int x = r->x0; x < r->x1;) {
+        int tx = x >> COBRA_FB_TILE_SHIFT;
+        int end = (tx + 1) << COBRA_FB_TILE_SHIFT;
+        if (end > r->x1) end = r->x1;
+        if (all_rows && tx >= tx_in0 && tx < tx_in1) {
+          x = tx_in1 << COBRA_FB_TILE_SHIFT;
+          continue;
+        }
+        cobra_span_fill(row + (long)tx * TILE_PIXELS + (x & mask), end - x, value, false);
+        x = end;
+      }
+    }
+  }
+}
+
+// Converte un buffer nel nuovo layout (surf->tiled è già quello di destinazione)
+static uint32_t *convert_buffer(const cobra_surface *surf, uint32_t *old)
+{
+  uint32_t *buf = (uint32_t *)malloc(sizeof(uint32_t) * cobra_buffer_pixels(surf));
+  if (!buf)
+    return NULL;
+  if (surf->tiled) {
+    tile_from_linear(surf, buf, old);
+  } else {
+    cobra_rect full = {0, 0, surf->width, surf->height};
+    cobra_detile(old, surf->tiles_x, &full, buf, surf->width);
+  }
+  return buf;
+}
+
+bool cobra_surface_set_tiled(cobra_surface *surf, bool tiled)
+{
+  if (!surf || !surf->buffer_count)
+    return false;
+  if (surf->tiled == tiled)
+    return true;
+  // Il present asincrono potrebbe star copiando uno dei buffer da convertire e liberare
+  if (surf->buffers_shared)
+    return false;
+  // In zero-copy color_buffer punta alla texture (sempre lineare)
+  if (surf->color_buffer != surf->color_buffers[surf->draw_buffer])
+    return false;
+
+  // Le linee differite vanno scritte nel layout in cui sono state registrate
+  cobra_surface_flush(surf);
+
+  uint32_t *converted[COBRA_MAX_BUFFERS + 1] = {NULL};
+  uint32_t *old[COBRA_MAX_BUFFERS + 1];
+  int n = surf->buffer_count;
+  for (int i = 0; i < n; i++)
+    old[i] = surf->color_buffers[i];
+  old[n] = (uint32_t *)surf->z_buffer;
+
+  surf->tiled = tiled;
+  for (int i = 0; i <= n; i++) {
+    converted[i] = convert_buffer(surf, old[i]);
+    if (!converted[i]) {
+      for (int j = 0; j < i; j++)
+        free(converted[j]);
+      surf->tiled = !tiled;
+      return false;
+    }
+  }
+
+  for (int i = 0; i <= n; i++)
+    free(old[i]);
+  for (int i = 0; i < n; i++)
+    surf->color_buffers[i] = converted[i];
+  surf->z_buffer = (float *)converted[n];
+  surf->color_buffer = surf->color_buffers[surf->draw_buffer];
+  return true;
+}
+
+void cobra_surface_read_color(const cobra_surface *surf, const cobra_rect *r, uint32_t *dst, int dst_pitch)
+{
+  if (!surf || !dst || !surf->color_buffer)
+    return;
+
+  cobra_rect full = {0, 0, surf->width, surf->height};
+  cobra_rect rect = r ? *r : full;
+  if (rect.x0 < 0) rect.x0 = 0;
+  if (rect.y0 < 0) rect.y0 = 0;
+  if (rect.x1 > surf->width) rect.x1 = surf->width;
+  if (rect.y1 > surf->height) rect.y1 = surf->height;
+  if (rect.x0 >= rect.x1 || rect.y0 >= rect.y1)
+    return;
+
+  if (surf->tiled) {
+    cobra_detile(surf->color_buffer, surf->tiles_x, &rect, dst, dst_pitch);
+    return;
+  }
+  for (int y = rect.y0; y < rect.y1; y++)
+    memcpy(dst + (long)(y - rect.y0) * dst_pitch, surf->color_buffer + (long)y * surf->width + rect.x0,
+           (size_t)(rect.x1 - rect.x0) * sizeof(uint32_t));
+}
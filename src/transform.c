@@ -0,0 +1,17 @@
+// Trasformazione a batch di vertici in formato structure-of-arrays.
+//
+// Il kernel (una matrice applicata a COBRA_SIMD_LANES vertici per iterazione) sta in
+// isa/kernels.c ed è compilato per ogni set di istruzioni: qui restano i controlli
+// sugli argomenti e la chiamata alla variante scelta da dispatch.c.
+
+#include "cobragl/math.h"
+#include "internal.h"
+
+void cobra_transform_points(const cobra_mat4 *m, const c_float *x, const c_float *y, const c_float *z,
+                            c_float *out_x, c_float *out_y, c_float *out_z, c_float *out_w, int count)
+{
+  if (!m || !x || !y || !z || !out_x || !out_y || !out_z || count <= 0)
+    return;
+
+  COBRA_KERNEL(transform_points)(m, x, y, z, out_x, out_y, out_z, out_w, count);
+}
@@ -0,0 +1,200 @@
+// Rasterizzatore di triangoli pieni a semispazi (edge function).
+//
+// I vertici vengono portati in virgola fissa con TRI_SUB_BITS bit di subpixel: i test
+// "dentro/fuori" sono interi ed esatti, quindi due triangoli che condividono un lato non
+// lasciano buchi né disegnano due volte lo stesso pixel (regola top-left).
+//
+// Lo schermo viene attraversato a blocchi di 8x8 pixel dentro il bounding box:
+//   - se un blocco è tutto fuori da un lato viene scartato senza toccare i pixel
+//   - se è tutto dentro i tre lati viene riempito senza test di copertura
+//   - altrimenti i lati che lo attraversano vengono valutati su più pixel alla volta (SIMD)
+// Dentro un blocco attraversato da un lato l'edge function è piccola (al più 8 pixel di
+// distanza dal lato) e sta in 32 bit; i lati già accettati per il blocco non vengono valutati.
+//
+// La profondità (cobra_depth_from_z) è lineare nello schermo: la interpoliamo con un piano
+// z = z0 + dz/dx * x + dz/dy * y, corretto in prospettiva senza divisioni per pixel.
+//
+// L'attraversamento dei blocchi sta in isa/triangle.c (una versione per set di istruzioni):
+// qui restano la virgola fissa, il setup dei lati e il piano della profondità.
+
+#include "internal.h"
+#include <math.h>
+#include <stdint.h>
+
+#define TRI_SUB_BITS 4
+#define TRI_SUB (1 << TRI_SUB_BITS)
+
+// Oltre questo valore (in pixel) la virgola fissa non è più sicura: il chiamante deve tagliare
+#define TRI_MAX_COORD 65536.0f
+
+// Lato i -> j. Con i vertici in senso orario sullo schermo (Y verso il basso) l'interno
+// è dove E > 0. I lati che non sono "top" o "left" escludono i pixel esattamente sul lato.
+static void edge_setup(cobra_tri_edge *e, int64_t xi, int64_t yi, int64_t xj, int64_t yj)
+{
+  int64_t dx = xj - xi, dy = yj - yi;
+  // E(P) = dx * (Py - yi) - dy * (Px - xi), con P = (px, py) * TRI_SUB + TRI_SUB/2
+  e->a = -dy * TRI_SUB;
+  e->b = dx * TRI_SUB;
+  e->c = dx * (TRI_SUB / 2 - yi) - dy * (TRI_SUB / 2 - xi);
+  bool top_left = (dy < 0) || (dy == 0 && dx > 0);
+  if (!top_left)
+    e->c -= 1;
+}
+
+void cobra_raster_triangle(cobra_surface *surf, const float *x, const float *y, const float *z,
+                           const cobra_blend *blend)
+{
+  COBRA_STAT_ADD(triangles_submitted, 1);
+  for (int i = 0; i < 3; i++) {
+    if (!(fabsf(x[i]) < TRI_MAX_COORD && fabsf(y[i]) < TRI_MAX_COORD))
+      return;
+  }
+
+  // Vertici in virgola fissa (arrotondati al subpixel)
+  int64_t fx[3], fy[3];
+  for (int i = 0; i < 3; i++) {
+    fx[i] = (int64_t)floorf(x[i] * TRI_SUB + 0.5f);
+    fy[i] = (int64_t)floorf(y[i] * TRI_SUB + 0.5f);
+  }
+
+  // Orientamento: area con segno (positiva in senso orario sullo schermo)
+  int64_t area = (fx[1] - fx[0]) * (fy[2] - fy[0]) - (fy[1] - fy[0]) * (fx[2] - fx[0]);
+  if (area == 0)
+    return;
+  int i1 = 1, i2 = 2;
+  if (area < 0) {
+    i1 = 2;
+    i2 = 1;
+    area = -area;
+  }
+
+  // Bounding box dei centri dei pixel, limitato alla superficie
+  int64_t min_fx = fx[0], max_fx = fx[0], min_fy = fy[0], max_fy = fy[0];
+  for (int i = 1; i < 3; i++) {
+    if (fx[i] < min_fx) min_fx = fx[i];
+    if (fx[i] > max_fx) max_fx = fx[i];
+    if (fy[i] < min_fy) min_fy = fy[i];
+    if (fy[i] > max_fy) max_fy = fy[i];
+  }
+  int x_min = (int)((min_fx - TRI_SUB / 2 + TRI_SUB - 1) >> TRI_SUB_BITS);
+  int y_min = (int)((min_fy - TRI_SUB / 2 + TRI_SUB - 1) >> TRI_SUB_BITS);
+  int x_max = (int)((max_fx - TRI_SUB / 2) >> TRI_SUB_BITS);
+  int y_max = (int)((max_fy - TRI_SUB / 2) >> TRI_SUB_BITS);
+  if (x_min < 0) x_min = 0;
+  if (y_min < 0) y_min = 0;
+  if (x_max > surf->width - 1) x_max = surf->width - 1;
+  if (y_max > surf->height - 1) y_max = surf->height - 1;
+  if (x_min > x_max || y_min > y_max)
+    return;
+
+  cobra_tri_setup t;
+  edge_setup(&t.e[0], fx[0], fy[0], fx[i1], fy[i1]);
+  edge_setup(&t.e[1], fx[i1], fy[i1], fx[i2], fy[i2]);
+  edge_setup(&t.e[2], fx[i2], fy[i2], fx[0], fy[0]);
+  t.blend = *blend;
+  t.depth_func = surf->depth_func;
+  t.depth_write = surf->depth_write;
+
+  // Piano della profondità sui vertici arrotondati (stesse posizioni dei test di copertura)
+  t.z0 = t.dzdx = t.dzdy = 0.0f;
+  if (z) {
+    float vx0 = (float)fx[0] / TRI_SUB, vy0 = (float)fy[0] / TRI_SUB;
+    float ax = (float)fx[1] / TRI_SUB - vx0, ay = (float)fy[1] / TRI_SUB - vy0;
+    float bx = (float)fx[2] / TRI_SUB - vx0, by = (float)fy[2] / TRI_SUB - vy0;
+    float az = z[1] - z[0], bz = z[2] - z[0];
+    float inv_det = 1.0f / (ax * by - ay * bx);
+    t.dzdx = (az * by - ay * bz) * inv_det;
+    t.dzdy = (ax * bz - az * bx) * inv_det;
+    // z al centro del pixel (0, 0)
+    t.z0 = z[0] + t.dzdx * (0.5f - vx0) + t.dzdy * (0.5f - vy0);
+  }
+
+  cobra_mark_dirty(surf, (float)x_min, (float)y_min, (float)x_max, (float)y_max);
+
+  // Modalità di blending e profondità risolte una volta per triangolo
+  int mode = blend->mode == COBRA_BLEND_ADDITIVE ? 1 : (blend->mode == COBRA_BLEND_MAX ? 2 : 0);
+  COBRA_KERNEL(tri_kernels)[mode][z != NULL](surf, &t, x_min, y_min, x_max, y_max);
+}
+
+void cobra_raster_triangle_3d(cobra_surface *surf, const cobra_frustum *f, const cobra_vec3 *v,
+                              const cobra_blend *blend, bool depth)
+{
+  cobra_vec3 poly[COBRA_CLIP_POLYGON_MAX];
+  int n = cobra_frustum_clip_polygon(f, v, 3, poly);
+  if (n < 3) {
+    COBRA_STAT_ADD(triangles_culled, 1);
+    return;
+  }
+
+  // Proiezione dei vertici tagliati (stessa formula di cobra_vec3_project)
+  const float half_w = (float)surf->width * 0.5f;
+  const float half_h = (float)surf->height * 0.5f;
+  float sx[COBRA_CLIP_POLYGON_MAX], sy[COBRA_CLIP_POLYGON_MAX], sz[COBRA_CLIP_POLYGON_MAX];
+  for (int i = 0; i < n; i++) {
+    float inv_z = 1.0f / poly[i].z;
+    sx[i] = poly[i].x * f->fov * inv_z + half_w;
+    sy[i] = -poly[i].y * f->fov * inv_z + half_h;
+    sz[i] = depth ? cobra_depth_from_z(surf, poly[i].z) : 0.0f;
+  }
+
+  // Il poligono tagliato è convesso: lo disegniamo a ventaglio dal primo vertice
+  for (int i = 1; i + 1 < n; i++) {
+    float x[3] = {sx[0], sx[i], sx[i + 1]};
+    float y[3] = {sy[0], sy[i], sy[i + 1]};
+    float z[3] = {sz[0], sz[i], sz[i + 1]};
+    cobra_raster_triangle(surf, x, y, depth ? z : NULL, blend);
+  }
+}
+
+static void draw_triangle(cobra_surface *surf, cobra_vec3 p0, cobra_vec3 p1, cobra_vec3 p2,
+                          float fov, uint32_t color)
+{
+  // Le primitive immediate devono comparire sopra le linee differite già registrate
+  if (surf->deferred)
+    cobra_surface_flush(surf);
+
+  cobra_frustum frustum;
+  cobra_frustum_init(&frustum, surf, fov, cobra_triangle_guard(surf));
+  unsigned c0 = cobra_frustum_outcode(&frustum, p0.x, p0.y, p0.z);
+  unsigned c1 = cobra_frustum_outcode(&frustum, p1.x, p1.y, p1.z);
+  unsigned c2 = cobra_frustum_outcode(&frustum, p2.x, p2.y, p2.z);
+  if (c0 & c1 & c2) {
+    COBRA_STAT_ADD(triangles_culled, 1);
+    return; // tutti i vertici fuori dallo stesso piano
+  }
+
+  cobra_blend blend;
+  cobra_blend_init(&blend, surf, color);
+  bool depth = cobra_depth_enabled(surf);
+
+  if (c0 | c1 | c2) {
+    cobra_vec3 v[3] = {p0, p1, p2};
+    cobra_raster_triangle_3d(surf, &frustum, v, &blend, depth);
+    return;
+  }
+
+  // Tutto dentro la guard band: proiezione diretta
+  cobra_vec3 s0 = cobra_vec3_project(p0, fov, (float)surf->width, (float)surf->height);
+  cobra_vec3 s1 = cobra_vec3_project(p1, fov, (float)surf->width, (float)surf->height);
+  cobra_vec3 s2 = cobra_vec3_project(p2, fov, (float)surf->width, (float)surf->height);
+  float x[3] = {s0.x, s1.x, s2.x};
+  float y[3] = {s0.y, s1.y, s2.y};
+  float z[3] = {0.0f, 0.0f, 0.0f};
+  if (depth) {
+    z[0] = cobra_depth_from_z(surf, p0.z);
+    z[1] = cobra_depth_from_z(surf, p1.z);
+    z[2] = cobra_depth_from_z(surf, p2.z);
+  }
+  cobra_raster_triangle(surf, x, y, depth ? z : NULL, &blend);
+}
+
+void cobra_window_draw_triangle(cobra_surface *surf, cobra_vec3 p0, cobra_vec3 p1, cobra_vec3 p2,
+                                float fov, uint32_t color)
+{
+  if (!surf)
+    return;
+
+  COBRA_SCOPE_BEGIN(scope, NULL, COBRA_TIMER_RASTER);
+  draw_triangle(surf, p0, p1, p2, fov, color);
+  COBRA_SCOPE_END(scope);
+}